@@ -0,0 +1,93 @@
+<#
+.SYNOPSIS
+Runs a benchmark program with different executor counts and reports the execution time, the throughput
+and the executor wakeup statistics of each run.
+
+.DESCRIPTION
+The program is translated once, then run Repeats times for every executors count. The execution module logs
+how long the executors ran ("All executors have finished..."), so loading and translating the program are not measured.
+Executors also log their wakeup statistics when they shut down, the script sums them up over all executors.
+The best run of every executors count is reported, the others only show how noisy the machine is.
+
+Environment variables of the current session are passed to fsi-mediator, so set e.g. FSI_HUGE_PAGES before running
+the script to compare configurations. FSI_LOG_LEVEL is overridden, so that only the needed lines are logged.
+
+.EXAMPLE
+.\run-benchmark.ps1 -Source .\resource-contention.tfsi -Operations 6400000
+.\run-benchmark.ps1 -Source .\deep-recursion.tfsi -Operations 10010000 -Executors 1
+$env:FSI_HUGE_PAGES = 1; .\run-benchmark.ps1 -Source .\huge-pages.tfsi -Operations 4096000
+#>
+param(
+    # Path to the .tfsi program.
+    [Parameter(Mandatory = $true)]
+    [string] $Source,
+
+    # The number of operations the program performs, used to compute ops/s. Every example states its own count.
+    [uint64] $Operations = 0,
+
+    [int[]] $Executors = @(1, 2, 4, 8, 16, 32, 64),
+    [int] $Repeats = 3,
+    [string] $Bin = (Join-Path $PSScriptRoot "..\bin")
+)
+
+$translator = Join-Path $Bin "fsi-translator.exe"
+$mediator = Join-Path $Bin "fsi-mediator.exe"
+$modules = Join-Path $Bin "engine.mods"
+$binary = Join-Path ([System.IO.Path]::GetTempPath()) ([System.IO.Path]::GetFileNameWithoutExtension($Source) + ".bfsi")
+
+& $translator $Source $binary no-debug | Out-Null
+if ($LASTEXITCODE -ne 0) {
+    throw "Failed to translate $Source."
+}
+
+$previousLogLevel = $env:FSI_LOG_LEVEL
+$env:FSI_LOG_LEVEL = "warning;EXECUTION MODULE (CORE)=info"
+
+try {
+    $results = foreach ($executorsCount in $Executors) {
+        $runs = for ($repeat = 0; $repeat -lt $Repeats; ++$repeat) {
+            # The log goes to stderr, the output of the program itself is not needed.
+            $log = & $mediator $modules $executorsCount $binary 2>&1 | ForEach-Object { "$_" }
+
+            $elapsed = $log | Select-String "All executors have finished\. Count: \d+\. Elapsed time: (\d+)" | Select-Object -Last 1
+            if ($null -eq $elapsed) {
+                throw "fsi-mediator did not report the execution time with $executorsCount executor(s):`n$($log -join "`n")"
+            }
+
+            $wakeups = 0
+            $spuriousWakeups = 0
+            $totalLatency = 0.0
+            foreach ($statistics in ($log | Select-String "Wakeups: (\d+), spurious wakeups: (\d+), average wakeup latency: (\d+)")) {
+                $executorWakeups = [uint64] $statistics.Matches[0].Groups[1].Value
+                $wakeups += $executorWakeups
+                $spuriousWakeups += [uint64] $statistics.Matches[0].Groups[2].Value
+                $totalLatency += $executorWakeups * [double] $statistics.Matches[0].Groups[3].Value
+            }
+
+            [pscustomobject]@{
+                Microseconds = [uint64] $elapsed.Matches[0].Groups[1].Value
+                Wakeups = $wakeups
+                SpuriousWakeups = $spuriousWakeups
+                AverageLatency = if ($wakeups -ne 0) { $totalLatency / $wakeups } else { 0 }
+            }
+        }
+
+        $best = $runs | Sort-Object Microseconds | Select-Object -First 1
+        $worst = $runs | Sort-Object Microseconds | Select-Object -Last 1
+        [pscustomobject]@{
+            "Executors" = $executorsCount
+            "Best, ms" = [math]::Round($best.Microseconds / 1000.0, 1)
+            "Worst, ms" = [math]::Round($worst.Microseconds / 1000.0, 1)
+            "Ops/s" = if ($Operations -ne 0) { [math]::Round($Operations / ($best.Microseconds / 1000000.0)) } else { "-" }
+            "Wakeups" = $best.Wakeups
+            "Spurious" = $best.SpuriousWakeups
+            "Wakeup latency, us" = [math]::Round($best.AverageLatency, 1)
+        }
+    }
+
+    $results | Format-Table -AutoSize
+}
+finally {
+    $env:FSI_LOG_LEVEL = $previousLogLevel
+    Remove-Item $binary -ErrorAction SilentlyContinue
+}
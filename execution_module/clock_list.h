@@ -112,6 +112,21 @@ T* get_current() const noexcept {
         this->hand = this->hand->next;
     }
 
+    // Moves the hand to the first element (starting from the current one) that satisfies the predicate.
+    // At most "max_steps" elements are checked. The hand stays where it was if there is no such element.
+    template<typename predicate_type>
+    void step_to_first(predicate_type predicate, std::size_t max_steps) {
+        list_element* current = this->hand;
+        for (std::size_t step = 0; step < max_steps && step < this->elements_count; ++step) {
+            if (predicate(current->object)) {
+                this->hand = current;
+                return;
+            }
+
+            current = current->next;
+        }
+    }
+
     std::size_t get_elements_count() const noexcept { return this->elements_count; }
 };
 
@@ -28,16 +28,18 @@ PUBLIC CONTROL_CODE_TEMPLATE_PROGRAM_END_TRAMPOLINE_SIZE
 
 PUBLIC CONTROL_CODE_TEMPLATE_LOAD_EXECUTION_THREAD_CONTEXT_SWITCH_POINT 
 PUBLIC CONTROL_CODE_TEMPLATE_RESUME_PROGRAM_EXECUTION_CONTEXT_SWITCH_POINT 
+PUBLIC CONTROL_CODE_TEMPLATE_PROGRAM_TERMINATION_POINT
 
 USER_PROGRAM_COMPARISON_STATE_DISPLACEMENT              EQU 0
 USER_PROGRAM_RETURN_ADDRESS_DISPLACEMENT                EQU 8
 USER_PROGRAM_JUMP_TABLE_DISPLACEMENT                    EQU 16
 USER_PROGRAM_MY_STATE_ADDRESS_DISPLACEMENT              EQU 24
 USER_PROGRAM_CURRENT_STACK_POSITION_DISPLACEMENT        EQU 32
-USER_PROGRAM_STACK_END_DISPLACEMENT                     EQU 40
+USER_PROGRAM_SAVED_VARIABLE_ADDRESS_DISPLACEMENT        EQU 40
 USER_PROGRAM_CONTROL_FUNCTIONS_DISPLACEMENT             EQU 48
 USER_PROGRAM_EXECUTOR_FRAME_STACK_TOP_DISPLACEMENT      EQU 56
 USER_PROGRAM_EXECUTOR_FRAME_REGISTER_VALUE_DISPLACEMENT EQU 64
+USER_PROGRAM_STACK_END_DISPLACEMENT                     EQU 72
 
 FRAME_POINTER_DISPLACEMENT EQU 0h
 FRAME_POINTER_REGISTER     EQU r13
@@ -210,7 +212,7 @@ ENDIF
     mov r11, [rdx + USER_PROGRAM_JUMP_TABLE_DISPLACEMENT]
     mov rcx, [rdx + USER_PROGRAM_MY_STATE_ADDRESS_DISPLACEMENT]
     mov rbp, [rdx + USER_PROGRAM_CURRENT_STACK_POSITION_DISPLACEMENT]
-    mov r9,  [rdx + USER_PROGRAM_STACK_END_DISPLACEMENT]
+    mov r9,  [rdx + USER_PROGRAM_SAVED_VARIABLE_ADDRESS_DISPLACEMENT]
     mov r10, [rdx + USER_PROGRAM_CONTROL_FUNCTIONS_DISPLACEMENT]
     mov [rdx + USER_PROGRAM_EXECUTOR_FRAME_STACK_TOP_DISPLACEMENT],      rsp
     mov [rdx + USER_PROGRAM_EXECUTOR_FRAME_REGISTER_VALUE_DISPLACEMENT], FRAME_POINTER_REGISTER
@@ -317,7 +319,7 @@ CONTROL_CODE_TEMPLATE_CALL_MODULE_TRAMPOLINE PROC
     mov [rcx + USER_PROGRAM_RETURN_ADDRESS_DISPLACEMENT],         r14
 
     mov [rcx + USER_PROGRAM_CURRENT_STACK_POSITION_DISPLACEMENT], rbp 
-    mov [rcx + USER_PROGRAM_STACK_END_DISPLACEMENT],              r9 
+    mov [rcx + USER_PROGRAM_SAVED_VARIABLE_ADDRESS_DISPLACEMENT], r9 
 
     ; Prepare address for the fake frame to be used when calling into "call_module".
     lea r14, [CONTROL_CODE_TEMPLATE_CALL_MODULE_TRAMPOLINE_FAKE_FRAME]
@@ -368,7 +370,7 @@ CONTROL_CODE_TEMPLATE_RESUME_PROGRAM_EXECUTION PROC
     mov r11, [rcx + USER_PROGRAM_JUMP_TABLE_DISPLACEMENT]
     mov rcx, [rcx + USER_PROGRAM_MY_STATE_ADDRESS_DISPLACEMENT]
     mov rbp, [rcx + USER_PROGRAM_CURRENT_STACK_POSITION_DISPLACEMENT]
-    mov r9,  [rcx + USER_PROGRAM_STACK_END_DISPLACEMENT]
+    mov r9,  [rcx + USER_PROGRAM_SAVED_VARIABLE_ADDRESS_DISPLACEMENT]
     mov r10, [rcx + USER_PROGRAM_CONTROL_FUNCTIONS_DISPLACEMENT]
 
     jmp qword ptr [rcx + USER_PROGRAM_RETURN_ADDRESS_DISPLACEMENT]
@@ -381,6 +383,10 @@ CONTROL_CODE_TEMPLATE_PROGRAM_END_TRAMPOLINE PROC
     ; Set error code value to zero.
     xor rcx, rcx
 
+    ; Stack overflows caught by the guard region handler (see runtime_traps.cpp) continue from here, with the error code in RCX.
+    ; Unwind info of the trampoline doesn't depend on RSP, so the frames stay continuous for the debugger and SEH.
+    CONTROL_CODE_TEMPLATE_PROGRAM_TERMINATION_POINT LABEL PTR
+
     ; In our case, no specific set up is required. Just call the trap function.
     ; Shadow space was already set up by the "LOAD_PROGRAM" function.
     call qword ptr [r10 + CONTROL_FUNCTIONS_PROGRAM_TERMINATION_DISPLACEMENT]
@@ -61,6 +61,7 @@ extern "C" {
 
     extern char CONTROL_CODE_TEMPLATE_CALL_MODULE_TRAMPOLINE[1];
     extern char CONTROL_CODE_TEMPLATE_PROGRAM_END_TRAMPOLINE[1];
+    extern char CONTROL_CODE_TEMPLATE_PROGRAM_TERMINATION_POINT[1];
     extern char CONTROL_CODE_TEMPLATE_LOAD_EXECUTION_THREAD_CONTEXT_SWITCH_POINT[1];
     extern char CONTROL_CODE_TEMPLATE_RESUME_PROGRAM_EXECUTION_CONTEXT_SWITCH_POINT[1];
 }
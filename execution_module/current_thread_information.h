@@ -0,0 +1,21 @@
+#ifndef EXECUTION_MODULE_CURRENT_THREAD_INFORMATION_H
+#define EXECUTION_MODULE_CURRENT_THREAD_INFORMATION_H
+
+#include <cstdint>
+
+// Ids of the program thread that an executor is running. Every system thread has its own copy,
+// the execution module rewrites it on every context switch.
+// Other modules get its address through "get_current_thread_information" and read it directly,
+// which is much cheaper than calling "get_current_thread_id", "get_current_thread_group_id"
+// and "get_thread_saved_variable" each time.
+// All fields are zero if the system thread has never run a program thread.
+struct current_thread_information {
+    std::uint64_t thread_id{};
+    std::uint64_t thread_group_id{};
+
+    // Saved variable of the thread (8 bytes of value followed by 1 byte of type), the same address "get_thread_saved_variable" returns.
+    // It stays in place for the whole life of the thread.
+    unsigned char* saved_variable{};
+};
+
+#endif // !EXECUTION_MODULE_CURRENT_THREAD_INFORMATION_H
@@ -34,20 +34,8 @@ namespace backend {
         module_mediator::return_value thread_id = thread_structure->currently_running_thread_information.thread_id;
         module_mediator::return_value thread_group_id = thread_structure->currently_running_thread_information.thread_group_id;
         void* thread_state = thread_structure->currently_running_thread_information.thread_state;
-        std::uint64_t preferred_stack_size = thread_structure->currently_running_thread_information.preferred_stack_size;
-
-        program_state_manager program_state_manager{
-            static_cast<char*>(thread_state)
-        };
-
-        module_mediator::fast_call<module_mediator::return_value, module_mediator::memory>(
-            interoperation::get_module_part(),
-            interoperation::index_getter::resource_module(),
-            interoperation::index_getter::resource_module_deallocate_thread_memory(),
-            thread_id,
-            std::bit_cast<void*>(program_state_manager.get_stack_start(preferred_stack_size))
-        );
 
+        // Thread stack lives in the same block as the thread state (see on_thread_creation).
         module_mediator::fast_call<module_mediator::return_value, module_mediator::memory>(
             interoperation::get_module_part(),
             interoperation::index_getter::resource_module(),
@@ -167,6 +155,28 @@ namespace backend {
             ));
     }
 
+    char* allocate_thread_stack(module_mediator::return_value thread_id, std::uint64_t size) {
+        return std::bit_cast<char*>(
+            module_mediator::fast_call<module_mediator::return_value, module_mediator::eight_bytes>(
+                interoperation::get_module_part(),
+                interoperation::index_getter::resource_module(),
+                interoperation::index_getter::resource_module_allocate_thread_stack(),
+                thread_id,
+                size
+            ));
+    }
+
+    std::uint64_t get_stack_guard_size() {
+        // It doesn't change after the resource module is initialized.
+        static std::uint64_t guard_size = module_mediator::fast_call(
+            interoperation::get_module_part(),
+            interoperation::index_getter::resource_module(),
+            interoperation::index_getter::resource_module_get_stack_guard_size()
+        );
+
+        return guard_size;
+    }
+
     module_mediator::return_value check_function_signature(void* function_address, module_mediator::arguments_string_type initializer) {
         std::unique_ptr<module_mediator::arguments_string_element[]> default_signature{ module_mediator::arguments_string_builder::get_types_string() };
         module_mediator::arguments_string_type alleged_signature = default_signature.get();
@@ -243,10 +253,8 @@ namespace backend {
                 if (verification_result == module_mediator::module_failure) {
                     LOG_PROGRAM_ERROR(
                         interoperation::get_module_part(), 
-                        std::format(
-                            "Thread memory verification failed for address {}.",
-                            reinterpret_cast<std::uintptr_t>(old_descriptor_address)
-                        )
+                        "Thread memory verification failed for address {}.",
+                        reinterpret_cast<std::uintptr_t>(old_descriptor_address)
                     );
 
                     return reinterpret_cast<std::uintptr_t>(nullptr);
@@ -63,6 +63,15 @@ namespace backend {
         std::uint64_t size
     );
 
+    // Thread state and stack block, see on_thread_creation. The end of the block is followed by a guard region, if there is one.
+    char* allocate_thread_stack(
+        module_mediator::return_value thread_id, 
+        std::uint64_t size
+    );
+
+    // Size of the inaccessible region that follows every thread stack, zero if stacks don't have it.
+    std::uint64_t get_stack_guard_size();
+
     module_mediator::return_value check_function_signature(
         void* function_address, 
         module_mediator::arguments_string_type initializer
@@ -12,24 +12,55 @@
 #include "../program_loader/program_functions.h"
 #include "../logger_module/logging.h"
 
+namespace {
+    // Undoes the creation of a thread that never ran, its memory must already be freed.
+    // The thread group goes away with it if this was its only thread.
+    void discard_created_thread(module_mediator::return_value thread_id) {
+        module_mediator::return_value container_id = backend::deallocate_thread(thread_id);
+        if (backend::get_container_running_threads_count(container_id) == 0) {
+            backend::get_thread_manager().forget_thread_group(container_id);
+            backend::deallocate_program_container(container_id);
+        }
+    }
+}
+
 module_mediator::return_value on_thread_creation(module_mediator::arguments_string_type bundle) {
     constexpr std::uint64_t program_start_function_index = 1;
     constexpr std::uint64_t program_jump_table_address_index = 2;
     constexpr std::uint64_t thread_state_address_index = 3;
     constexpr std::uint64_t current_stack_position_index = 4;
-    constexpr std::uint64_t stack_end_position_index = 5;
+    constexpr std::uint64_t saved_variable_address_index = 5;
     constexpr std::uint64_t trap_table_address_index = 6;
+    constexpr std::uint64_t stack_end_position_index = 9;
 
     auto [container_id, thread_id, preferred_stack_size] =
         module_mediator::arguments_string_builder::unpack<module_mediator::return_value, module_mediator::return_value, std::uint64_t>(bundle);
 
     thread_local_structure* thread_structure = backend::get_thread_local_structure();
 
-    char* thread_state_memory = backend::allocate_thread_memory(thread_id, program_state_manager::thread_state_size);
-    char* thread_stack_memory = backend::allocate_thread_memory(thread_id, preferred_stack_size);
-    
-    // One byte + eight bytes are reserved to be used with "save" and "load" instructions.
-    char* thread_stack_end = thread_stack_memory + preferred_stack_size - (sizeof(module_mediator::one_byte) + sizeof(std::uint64_t));
+    // Thread state and stack share one block, so a thread costs one allocation, and the resource module
+    // can hand out the same block to the next thread of this group once this one is gone.
+    // The block is followed by a guard region (see get_stack_guard_size), its size is rounded so that nothing is left between them.
+    std::uint64_t thread_block_size = 
+        (program_state_manager::thread_state_area_size + preferred_stack_size + 15) & ~static_cast<std::uint64_t>(15);
+
+    char* thread_state_memory = backend::allocate_thread_stack(thread_id, thread_block_size);
+    if (thread_state_memory == nullptr) {
+        delete[] thread_structure->initializer;
+        thread_structure->initializer = nullptr;
+
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "Failed to allocate a stack of {} bytes for a new thread. The thread group is out of memory or exceeded its memory quota.",
+            thread_block_size
+        );
+
+        discard_created_thread(thread_id);
+        return module_mediator::module_failure;
+    }
+
+    char* thread_stack_memory = thread_state_memory + program_state_manager::thread_state_area_size;
+    char* thread_stack_end = thread_state_memory + thread_block_size;
 
     void* program_jump_table = std::bit_cast<void*>(
         module_mediator::fast_call<module_mediator::return_value>(
@@ -79,21 +110,8 @@ module_mediator::return_value on_thread_creation(module_mediator::arguments_stri
             thread_id,
             thread_state_memory
         );
-        
-        module_mediator::fast_call<module_mediator::return_value, module_mediator::memory>(
-            interoperation::get_module_part(),
-            interoperation::index_getter::resource_module(),
-            interoperation::index_getter::resource_module_deallocate_thread_memory(),
-            thread_id,
-            thread_stack_memory
-        );
-
-        module_mediator::return_value result_container_id = backend::deallocate_thread(thread_id);
-        if (backend::get_container_running_threads_count(result_container_id) == 0) {
-            backend::get_thread_manager().forget_thread_group(result_container_id);
-            backend::deallocate_program_container(result_container_id);
-        }
 
+        discard_created_thread(thread_id);
         return module_mediator::module_failure;
     }
 
@@ -104,8 +122,14 @@ module_mediator::return_value on_thread_creation(module_mediator::arguments_stri
         result
     );
 
-    // Fill in stack end address. Notice that it had to account for the space that 
-    // will be used to save the state of one variable between function calls.
+    // Fill in the address of the variable used by "save" and "load" instructions. It lives in the thread state.
+    backend::fill_in_register_array_entry(
+        saved_variable_address_index,
+        thread_state_memory,
+        reinterpret_cast<std::uintptr_t>(thread_state_memory + program_state_manager::saved_variable_displacement)
+    );
+
+    // Fill in stack end address. Programs check large stack allocations against it, smaller ones rely on the guard region.
     backend::fill_in_register_array_entry(
         stack_end_position_index,
         thread_state_memory,
@@ -171,7 +195,7 @@ module_mediator::return_value get_thread_saved_variable(module_mediator::argumen
     return program_state_manager{ 
         static_cast<char*>(
             backend::get_thread_local_structure()->currently_running_thread_information.thread_state)
-    }.get_stack_end();
+    }.get_saved_variable_address();
 }
 
 module_mediator::return_value dynamic_call(module_mediator::arguments_string_type bundle) {
@@ -242,6 +266,15 @@ module_mediator::return_value get_current_thread_group_id(module_mediator::argum
     return backend::get_thread_local_structure()->currently_running_thread_information.thread_group_id;
 }
 
+module_mediator::return_value get_current_thread_information(module_mediator::arguments_string_type) {
+    thread_local_structure* thread_structure = backend::get_thread_local_structure();
+    if (thread_structure == nullptr) {
+        return 0;
+    }
+
+    return reinterpret_cast<module_mediator::return_value>(&thread_structure->current_thread);
+}
+
 module_mediator::return_value make_runnable(module_mediator::arguments_string_type bundle) {
     auto [thread_id] = 
         module_mediator::arguments_string_builder::unpack<module_mediator::return_value>(bundle);
@@ -252,10 +285,8 @@ module_mediator::return_value make_runnable(module_mediator::arguments_string_ty
     else {
         LOG_PROGRAM_WARNING(
             interoperation::get_module_part(),
-            std::format(
-                "Was unable to make a thread with {} runnable again. This most likely indicates a data race.",
-                thread_id
-            )
+            "Was unable to make a thread with {} runnable again. This most likely indicates a data race.",
+            thread_id
         );
 
         return module_mediator::module_failure;
@@ -265,15 +296,30 @@ module_mediator::return_value make_runnable(module_mediator::arguments_string_ty
 }
 
 module_mediator::return_value start(module_mediator::arguments_string_type bundle) {
-    auto [thread_count] =
-        module_mediator::arguments_string_builder::unpack<std::uint16_t>(bundle);
+    auto [thread_count, placement_policy] =
+        module_mediator::arguments_string_builder::unpack<std::uint16_t, std::uint8_t>(bundle);
+
+    if (placement_policy > static_cast<std::uint8_t>(executors_placement::policy::numa)) {
+        LOG_ERROR(
+            interoperation::get_module_part(),
+            "Unknown executors placement policy: {}.", placement_policy
+        );
+
+        return module_mediator::module_failure;
+    }
 
     LOG_INFO(
         interoperation::get_module_part(), 
-        "Creating execution daemons. Count: " + std::to_string(thread_count)
+        "Creating execution daemons. Count: {}. Placement policy: {}.", 
+        thread_count, 
+        placement_policy
+    );
+
+    backend::get_thread_manager().startup(
+        thread_count, 
+        static_cast<executors_placement::policy>(placement_policy)
     );
 
-    backend::get_thread_manager().startup(thread_count);
     return module_mediator::module_success;
 }
 
@@ -333,10 +379,9 @@ module_mediator::return_value build_unwind_info(module_mediator::arguments_strin
     if (buffer_size < unwind_info_size) {
         LOG_PROGRAM_WARNING(
             interoperation::get_module_part(),
-            std::format("Provided buffer size of {} bytes is insufficient for unwind info of size {} bytes.",
-                buffer_size,
-                unwind_info_size
-            )
+            "Provided buffer size of {} bytes is insufficient for unwind info of size {} bytes.",
+            buffer_size,
+            unwind_info_size
         );
 
         return module_mediator::module_failure;
@@ -391,7 +436,7 @@ module_mediator::return_value verify_application_image(module_mediator::argument
     if (image_size > std::numeric_limits<ULONG>::max()) {
         LOG_PROGRAM_ERROR(
             interoperation::get_module_part(),
-            std::format("Image size {} exceeds maximum supported size.", image_size)
+            "Image size {} exceeds maximum supported size.", image_size
         );
 
         return module_mediator::module_failure;
@@ -468,8 +513,8 @@ module_mediator::return_value verify_application_image(module_mediator::argument
         if (prfCurrent == nullptr) {
             LOG_PROGRAM_ERROR(
                 interoperation::get_module_part(),
-                std::format("RUNTIME_FUNCTION entry for function at {:#x} is unavailable.", 
-                    std::bit_cast<std::uintptr_t>(function_address))
+                "RUNTIME_FUNCTION entry for function at {:#x} is unavailable.", 
+                std::bit_cast<std::uintptr_t>(function_address)
             );
 
             return module_mediator::module_failure;
@@ -478,8 +523,8 @@ module_mediator::return_value verify_application_image(module_mediator::argument
         if (dw64FunctionBase != dw64ImageBase) {
             LOG_PROGRAM_ERROR(
                 interoperation::get_module_part(),
-                std::format("Function at index {} has mismatched base address. Expected: {:#x}, Actual: {:#x}.",
-                    index, dw64ImageBase, dw64FunctionBase)
+                "Function at index {} has mismatched base address. Expected: {:#x}, Actual: {:#x}.",
+                index, dw64ImageBase, dw64FunctionBase
             );
 
             return module_mediator::module_failure;
@@ -491,7 +536,7 @@ module_mediator::return_value verify_application_image(module_mediator::argument
             prfCurrent->UnwindData != prfExpectedEntry->UnwindData) {
             LOG_PROGRAM_ERROR(
                 interoperation::get_module_part(),
-                std::format("RUNTIME_FUNCTION entry at index {} does not match expected values.", index)
+                "RUNTIME_FUNCTION entry at index {} does not match expected values.", index
             );
 
             return module_mediator::module_failure;
@@ -500,9 +545,9 @@ module_mediator::return_value verify_application_image(module_mediator::argument
         if (prfCurrent->BeginAddress >= image_size || prfCurrent->EndAddress > image_size) {
             LOG_PROGRAM_ERROR(
                 interoperation::get_module_part(),
-                std::format("RUNTIME_FUNCTION entry at index {} has offsets outside image bounds. "
-                    "BeginAddress: {:#x}, EndAddress: {:#x}, ImageSize: {:#x}.",
-                    index, prfCurrent->BeginAddress, prfCurrent->EndAddress, image_size)
+                "RUNTIME_FUNCTION entry at index {} has offsets outside image bounds. "
+                "BeginAddress: {:#x}, EndAddress: {:#x}, ImageSize: {:#x}.",
+                index, prfCurrent->BeginAddress, prfCurrent->EndAddress, image_size
             );
 
             return module_mediator::module_failure;
@@ -511,9 +556,9 @@ module_mediator::return_value verify_application_image(module_mediator::argument
         if (prfCurrent->UnwindData >= image_size) {
             LOG_PROGRAM_ERROR(
                 interoperation::get_module_part(),
-                std::format("RUNTIME_FUNCTION entry at index {} has UnwindData offset outside image bounds. "
-                    "UnwindData: {:#x}, ImageSize: {:#x}.",
-                    index, prfCurrent->UnwindData, image_size)
+                "RUNTIME_FUNCTION entry at index {} has UnwindData offset outside image bounds. "
+                "UnwindData: {:#x}, ImageSize: {:#x}.",
+                index, prfCurrent->UnwindData, image_size
             );
 
             return module_mediator::module_failure;
@@ -525,7 +570,7 @@ module_mediator::return_value verify_application_image(module_mediator::argument
         if (std::memcmp(actualUnwindInfo, providedUnwindInfo, reference_unwind_info_size) != 0) {
             LOG_PROGRAM_ERROR(
                 interoperation::get_module_part(),
-                std::format("Unwind info for function at index {} does not match expected values.", index)
+                "Unwind info for function at index {} does not match expected values.", index
             );
 
             return module_mediator::module_failure;
@@ -23,6 +23,7 @@ EXECUTIONMODULE_API module_mediator::return_value dynamic_call(module_mediator::
 
 EXECUTIONMODULE_API module_mediator::return_value get_current_thread_id(module_mediator::arguments_string_type bundle);
 EXECUTIONMODULE_API module_mediator::return_value get_current_thread_group_id(module_mediator::arguments_string_type bundle);
+EXECUTIONMODULE_API module_mediator::return_value get_current_thread_information(module_mediator::arguments_string_type bundle);
 EXECUTIONMODULE_API module_mediator::return_value make_runnable(module_mediator::arguments_string_type bundle);
 EXECUTIONMODULE_API module_mediator::return_value start(module_mediator::arguments_string_type bundle);
 EXECUTIONMODULE_API module_mediator::return_value create_thread(module_mediator::arguments_string_type bundle);
@@ -0,0 +1,127 @@
+#ifndef EXECUTORS_PLACEMENT_H
+#define EXECUTORS_PLACEMENT_H
+
+#include "pch.h"
+
+/*
+* Decides which logical processors executors are allowed to run on.
+* Topology is read once, when the executors are about to start. Notice that GetNumaNodeProcessorMaskEx
+* reports only one processor group per node, so on machines with more than 64 logical processors in one node
+* some of them won't be used for pinning. This is fine for our purposes.
+*/
+class executors_placement {
+public:
+    enum class policy : std::uint8_t {
+        // Executors can run on any processor, the OS decides. This is the default.
+        none = 0,
+
+        // Each executor is pinned to exactly one logical processor. Processors are taken node by node.
+        cores = 1,
+
+        // Executors are spread across NUMA nodes in round-robin order and can run on any processor of their node.
+        numa = 2
+    };
+
+private:
+    struct processor_placement {
+        std::uint16_t numa_node;
+        GROUP_AFFINITY affinity;
+    };
+
+    policy placement_policy;
+
+    // Affinity of each NUMA node that has at least one processor.
+    std::vector<processor_placement> nodes{};
+
+    // Affinity of each logical processor, ordered by NUMA node.
+    std::vector<processor_placement> processors{};
+
+public:
+    explicit executors_placement(policy requested_policy)
+        :placement_policy{ requested_policy }
+    {
+        if (this->placement_policy == policy::none) {
+            return;
+        }
+
+        ULONG highest_node_number = 0;
+        if (!GetNumaHighestNodeNumber(&highest_node_number)) {
+            this->placement_policy = policy::none;
+            return;
+        }
+
+        for (ULONG node = 0; node <= highest_node_number; ++node) {
+            GROUP_AFFINITY node_affinity{};
+            if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &node_affinity) || node_affinity.Mask == 0) {
+                continue;
+            }
+
+            this->nodes.push_back({ static_cast<std::uint16_t>(node), node_affinity });
+            for (KAFFINITY mask = node_affinity.Mask; mask != 0; mask &= mask - 1) {
+                GROUP_AFFINITY processor_affinity{};
+                processor_affinity.Group = node_affinity.Group;
+                processor_affinity.Mask = mask & (~mask + 1);
+
+                this->processors.push_back({ static_cast<std::uint16_t>(node), processor_affinity });
+            }
+        }
+
+        // There is nothing to group executors by on a single node system.
+        if (this->placement_policy == policy::numa && this->nodes.size() < 2) {
+            this->placement_policy = policy::none;
+        }
+
+        if (this->placement_policy == policy::cores && this->processors.empty()) {
+            this->placement_policy = policy::none;
+        }
+    }
+
+    policy get_policy() const noexcept {
+        return this->placement_policy;
+    }
+
+    std::size_t get_numa_nodes_count() const noexcept {
+        return this->nodes.size();
+    }
+
+    /*
+    * Applies placement to the calling executor thread.
+    * Returns the NUMA node that the executor is bound to, or nothing if it can run anywhere.
+    */
+    std::optional<std::uint16_t> apply(std::uint16_t executor_id) const {
+        const processor_placement* placement = nullptr;
+        switch (this->placement_policy) {
+        case policy::cores:
+            placement = &this->processors[executor_id % this->processors.size()];
+            break;
+
+        case policy::numa:
+            placement = &this->nodes[executor_id % this->nodes.size()];
+            break;
+
+        case policy::none:
+            return std::nullopt;
+        }
+
+        if (placement == nullptr || !SetThreadGroupAffinity(GetCurrentThread(), &placement->affinity, nullptr)) {
+            return std::nullopt;
+        }
+
+        return placement->numa_node;
+    }
+
+    // Returns the NUMA node of the processor that the calling thread is running on right now.
+    static std::optional<std::uint16_t> get_current_numa_node() {
+        PROCESSOR_NUMBER processor_number{};
+        GetCurrentProcessorNumberEx(&processor_number);
+
+        USHORT node_number = 0;
+        if (!GetNumaProcessorNodeEx(&processor_number, &node_number)) {
+            return std::nullopt;
+        }
+
+        return static_cast<std::uint16_t>(node_number);
+    }
+};
+
+#endif // !EXECUTORS_PLACEMENT_H
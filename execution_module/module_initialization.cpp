@@ -13,6 +13,7 @@ namespace {
     module_mediator::module_part* part = nullptr;
     thread_manager* manager = nullptr;
     char* runtime_trap_table = nullptr;
+    void* stack_guard_handler = nullptr;
 
     std::optional<std::string> verify_control_code_pdata_xdata_setup() {
         DWORD64 dw64LoadProgramBase = 0;
@@ -224,12 +225,20 @@ void initialize_m(module_mediator::module_part* module_part) {
         ENVIRONMENT_REQUEST_TERMINATION();
     }
 
+    // Must run before any other handler, a stack overflow is a regular program error rather than a crash.
+    stack_guard_handler = AddVectoredExceptionHandler(1, &runtime_traps::handle_stack_guard_fault);
+    if (stack_guard_handler == nullptr) {
+        std::cerr << "*** RUNTIME INITIALIZATION FAILED: Failed to register the stack guard handler.\n";
+        ENVIRONMENT_REQUEST_TERMINATION();
+    }
+
     logger_module::global_logging_instance::set_logging_enabled(true);
 }
 
 void free_m() {
     logger_module::global_logging_instance::set_logging_enabled(false);
 
+    RemoveVectoredExceptionHandler(stack_guard_handler);
     delete[] runtime_trap_table;
     delete manager;
 }
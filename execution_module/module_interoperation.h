@@ -57,6 +57,16 @@ namespace interoperation {
             return index;
         }
 
+        static std::size_t resource_module_allocate_thread_stack() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "allocate_thread_stack");
+            return index;
+        }
+
+        static std::size_t resource_module_get_stack_guard_size() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "get_stack_guard_size");
+            return index;
+        }
+
         static std::size_t resource_module_deallocate_program_container() {
             static std::size_t index = get_module_part()->find_function_index(resource_module(), "deallocate_program_container");
             return index;
@@ -39,5 +39,8 @@
 #include <bit>
 #include <winnt.h>
 #include <optional>
+#include <array>
+#include <algorithm>
+#include <chrono>
 
 #endif //PCH_H
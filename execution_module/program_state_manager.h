@@ -6,7 +6,13 @@
 
 class program_state_manager {
 public:
-	static constexpr std::size_t thread_state_size = 72;
+	// Includes the saved variable (8 bytes of value followed by 1 byte of type) used with "save" and "load" instructions.
+	// It is kept out of the stack, so that a frame that overflows the stack can't overwrite it before the overflow is detected.
+	static constexpr std::size_t thread_state_size = 89;
+	static constexpr std::size_t saved_variable_displacement = 80;
+
+	// Thread state and thread stack are allocated as one block, the stack starts right after this area.
+	static constexpr std::size_t thread_state_area_size = (thread_state_size + 15) & ~static_cast<std::size_t>(15);
 
 private:
 	char* program_state;
@@ -16,10 +22,11 @@ private:
 	static constexpr std::size_t jump_table_displacement = 16;
 	static constexpr std::size_t my_state_address_displacement = 24;
 	static constexpr std::size_t current_stack_position_displacement = 32;
-	static constexpr std::size_t stack_end_displacement = 40;
+	static constexpr std::size_t saved_variable_address_displacement = 40;
 	static constexpr std::size_t program_control_functions_displacement = 48;
 	static constexpr std::size_t executor_frame_stack_top_displacement = 56;
 	static constexpr std::size_t executor_frame_register_value_displacement = 64;
+	static constexpr std::size_t stack_end_displacement = 72;
 
 	template<typename type>
 	type generic_read_state_entry(std::size_t displacement) {
@@ -71,6 +78,14 @@ public:
 		this->generic_write_state_entry<std::uintptr_t>(current_stack_position_displacement, value);
 	}
 
+	// Address of the saved variable, it is kept in a register while the program runs.
+	std::uintptr_t get_saved_variable_address() {
+		return this->generic_read_state_entry<std::uintptr_t>(saved_variable_address_displacement);
+	}
+	void set_saved_variable_address(std::uintptr_t value) {
+		this->generic_write_state_entry<std::uintptr_t>(saved_variable_address_displacement, value);
+	}
+
 	std::uintptr_t get_stack_end() {
 		return this->generic_read_state_entry<std::uintptr_t>(stack_end_displacement);
 	}
@@ -78,7 +93,11 @@ public:
 		this->generic_write_state_entry<std::uintptr_t>(stack_end_displacement, value);
 	}
 	std::uintptr_t get_stack_start(std::size_t thread_stack_size) {
-		return this->generic_read_state_entry<std::uintptr_t>(stack_end_displacement) - thread_stack_size + (sizeof(module_mediator::one_byte) + sizeof(std::uint64_t));
+		return this->generic_read_state_entry<std::uintptr_t>(stack_end_displacement) - thread_stack_size;
+	}
+
+	std::uintptr_t get_executor_frame_stack_top() {
+		return this->generic_read_state_entry<std::uintptr_t>(executor_frame_stack_top_displacement);
 	}
 
 	std::uintptr_t get_program_control_functions() {
@@ -140,4 +140,47 @@ namespace runtime_traps {
         backend::thread_terminate();
         CONTROL_CODE_LOAD_EXECUTION_THREAD(&backend::get_thread_local_structure()->execution_thread_state);
     }
+
+    LONG CALLBACK handle_stack_guard_fault(PEXCEPTION_POINTERS exception_pointers) {
+        /*
+        * Programs don't check small stack allocations against the end of the stack (see program_functions.h in the program loader),
+        * the stack is followed by a guard region instead. An access to it means that the stack has overflown,
+        * so the program continues in the program end trampoline as if it had called the termination trap itself.
+        * Everything else is left to other handlers.
+        */
+
+        const EXCEPTION_RECORD* record = exception_pointers->ExceptionRecord;
+        if (record->ExceptionCode != EXCEPTION_ACCESS_VIOLATION || record->NumberParameters < 2) {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+
+        // System threads that were started before the module was loaded don't have the structure.
+        thread_local_structure* thread_structure = backend::get_thread_local_structure();
+        if (thread_structure == nullptr) {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+
+        std::uintptr_t fault_address = record->ExceptionInformation[1];
+        if (fault_address < thread_structure->stack_guard_start || fault_address >= thread_structure->stack_guard_end) {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+
+        // Generated code runs right at the executor frame stack top (or one return address below it, in a function prologue),
+        // while C++ code called from it runs deeper. Only generated code can be safely redirected, faults anywhere else are bugs.
+        CONTEXT* context = exception_pointers->ContextRecord;
+        std::uintptr_t frame_stack_top = program_state_manager{ 
+            static_cast<char*>(thread_structure->currently_running_thread_information.thread_state) 
+        }.get_executor_frame_stack_top();
+
+        if (context->Rsp != frame_stack_top && context->Rsp != frame_stack_top - sizeof(std::uint64_t)) {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+
+        context->Rsp = frame_stack_top;
+        context->Rcx = static_cast<DWORD64>(program_loader::termination_codes::stack_overflow);
+        context->R10 = reinterpret_cast<DWORD64>(backend::get_runtime_trap_table());
+        context->Rip = reinterpret_cast<DWORD64>(&CONTROL_CODE_TEMPLATE_PROGRAM_TERMINATION_POINT);
+
+        return EXCEPTION_CONTINUE_EXECUTION;
+    }
 }
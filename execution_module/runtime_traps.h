@@ -10,6 +10,9 @@ namespace runtime_traps {
         std::uint64_t function_id, 
         module_mediator::arguments_string_type args_string
     );
+
+    // Vectored exception handler, turns faults in the guard region of the running program thread's stack into stack overflows.
+    LONG CALLBACK handle_stack_guard_fault(PEXCEPTION_POINTERS exception_pointers);
 }
 
 #endif 
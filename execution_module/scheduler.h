@@ -12,11 +12,29 @@ class scheduler {
 public:
     using put_back_structure_type = void*;
 
+    // Used for executors that can run on any NUMA node and for thread groups whose memory node is unknown.
+    static constexpr std::uint16_t no_numa_node_preference = std::numeric_limits<std::uint16_t>::max();
+
+    /*
+    * Lifecycle of a program thread:
+    * startup  -> running                  (choose)
+    * runnable -> running                  (choose)
+    * running  -> runnable                 (put_back)
+    * running  -> blocking                 (block)
+    * blocking -> blocked                  (put_back)
+    * blocked  -> runnable                 (make_runnable)
+    * running  -> terminated               (delete_thread)
+    * 
+    * "blocking" exists because a thread is blocked while an executor still runs on its behalf.
+    * It must not be made runnable again until the executor gives it up in put_back.
+    */
     enum class thread_states {
         running,
         runnable,
         blocked,
-        startup
+        startup,
+        blocking,
+        terminated
     };
 
     struct schedule_information {
@@ -48,19 +66,43 @@ public:
         put_back_structure_type put_back_structure{}; 
     };
 
+    /*
+    * Each executor owns one of these and parks on it when there are no runnable threads.
+    * Waiting is done with std::atomic::wait, which uses WaitOnAddress on Windows. This allows
+    * the scheduler to wake exactly one idle executor per runnable thread instead of all of them.
+    * Statistics are written only by the owning executor while it holds clock_list_mutex.
+    */
+    struct executor_parking_spot {
+        // Set to true by the scheduler when this executor is removed from the idle list.
+        std::atomic<bool> is_signaled{ false };
+
+        // Written by the waker under clock_list_mutex right before signaling.
+        std::chrono::steady_clock::time_point signaled_at{};
+
+        // How many times this executor was woken up.
+        std::uint64_t wakeups_count{};
+
+        // How many times this executor was woken up, but another executor had already taken the work.
+        std::uint64_t spurious_wakeups_count{};
+
+        // Sum of delays between signaling an executor and it actually running again.
+        std::chrono::steady_clock::duration total_wakeup_latency{};
+    };
+
 private:
     struct executable_thread {
         module_mediator::return_value id;
 
-        // If locked, this means that the thread is already taken
-        // to be honest, this feels kind of like a misuse of mutex, because
-        // it is used to as data, not as a synchronization primitive.
-        mutable std::mutex lock;
-        thread_states state;
+        // Replaces the per-thread mutex that was used as a "taken" flag before.
+        // The thread is taken by an executor while it is in "running" or "blocking" state.
+        std::atomic<thread_states> state;
         
         void* state_buffer;
         const void* jump_table;
 
+        // Executors must never fall back to a lock to change the state of a thread.
+        static_assert(std::atomic<thread_states>::is_always_lock_free, "thread state must be lock free");
+
         executable_thread(
             module_mediator::return_value thread_id, 
             thread_states thread_initial_state, 
@@ -78,14 +120,14 @@ private:
 
         executable_thread(executable_thread&& thread) noexcept
             :id{ thread.id },
-            state{ thread.state },
+            state{ thread.state.load(std::memory_order_relaxed) },
             state_buffer{ thread.state_buffer },
             jump_table{ thread.jump_table }
         {}
 
         executable_thread& operator= (executable_thread&& thread) noexcept {
             this->id = thread.id;
-            this->state = thread.state;
+            this->state.store(thread.state.load(std::memory_order_relaxed), std::memory_order_relaxed);
 
             this->state_buffer = thread.state_buffer;
             this->jump_table = thread.jump_table;
@@ -93,6 +135,24 @@ private:
             return *this;
         }
 
+        /*
+        * Attempts to move the thread from "expected" to "desired" state.
+        * Acquire-release ordering makes the program state written by the previous owner
+        * visible to the executor that takes the thread next.
+        */
+        bool try_transition(thread_states expected, thread_states desired) noexcept {
+            return this->state.compare_exchange_strong(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        /*
+        * Same as try_transition, but the transition must not fail. If it does, this means that
+        * the thread was scheduled twice or was modified by someone who does not own it.
+        */
+        void transition(thread_states expected, thread_states desired) noexcept {
+            [[maybe_unused]] bool result = this->try_transition(expected, desired);
+            assert(result && "invalid thread state transition: the thread is most likely scheduled twice");
+        }
+
         ~executable_thread() noexcept = default;
     };
 
@@ -100,15 +160,20 @@ private:
         module_mediator::return_value id;
         std::uint64_t preferred_stack_size;
 
+        // NUMA node where the memory of this thread group was allocated (first touched).
+        std::uint16_t numa_node;
+
         mutable std::mutex lock;
         priority_list<executable_thread, module_mediator::return_value> threads;
 
         thread_group(
             module_mediator::return_value thread_group_id, 
-            std::uint64_t thread_group_preferred_stack_size
+            std::uint64_t thread_group_preferred_stack_size,
+            std::uint16_t thread_group_numa_node
         )
             :id{ thread_group_id },
-            preferred_stack_size{ thread_group_preferred_stack_size }
+            preferred_stack_size{ thread_group_preferred_stack_size },
+            numa_node{ thread_group_numa_node }
         {}
 
         thread_group(const thread_group&) = delete;
@@ -117,6 +182,7 @@ private:
         thread_group(thread_group&& thread_group) noexcept
             :id{ thread_group.id },
             preferred_stack_size{ thread_group.preferred_stack_size },
+            numa_node{ thread_group.numa_node },
             threads{ std::move(thread_group.threads) }
         {}
 
@@ -124,6 +190,7 @@ private:
             this->id = thread_group.id;
             this->threads = std::move(thread_group.threads);
             this->preferred_stack_size = thread_group.preferred_stack_size;
+            this->numa_node = thread_group.numa_node;
 
             return *this;
         }
@@ -131,6 +198,24 @@ private:
         ~thread_group() noexcept = default;
     };
 
+    /*
+    * One part of the threads hash table. Each thread id always maps to the same shard,
+    * so every operation on a specific thread is serialized on one shard mutex. This keeps lookups
+    * linearizable with respect to deletion, while unrelated threads no longer contend on a single lock.
+    * Shards are aligned to separate cache lines to avoid false sharing between their mutexes.
+    */
+    struct alignas(std::hardware_destructive_interference_size) threads_hash_table_shard {
+        std::unordered_map<module_mediator::return_value, priority_list<executable_thread, module_mediator::return_value>::proxy> threads;
+        std::mutex lock;
+    };
+
+    // Must be a power of two. Thread ids are generated sequentially, so their lowest bits are enough to spread them.
+    static constexpr std::size_t threads_hash_table_shards_count = 64;
+    static_assert(std::has_single_bit(threads_hash_table_shards_count), "shards count must be a power of two");
+
+    // How many thread groups an executor may skip to find one on its own NUMA node. Keeps "choose" cheap with many groups.
+    static constexpr std::size_t numa_lookahead_thread_groups_count = 8;
+
     /*
     * NOTE(about unordered_map): "References and pointers to either key or data stored in the container 
     * are only invalidated by erasing that element, even when the corresponding iterator is invalidated."
@@ -143,14 +228,16 @@ private:
     std::unordered_map<module_mediator::return_value, clock_list<thread_group>::proxy> thread_groups_hash_table;
     std::mutex thread_groups_hash_table_mutex;
 
-    std::unordered_map<module_mediator::return_value, priority_list<executable_thread, module_mediator::return_value>::proxy> threads_hash_table;
-    std::recursive_mutex threads_hash_table_mutex;
+    std::array<threads_hash_table_shard, threads_hash_table_shards_count> threads_hash_table;
 
     clock_list<thread_group> thread_groups;
     std::mutex clock_list_mutex;
 
     module_mediator::return_value runnable_threads_count{};
-    std::condition_variable runnable_thread_notify;
+
+    // Executors that are parked because there were no runnable threads, synchronized with clock_list_mutex.
+    // The most recently parked executor is woken up first, as it is the most likely to still have a warm cache.
+    std::vector<executor_parking_spot*> idle_executors;
 
     using thread_group_proxy = clock_list<thread_group>::proxy;
     using thread_proxy = priority_list<executable_thread, module_mediator::return_value>::proxy;
@@ -171,17 +258,34 @@ private:
         this->thread_groups_hash_table.erase(found_thread_group);
     }
     
+    threads_hash_table_shard& get_threads_hash_table_shard(module_mediator::return_value id) noexcept {
+        return this->threads_hash_table[id & (threads_hash_table_shards_count - 1)];
+    }
     thread_proxy& get_thread_using_hash_table(module_mediator::return_value id) {
-        std::scoped_lock threads_hash_table_lock{ this->threads_hash_table_mutex };
-        return this->threads_hash_table[id];
+        threads_hash_table_shard& shard = this->get_threads_hash_table_shard(id);
+
+        std::scoped_lock threads_hash_table_lock{ shard.lock };
+        return shard.threads[id];
+    }
+    // Must be called while holding clock_list_mutex. Signaling under the lock guarantees that
+    // the executor can't leave "choose" and destroy its parking spot before we are done with it.
+    static void wake_executor(executor_parking_spot* parking_spot) {
+        parking_spot->signaled_at = std::chrono::steady_clock::now();
+        parking_spot->is_signaled.store(true, std::memory_order_release);
+        parking_spot->is_signaled.notify_one();
     }
     void notify_runnable() {
-        {
-            std::scoped_lock clock_list_lock{ this->clock_list_mutex };
-            ++this->runnable_threads_count;
-        }
+        std::scoped_lock clock_list_lock{ this->clock_list_mutex };
+        ++this->runnable_threads_count;
 
-        this->runnable_thread_notify.notify_one();
+        // Wake up only one executor. If there are no idle executors, all of them are busy
+        // and one of them will notice the runnable thread when it comes back to "choose".
+        if (!this->idle_executors.empty()) {
+            executor_parking_spot* parking_spot = this->idle_executors.back();
+            this->idle_executors.pop_back();
+
+            wake_executor(parking_spot);
+        }
     }
 
 public:
@@ -190,16 +294,17 @@ public:
     * 1. lock on a clock_list mutex
     * 2. check runnable thread count
     * 
-    * if == 0 => block on condition variable
+    * if == 0 => add parking spot to the idle list, release clock_list mutex, and park until signaled
     * else 
     * 1. decrement runnable thread count 
-    * 2. choose thread group
+    * 2. choose thread group. on the first attempt an executor bound to a NUMA node looks a few thread groups ahead
+    * for one that lives on its node. further attempts use plain round-robin, so that the guarantee below still holds
     * 3. lock on a thread group mutex
     * 4. release clock_list mutex
     * 5. attempt to find a thread with the highest priority in a group
     * 
     * if successful:
-    * 1. acquire thread mutex
+    * 1. thread state was changed to "running" (this is how a thread is "taken")
     * 2. release thread group mutex
     * 3. return
     * 
@@ -208,7 +313,11 @@ public:
     * 2. repeat from step else. it is guaranteed that we will eventually stumble upon a thread group with 
     * a runnable thread because we reserved one thread by decrementing a runnable thread count.
     */
-    bool choose(schedule_information* destination) {
+    bool choose(
+        schedule_information* destination, 
+        executor_parking_spot& parking_spot, 
+        std::uint16_t executor_numa_node = no_numa_node_preference
+    ) {
         std::unique_lock clock_list_lock{ this->clock_list_mutex };
 
         while (true) {
@@ -218,34 +327,55 @@ public:
                     return false;
                 }
 
-                this->runnable_thread_notify.wait(
-                    clock_list_lock, 
-                    [this] { return this->runnable_threads_count > 0 || this->shutdown_sequence; }
-                );
+                parking_spot.is_signaled.store(false, std::memory_order_relaxed);
+                this->idle_executors.push_back(&parking_spot);
+
+                clock_list_lock.unlock();
+                parking_spot.is_signaled.wait(false, std::memory_order_acquire);
+
+                std::chrono::steady_clock::time_point woken_at = std::chrono::steady_clock::now();
+                clock_list_lock.lock();
+
+                ++parking_spot.wakeups_count;
+                parking_spot.total_wakeup_latency += woken_at - parking_spot.signaled_at;
+                if (this->runnable_threads_count == 0 && !this->shutdown_sequence) {
+                    ++parking_spot.spurious_wakeups_count;
+                }
             }
             else {
                 --this->runnable_threads_count;
+
+                bool is_first_attempt = true;
                 while (true) {
+                    if (is_first_attempt && executor_numa_node != no_numa_node_preference) {
+                        this->thread_groups.step_to_first(
+                            [executor_numa_node](const thread_group& thread_group_object) {
+                                return thread_group_object.numa_node == executor_numa_node;
+                            },
+                            numa_lookahead_thread_groups_count
+                        );
+                    }
+
+                    is_first_attempt = false;
                     thread_group* current_thread_group = this->thread_groups.get_current();
                     this->thread_groups.make_step(); //move to the next thread group
 
                     std::unique_lock thread_group_lock{ current_thread_group->lock };
                     clock_list_lock.unlock();
 
+                    thread_states previous_state{};
                     std::pair<executable_thread*, module_mediator::return_value> thread = current_thread_group->threads.find(
-                        [destination, current_thread_group](const executable_thread& thread_object) {
-                            if (thread_object.lock.try_lock()) { //check if thread is already taken
-                                if (
-                                    thread_object.state == thread_states::runnable || 
-                                    thread_object.state == thread_states::startup
-                                ) { //check if thread is runnable
-                                    //lock will be released in put_back
+                        [destination, current_thread_group, &previous_state](executable_thread& thread_object) {
+                            previous_state = thread_object.state.load(std::memory_order_relaxed);
+                            if (
+                                previous_state == thread_states::runnable ||
+                                previous_state == thread_states::startup
+                            ) { //check if thread is runnable, a plain load is enough to skip taken threads without writing to them
+                                //the state will be changed back in put_back
+                                if (thread_object.try_transition(previous_state, thread_states::running)) {
                                     destination->preferred_stack_size = current_thread_group->preferred_stack_size;
                                     return true;
                                 }
-                                else {
-                                    thread_object.lock.unlock();
-                                }
                             }
 
                             return false;
@@ -253,16 +383,15 @@ public:
                     );
 
                     thread_group_lock.unlock();					
-                    if (thread.first != nullptr) { //we have already acquired a thread->lock by using a try_lock function
+                    if (thread.first != nullptr) { //we have already taken this thread by changing its state to "running"
                         /*
                         * notice that we access current_thread_group after releasing the thread_group_lock.
                         * this should work fine because current_thread_group->id is a separate memory location,
                         * and no other threads write to it. also, in this case current_thread_group
                         * always points to a valid location in memory because pointers are invalidated only if
                         * specific object is deleted, and a thread group can not be deleted if it has at least one 
-                        * thread. if we are in this branch,  we are holding a lock to a thread inside 
-                        * this thread group, making it impossible to delete this thread and, subsequently, its 
-                        * thread group.
+                        * thread. if we are in this branch, we have taken a thread inside this thread group, 
+                        * making it impossible to delete this thread and, subsequently, its thread group.
                         */
 
                         destination->priority = thread.second;
@@ -270,10 +399,9 @@ public:
                         destination->thread_group_id = current_thread_group->id;
                         destination->jump_table = thread.first->jump_table;
                         destination->thread_state = thread.first->state_buffer;
-                        destination->state = thread.first->state;
+                        destination->state = previous_state;
                         destination->put_back_structure = thread.first;
 
-                        thread.first->state = thread_states::running;
                         return true;
                     }
 
@@ -295,12 +423,16 @@ public:
     * 5. add proxy to a thread group hash table
     * 6. release mutex
     */
-    void add_thread_group(module_mediator::return_value id, std::uint64_t preferred_stack_size) {
+    void add_thread_group(
+        module_mediator::return_value id, 
+        std::uint64_t preferred_stack_size, 
+        std::uint16_t numa_node = no_numa_node_preference
+    ) {
         thread_group_proxy proxy;
         
         {
             std::scoped_lock clock_list_lock{ this->clock_list_mutex };
-            proxy = this->thread_groups.push_after(id, preferred_stack_size);
+            proxy = this->thread_groups.push_after(id, preferred_stack_size, numa_node);
         }
 
         std::scoped_lock thread_groups_hash_table_lock{ this->thread_groups_hash_table_mutex };
@@ -315,9 +447,9 @@ public:
     * 4. lock on a thread group mutex using this proxy
     * 5. call priority_list.push acquiring a proxy
     * 6. release a thread group mutex
-    * 7. lock on a threads hash table mutex
-    * 8. add proxy to a threads hash table
-    * 9. release a threads hash table mutex
+    * 7. lock on a threads hash table shard mutex
+    * 8. add proxy to a threads hash table shard
+    * 9. release a threads hash table shard mutex
     * 10. lock on a clock_list mutex
     * 11. increment runnable threads count
     * 12. release a clock_list mutex
@@ -341,8 +473,10 @@ public:
                 thread_id, thread_states::startup, thread_state, jump_table
             );
 
-            std::scoped_lock thread_hash_table_lock{ this->threads_hash_table_mutex };
-            this->threads_hash_table[thread_id] = std::move(thread_proxy);
+            threads_hash_table_shard& shard = this->get_threads_hash_table_shard(thread_id);
+
+            std::scoped_lock thread_hash_table_lock{ shard.lock };
+            shard.threads[thread_id] = std::move(thread_proxy);
         }
 
         this->notify_runnable();
@@ -379,12 +513,11 @@ public:
     * 1. lock on a thread group hash table mutex
     * 2. find a thread group proxy
     * 3. release a thread group hash table mutex
-    * 4. lock on a threads hash table mutex
-    * 5. move a thread proxy to a new object, and delete an entry in threads hash table mutex
-    * 6. release a threads hash table mutex
+    * 4. lock on a threads hash table shard mutex
+    * 5. move a thread proxy to a new object, and delete an entry in threads hash table shard
+    * 6. release a threads hash table shard mutex
     * 7. lock on a thread group mutex
-    * 8. lock on a thread mutex - DO NOT DO THIS, we already acquired this mutex before switching to a program state (see preconditions)
-    * 8. release a thread mutex - because it is an UB to destroy a mutex while it is still being held
+    * 8. change thread state from "running" to "terminated" - the thread was taken before switching to a program state (see preconditions)
     * 9. priority_list.remove(thread proxy) 
     * 10. thread group.thread count == 0
     * 
@@ -409,19 +542,20 @@ public:
         thread_proxy thread_proxy{};
 
         {
-            std::scoped_lock threads_hash_table_lock{ this->threads_hash_table_mutex };
+            threads_hash_table_shard& shard = this->get_threads_hash_table_shard(thread_id);
+            std::scoped_lock threads_hash_table_lock{ shard.lock };
             
-            auto found_thread = this->threads_hash_table.find(thread_id);
-            assert(found_thread != this->threads_hash_table.end() && "invalid thread id when deleting a thread");
+            auto found_thread = shard.threads.find(thread_id);
+            assert(found_thread != shard.threads.end() && "invalid thread id when deleting a thread");
 
             thread_proxy = std::move(found_thread->second);
-            this->threads_hash_table.erase(found_thread);
+            shard.threads.erase(found_thread);
         }
 
         {
             std::unique_lock thread_group_lock{ thread_group_proxy->lock };
 
-            thread_proxy->lock.unlock();
+            thread_proxy->transition(thread_states::running, thread_states::terminated);
             thread_group_proxy->threads.remove(std::move(thread_proxy));
 
             if (thread_group_proxy->threads.count() == 0) {
@@ -445,11 +579,10 @@ public:
     }
 
     /* blocks a current thread.
-    * 1. lock on a threads hash table mutex
+    * 1. lock on a threads hash table shard mutex
     * 2. find a thread proxy
-    * 3. release a threads hash table mutex
-    * 4. lock on a thread mutex - we must NOT do this (check precondition 3)
-    * 4. change state to "blocked"
+    * 3. release a threads hash table shard mutex
+    * 4. change state from "running" to "blocking" - the thread stays taken until put_back
     */
     void block(module_mediator::return_value thread_id) {
         thread_proxy& thread_proxy = this->get_thread_using_hash_table(thread_id);
@@ -457,89 +590,72 @@ public:
         // Either way this should optimize out when compiling for release.
         // They both should not fire under normal circumstances.
         assert(thread_proxy.has_resource() && "unexpected no resource when blocking current thread");
-        assert(thread_proxy->state == thread_states::running && "unexpected thread state when blocking current thread");
-
-        thread_proxy->state = thread_states::blocked;
+        thread_proxy->transition(thread_states::running, thread_states::blocking);
     }
 
     /*
     * make blocked thread runnable again.
-    * 1. lock on a threads hash table mutex
+    * 1. lock on a threads hash table shard mutex
     * 2. find a thread proxy
-    * 3. release a threads hash table mutex
-    * 4. lock on a thread mutex
-    * 5. change state
-    * 6. release a thread mutex
-    * 7. lock on a clock_list mutex
-    * 8. increment runnable thread count
-    * 9. release a clock_list mutex
-    * 10. notify condition variable
+    * 3. change state from "blocked" to "runnable"
+    * 4. release a threads hash table shard mutex
+    * 5. lock on a clock_list mutex
+    * 6. increment runnable thread count
+    * 7. release a clock_list mutex
+    * 8. notify condition variable
     */
     bool make_runnable(module_mediator::return_value thread_id) {
         // We do this to ensure that thread is actually blocked and not running or runnable.
         // Because if it is, then it is possible that it'll be removed just before we acquire the lock.
         // This, in turn, will lead to an undefined behavior.
 
-        std::unique_lock threads_hash_table_lock{ this->threads_hash_table_mutex };
-        thread_proxy& thread_proxy = this->get_thread_using_hash_table(thread_id);
+        threads_hash_table_shard& shard = this->get_threads_hash_table_shard(thread_id);
+        std::unique_lock threads_hash_table_lock{ shard.lock };
 
         // This is even worse than terrible, because this means that we are trying to make a non-existent thread runnable.
-        if (!thread_proxy.has_resource()) {
-            [[maybe_unused]] std::size_t result = this->threads_hash_table.erase(thread_id);
-            assert(result == 1 && "invalid thread id: something went really wrong");
-
+        auto found_thread = shard.threads.find(thread_id);
+        if (found_thread == shard.threads.end() || !found_thread->second.has_resource()) {
             return false;
         }
 
-        {
-            if (thread_proxy->lock.try_lock()) {
-                std::unique_lock thread_lock{thread_proxy->lock, std::adopt_lock};
-
-                // We don't need this anymore, if we acquired the lock, then this means that the thread is either blocked or runnable.
-                threads_hash_table_lock.unlock();
-                if (thread_proxy->state == thread_states::blocked) {
-                    thread_proxy->state = thread_states::runnable;
-                    this->notify_runnable();
+        thread_proxy& thread_proxy = found_thread->second;
 
-                    return true;
-                }
+        // Only a blocked thread can be made runnable. If the thread is running, blocking, runnable or startup, 
+        // this is terrible, because it means that someone tried to wake up a thread that was not waiting for it.
+        // Notice that we can't touch the thread after this point: it may be chosen and deleted right away.
+        bool is_made_runnable = thread_proxy->try_transition(thread_states::blocked, thread_states::runnable);
+        threads_hash_table_lock.unlock();
 
-                // This also terrible, because it means that the thread is runnable or startup.
-                return false;
-            }
-            else {
-                // This is terrible, because it means that the thread is either running.
-                return false;
-            }
+        if (is_made_runnable) {
+            this->notify_runnable();
         }
+
+        return is_made_runnable;
     }
 
     /*
     * return a thread to scheduler after receiving a switch command. 
-    * 1. thread state == "running" || == "startup"
+    * 1. thread state == "running"
     * 
     * if true:
     * 1. change state to "runnable"
-    * 2. release a thread mutex
-    * 3. lock on a clock_list mutex
-    * 4. increment runnable thread count
-    * 5. release a clock_list mutex
-    * 6. notify condition variable
+    * 2. lock on a clock_list mutex
+    * 3. increment runnable thread count
+    * 4. release a clock_list mutex
+    * 5. notify condition variable
     * 
     * else:
-    * 1. release a thread mutex
+    * 1. change state from "blocking" to "blocked"
     */
     void put_back(put_back_structure_type put_back_structure) {
         executable_thread* thread = static_cast<executable_thread*>(put_back_structure);
-        if (thread->state == thread_states::running) {
-            thread->state = thread_states::runnable;
-            
-            //thread->lock was acquired by another function (specifically "scheduler::choose")
-            thread->lock.unlock();
+
+        //thread was taken by another function (specifically "scheduler::choose"), so no one else can change its state
+        if (thread->try_transition(thread_states::running, thread_states::runnable)) {
             this->notify_runnable();
         }
         else {
-            thread->lock.unlock();
+            thread->transition(thread_states::blocking, thread_states::blocked);
         }
     }
 
@@ -549,15 +665,27 @@ public:
     }
 
     void initiate_shutdown() { 
-        //locking on this mutex is required in order to ensure that all executors are either already waiting on a condition variable or are yet to enter the "choose" function.
+        //locking on this mutex is required in order to ensure that all executors are either already parked or are yet to enter the "choose" function.
         std::scoped_lock clock_list_lock{ this->clock_list_mutex };
-        if (!this->threads_hash_table.empty() || !this->thread_groups_hash_table.empty()) {
+        bool has_remaining_threads = std::ranges::any_of(
+            this->threads_hash_table,
+            [](threads_hash_table_shard& shard) {
+                std::scoped_lock threads_hash_table_lock{ shard.lock };
+                return !shard.threads.empty();
+            }
+        );
+
+        if (has_remaining_threads || !this->thread_groups_hash_table.empty()) {
             // Make a panic shutdown if hash tables got out of sync
             ENVIRONMENT_REQUEST_TERMINATION();
         }
 
         this->shutdown_sequence = true;
-        this->runnable_thread_notify.notify_all();
+        for (executor_parking_spot* parking_spot : this->idle_executors) {
+            wake_executor(parking_spot);
+        }
+
+        this->idle_executors.clear();
     }
 };
 
@@ -4,6 +4,7 @@
 #include "pch.h"
 #include "scheduler.h"
 #include "control_code_templates.h"
+#include "current_thread_information.h"
 
 struct thread_local_structure {
     // Contains data that will be passed to the main function in thread.
@@ -25,6 +26,14 @@ struct thread_local_structure {
 
     // Information about the currently running program thread, as acquired from the scheduler.
     scheduler::schedule_information currently_running_thread_information{};
+
+    // Copy of the ids from currently_running_thread_information, shared with other modules.
+    current_thread_information current_thread{};
+
+    // Guard region of the program thread's stack while its code runs on this executor, empty otherwise.
+    // Access violations inside it are stack overflows, see runtime_traps::handle_stack_guard_fault.
+    std::uintptr_t stack_guard_start{};
+    std::uintptr_t stack_guard_end{};
 };
 
 #endif // !THREAD_LOCAL_STRUCTURE_H
@@ -2,9 +2,11 @@
 #define THREAD_MANAGER_H
 
 #include "scheduler.h"
+#include "executors_placement.h"
 #include "module_interoperation.h"
 #include "control_code_templates.h"
 #include "execution_backend_functions.h"
+#include "program_state_manager.h"
 
 #include "../logger_module/logging.h"
 #include "../startup_components/local_crash_handlers.h"
@@ -21,17 +23,19 @@ class thread_manager {
     scheduler scheduler;
     std::atomic_size_t active_threads_counter = 0;
 
-    void executor_thread(module_mediator::return_value executor_id) {
+    void executor_thread(std::uint16_t executor_id, const executors_placement& placement) {
         // These must be installed on a per-thread basis.
         startup_components::crash_handling::install_local_crash_handlers();
 
+        std::uint16_t executor_numa_node = placement.apply(executor_id).value_or(scheduler::no_numa_node_preference);
         LOG_INFO(
             interoperation::get_module_part(), 
-            std::format(
-                "Executor {} is starting. System thread is {}.", 
-                executor_id,
-                GetCurrentThreadId()
-            )
+            "Executor {} is starting. System thread is {}. NUMA node is {}.", 
+            executor_id,
+            GetCurrentThreadId(),
+            executor_numa_node == scheduler::no_numa_node_preference 
+                ? std::string{ "not fixed" } 
+                : std::to_string(executor_numa_node)
         );
 
         ULONG ulDesiredStackSize = 8192;
@@ -39,11 +43,9 @@ class thread_manager {
         if (!bResult) {
             LOG_WARNING(
                 interoperation::get_module_part(),
-                std::format(
-                    "Failed to set thread stack guarantee for executor {}. " \
-                    "This may impede fatal error reporting.", 
-                    executor_id
-                )
+                "Failed to set thread stack guarantee for executor {}. " \
+                "This may impede fatal error reporting.", 
+                executor_id
             );
         }
 
@@ -51,17 +53,42 @@ class thread_manager {
         scheduler::schedule_information* currently_running_thread_information = 
             &thread_structure->currently_running_thread_information;
 
+        // Must outlive every call to "choose", the scheduler keeps a pointer to it while this executor is parked.
+        scheduler::executor_parking_spot parking_spot{};
         while (true) {
-            bool choose_result = this->scheduler.choose(currently_running_thread_information);
+            bool choose_result = this->scheduler.choose(
+                currently_running_thread_information, 
+                parking_spot, 
+                executor_numa_node
+            );
+
             if (!choose_result) {
                 LOG_INFO(
                     interoperation::get_module_part(), 
-                    std::format("Executor is shutting down.", executor_id)
+                    "Executor {} is shutting down. Wakeups: {}, spurious wakeups: {}, average wakeup latency: {}.", 
+                    executor_id,
+                    parking_spot.wakeups_count,
+                    parking_spot.spurious_wakeups_count,
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        parking_spot.total_wakeup_latency / std::max<std::uint64_t>(parking_spot.wakeups_count, 1)
+                    )
                 );
 
                 break;
             }
 
+            thread_structure->current_thread = {
+                currently_running_thread_information->thread_id,
+                currently_running_thread_information->thread_group_id,
+                std::bit_cast<unsigned char*>(
+                    program_state_manager{ static_cast<char*>(currently_running_thread_information->thread_state) }.get_saved_variable_address()
+                )
+            };
+
+            thread_structure->stack_guard_start = 
+                program_state_manager{ static_cast<char*>(currently_running_thread_information->thread_state) }.get_stack_end();
+            thread_structure->stack_guard_end = thread_structure->stack_guard_start + backend::get_stack_guard_size();
+
             // All other modifications are synchronized with mutexes. This is one just needs atomicity.
             this->active_threads_counter.fetch_add(1, std::memory_order_relaxed);
             CONTROL_CODE_LOAD_PROGRAM(
@@ -72,6 +99,8 @@ class thread_manager {
 
             // Reset execution thread state to default values.
             backend::get_thread_local_structure()->execution_thread_state = {};
+            backend::get_thread_local_structure()->stack_guard_start = 0;
+            backend::get_thread_local_structure()->stack_guard_end = 0;
 
             std::size_t previous_active_threads_count = this->active_threads_counter.fetch_sub(1, std::memory_order_relaxed);
             if (currently_running_thread_information->put_back_structure) {
@@ -81,10 +110,8 @@ class thread_manager {
                     if (module_index == module_mediator::module_part::module_not_found) {
                         LOG_WARNING(
                             interoperation::get_module_part(),
-                            std::format(
-                                "Module {} not found.", 
-                                deferred_callback->module_name
-                            )
+                            "Module {} not found.", 
+                            deferred_callback->module_name
                         );
 
                         continue;
@@ -97,11 +124,9 @@ class thread_manager {
                     if (function_index == module_mediator::module_part::function_not_found) {
                         LOG_WARNING(
                             interoperation::get_module_part(),
-                            std::format(
-                                "Function {} not found in module {}.", 
-                                deferred_callback->function_name, 
-                                deferred_callback->module_name
-                            )
+                            "Function {} not found in module {}.", 
+                            deferred_callback->function_name, 
+                            deferred_callback->module_name
                         );
 
                         continue;
@@ -116,12 +141,10 @@ class thread_manager {
                     if (result != module_mediator::module_success) {
                         LOG_WARNING(
                             interoperation::get_module_part(),
-                            std::format(
-                                "Deferred callback for module {} and function {} failed with error code {}.",
-                                deferred_callback->module_name,
-                                deferred_callback->function_name,
-                                result
-                            )
+                            "Deferred callback for module {} and function {} failed with error code {}.",
+                            deferred_callback->module_name,
+                            deferred_callback->function_name,
+                            result
                         );
                     }
                 }
@@ -139,7 +162,13 @@ class thread_manager {
 
 public:
     void add_thread_group(module_mediator::return_value id, std::uint64_t preferred_stack_size) {
-        this->scheduler.add_thread_group(id, preferred_stack_size);
+        // Memory for the first thread of a group is allocated and first touched by the thread that creates the group.
+        // This means that the group's memory lives on the NUMA node of the current processor.
+        this->scheduler.add_thread_group(
+            id, 
+            preferred_stack_size, 
+            executors_placement::get_current_numa_node().value_or(scheduler::no_numa_node_preference)
+        );
     }
 
     void add_thread(
@@ -171,22 +200,40 @@ public:
         return this->scheduler.make_runnable(thread_id);
     }
 
-    void startup(std::uint16_t thread_count) {
+    void startup(std::uint16_t thread_count, executors_placement::policy placement_policy) {
         if(!this->scheduler.has_available_jobs()) {
             LOG_WARNING(interoperation::get_module_part(), "No available jobs found. Executors won't start.");
             return;
         }
 
+        executors_placement placement{ placement_policy };
+        if (placement.get_policy() != placement_policy) {
+            LOG_INFO(
+                interoperation::get_module_part(), 
+                "Requested executors placement is not applicable on this system ({} NUMA node(s)). Executors won't be pinned.",
+                placement.get_numa_nodes_count()
+            );
+        }
+
         std::vector<std::thread> executors{};
         executors.reserve(thread_count);
 
+        auto started_at = std::chrono::steady_clock::now();
         for (std::uint16_t counter = 0; counter < thread_count; ++counter) {
-            executors.emplace_back(&thread_manager::executor_thread, this, counter);
+            executors.emplace_back(&thread_manager::executor_thread, this, counter, std::cref(placement));
         }
 
         for (std::thread& executor : executors) {
             executor.join();
         }
+
+        // Covers only the execution of the program, not loading it. examples/run-benchmark.ps1 reads this line.
+        LOG_INFO(
+            interoperation::get_module_part(),
+            "All executors have finished. Count: {}. Elapsed time: {}.",
+            thread_count,
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_at)
+        );
     }
 };
 
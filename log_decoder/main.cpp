@@ -0,0 +1,435 @@
+#ifndef _MSC_VER
+#error "Currently only MSVC is supported for the log decoder."
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "../logger_module/binary_log_format.h"
+#include "../startup_components/startup_definitions.h"
+#include "../startup_components/unicode_punning.h"
+#include "../startup_components/local_crash_handlers.h"
+
+namespace {
+    using namespace logger_module::binary_log;
+
+    // Everything about a log call site that doesn't change between messages.
+    struct log_site {
+        std::uint8_t message_type;
+        std::uint64_t file_line;
+        std::string file_name;
+        std::string function_name;
+        std::string module_name;
+        std::string format;
+    };
+
+    using log_argument = std::variant<std::uint64_t, std::int64_t, double, bool, char, const void*, std::string>;
+
+    class log_reader {
+    private:
+        const std::vector<char>& log;
+        std::size_t position = 0;
+
+    public:
+        explicit log_reader(const std::vector<char>& log)
+            : log{ log }
+        {}
+
+        bool at_end() const {
+            return this->position == this->log.size();
+        }
+
+        std::size_t get_position() const {
+            return this->position;
+        }
+
+        template<typename value_type>
+        std::optional<value_type> read_value() {
+            if (this->log.size() - this->position < sizeof(value_type)) {
+                return std::nullopt;
+            }
+
+            value_type value{};
+            std::memcpy(&value, this->log.data() + this->position, sizeof(value_type));
+            this->position += sizeof(value_type);
+
+            return value;
+        }
+
+        std::optional<std::string> read_string() {
+            std::optional<std::uint32_t> size = this->read_value<std::uint32_t>();
+            if (!size.has_value() || this->log.size() - this->position < *size) {
+                return std::nullopt;
+            }
+
+            std::string value{ this->log.data() + this->position, *size };
+            this->position += *size;
+
+            return value;
+        }
+    };
+
+    std::optional<log_argument> read_argument(log_reader& reader) {
+#ifdef __clang__
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wswitch-default"
+
+#endif
+
+        std::optional<argument_type> type = reader.read_value<argument_type>();
+        if (!type.has_value()) {
+            return std::nullopt;
+        }
+
+        switch (*type) {
+        case argument_type::unsigned_integer:
+            return reader.read_value<std::uint64_t>();
+
+        case argument_type::signed_integer:
+            return reader.read_value<std::int64_t>();
+
+        case argument_type::floating_point:
+            return reader.read_value<double>();
+
+        case argument_type::boolean:
+            if (std::optional<std::uint8_t> value = reader.read_value<std::uint8_t>()) {
+                return *value != 0;
+            }
+
+            return std::nullopt;
+
+        case argument_type::character:
+            return reader.read_value<char>();
+
+        case argument_type::pointer:
+            if (std::optional<std::uint64_t> value = reader.read_value<std::uint64_t>()) {
+                return reinterpret_cast<const void*>(static_cast<std::uintptr_t>(*value));
+            }
+
+            return std::nullopt;
+
+        case argument_type::string:
+            return reader.read_string();
+        }
+
+#ifdef __clang__
+
+#pragma clang diagnostic pop
+
+#endif
+
+        return std::nullopt;
+    }
+
+    std::optional<std::vector<log_argument>> read_arguments(const std::vector<char>& encoded_arguments) {
+        log_reader reader{ encoded_arguments };
+        std::vector<log_argument> arguments{};
+        while (!reader.at_end()) {
+            std::optional<log_argument> argument = read_argument(reader);
+            if (!argument.has_value()) {
+                return std::nullopt;
+            }
+
+            arguments.push_back(std::move(*argument));
+        }
+
+        return arguments;
+    }
+
+    // std::vformat needs all arguments at once, and their count is known only at runtime.
+    // So every replacement field is formatted on its own, with the same format specification that the call site used.
+    std::string format_message(std::string_view format, const std::vector<log_argument>& arguments) {
+        std::string message{};
+        std::size_t next_argument = 0;
+        for (std::size_t index = 0; index < format.size(); ++index) {
+            char symbol = format[index];
+            if (symbol == '}') {
+                /* "}}" is an escaped brace. Single '}' can't appear outside of a replacement field in a valid format string. */
+                if (index + 1 < format.size() && format[index + 1] == '}') {
+                    ++index;
+                }
+
+                message += '}';
+                continue;
+            }
+
+            if (symbol != '{') {
+                message += symbol;
+                continue;
+            }
+
+            if (index + 1 < format.size() && format[index + 1] == '{') {
+                message += '{';
+                ++index;
+                continue;
+            }
+
+            std::size_t field_end = format.find('}', index);
+            if (field_end == std::string_view::npos) {
+                throw std::format_error("Unterminated replacement field.");
+            }
+
+            std::string_view field = format.substr(index + 1, field_end - index - 1);
+            std::size_t specification_start = field.find(':');
+            std::string_view argument_index = field.substr(0, specification_start);
+            std::string_view specification =
+                specification_start == std::string_view::npos ? std::string_view{} : field.substr(specification_start);
+
+            std::size_t argument = next_argument++;
+            if (!argument_index.empty()) {
+                argument = 0;
+                for (char digit : argument_index) {
+                    if (digit < '0' || digit > '9') {
+                        throw std::format_error("Invalid argument index.");
+                    }
+
+                    argument = argument * 10 + static_cast<std::size_t>(digit - '0');
+                }
+            }
+
+            if (argument >= arguments.size()) {
+                throw std::format_error("Argument index is out of range.");
+            }
+
+            std::string field_format = std::format("{{{}}}", specification);
+            message += std::visit(
+                [&](const auto& value) {
+                    return std::vformat(field_format, std::make_format_args(value));
+                },
+                arguments[argument]
+            );
+
+            index = field_end;
+        }
+
+        return message;
+    }
+
+    std::string_view decode_message_type(std::uint8_t message_type) {
+        constexpr std::string_view names[]{ "INFO", "WARNING", "ERROR", "FATAL" };
+        return names[message_type % 4];
+    }
+
+    std::string or_unspecified(const std::string& value) {
+        return value.empty() ? "UNSPECIFIED" : value;
+    }
+
+    // Produces the same line that the logger would have written to std::cerr.
+    void print_message(
+        std::uint8_t message_type,
+        std::uint64_t timestamp,
+        std::uint64_t thread_id,
+        std::uint64_t thread_group_id,
+        const std::string& file_name,
+        std::uint64_t file_line,
+        const std::string& function_name,
+        const std::string& module_name,
+        const std::string& message
+    ) {
+        std::cout << std::format(
+            "[{}] [{}] [{}, {}, {}, {}] ",
+            decode_message_type(message_type),
+            timestamp,
+            or_unspecified(module_name),
+            or_unspecified(file_name),
+            or_unspecified(function_name),
+            file_line == 0 ? "UNSPECIFIED" : std::to_string(file_line)
+        );
+
+        if (message_type >= 4) {
+            if (thread_id == 0 && thread_group_id == 0) {
+                std::cout << "[ENGINE] ";
+            }
+            else {
+                std::cout << "[THREAD: " << thread_id << ", THREAD GROUP: " << thread_group_id << "] ";
+            }
+        }
+
+        std::cout << message << '\n';
+    }
+
+    std::string get_string_argument(const std::vector<log_argument>& arguments, std::size_t index) {
+        if (index < arguments.size()) {
+            if (const std::string* value = std::get_if<std::string>(&arguments[index])) {
+                return *value;
+            }
+        }
+
+        return {};
+    }
+
+    bool decode_message(log_reader& reader, const std::unordered_map<std::uint32_t, log_site>& sites) {
+        std::optional site_id = reader.read_value<std::uint32_t>();
+        std::optional message_type = reader.read_value<std::uint8_t>();
+        std::optional timestamp = reader.read_value<std::uint64_t>();
+        std::optional thread_id = reader.read_value<std::uint64_t>();
+        std::optional thread_group_id = reader.read_value<std::uint64_t>();
+        std::optional arguments_size = reader.read_value<std::uint32_t>();
+        if (!site_id || !message_type || !timestamp || !thread_id || !thread_group_id || !arguments_size) {
+            return false;
+        }
+
+        std::vector<char> encoded_arguments{};
+        for (std::uint32_t index = 0; index < *arguments_size; ++index) {
+            std::optional<char> byte = reader.read_value<char>();
+            if (!byte.has_value()) {
+                return false;
+            }
+
+            encoded_arguments.push_back(*byte);
+        }
+
+        std::optional<std::vector<log_argument>> arguments = read_arguments(encoded_arguments);
+        if (!arguments.has_value()) {
+            std::cerr << "Message at site " << *site_id << " has malformed arguments.\n";
+            return true;
+        }
+
+        /* Preformatted messages carry the call site information in their arguments. */
+        if (*site_id == preformatted_site) {
+            const std::uint64_t* file_line = arguments->size() > 1 ? std::get_if<std::uint64_t>(&(*arguments)[1]) : nullptr;
+            print_message(
+                *message_type,
+                *timestamp,
+                *thread_id,
+                *thread_group_id,
+                get_string_argument(*arguments, 0),
+                file_line == nullptr ? 0 : *file_line,
+                get_string_argument(*arguments, 2),
+                get_string_argument(*arguments, 3),
+                get_string_argument(*arguments, 4)
+            );
+
+            return true;
+        }
+
+        auto site = sites.find(*site_id);
+        if (site == sites.end()) {
+            std::cerr << "Message refers to unknown site " << *site_id << ".\n";
+            return true;
+        }
+
+        std::string message{};
+        try {
+            message = format_message(site->second.format, *arguments);
+        }
+        catch (const std::format_error& error) {
+            message = std::format("{} (failed to format: {})", site->second.format, error.what());
+        }
+
+        print_message(
+            *message_type,
+            *timestamp,
+            *thread_id,
+            *thread_group_id,
+            site->second.file_name,
+            site->second.file_line,
+            site->second.function_name,
+            site->second.module_name,
+            message
+        );
+
+        return true;
+    }
+
+    bool decode_site(log_reader& reader, std::unordered_map<std::uint32_t, log_site>& sites) {
+        std::optional site_id = reader.read_value<std::uint32_t>();
+        std::optional message_type = reader.read_value<std::uint8_t>();
+        std::optional file_line = reader.read_value<std::uint64_t>();
+        std::optional file_name = reader.read_string();
+        std::optional function_name = reader.read_string();
+        std::optional module_name = reader.read_string();
+        std::optional format = reader.read_string();
+        if (!site_id || !message_type || !file_line || !file_name || !function_name || !module_name || !format) {
+            return false;
+        }
+
+        sites[*site_id] = log_site{
+            *message_type,
+            *file_line,
+            std::move(*file_name),
+            std::move(*function_name),
+            std::move(*module_name),
+            std::move(*format)
+        };
+
+        return true;
+    }
+}
+
+APPLICATION_ENTRYPOINT("LOG DECODER", FSI_PROJECT_VERSION, argc, argv) {
+    crash_handling::install_local_crash_handlers();
+
+    if (argc != 2) {
+        std::cerr << "You need to provide one argument: binary log file written by the logger module (see FSI_BINARY_LOG)." << '\n';
+        return EXIT_FAILURE;
+    }
+
+    try {
+        std::ifstream log_file{ UTF8_PATH(argv[1]), std::ios::binary };
+        if (!log_file.is_open()) {
+            std::cerr << "Unable to open the log file." << '\n';
+            return EXIT_FAILURE;
+        }
+
+        std::vector<char> log{ std::istreambuf_iterator<char>{ log_file }, std::istreambuf_iterator<char>{} };
+        log_reader reader{ log };
+
+        std::optional header = reader.read_value<std::array<char, std::size(signature)>>();
+        if (!header.has_value() || std::memcmp(header->data(), signature, sizeof(signature)) != 0) {
+            std::cerr << "Invalid log file signature." << '\n';
+            return EXIT_FAILURE;
+        }
+
+        std::optional log_version = reader.read_value<std::uint32_t>();
+        if (!log_version.has_value() || *log_version != version) {
+            std::cerr << "Unsupported log file version." << '\n';
+            return EXIT_FAILURE;
+        }
+
+        std::unordered_map<std::uint32_t, log_site> sites{};
+        while (!reader.at_end()) {
+            std::size_t record_start = reader.get_position();
+            std::optional type = reader.read_value<record_type>();
+
+            bool complete = false;
+            if (type == record_type::site) {
+                complete = decode_site(reader, sites);
+            }
+            else if (type == record_type::message) {
+                complete = decode_message(reader, sites);
+            }
+            else {
+                std::cerr << "Unknown record type at offset " << record_start << ", the rest of the log is skipped." << '\n';
+                return EXIT_FAILURE;
+            }
+
+            /* The process may have been terminated while the log was being written. */
+            if (!complete) {
+                std::cerr << "The log ends with an incomplete record at offset " << record_start << '.' << '\n';
+                break;
+            }
+        }
+
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& exc) {
+        std::cerr << "Unable to decode the log: " << exc.what() << '\n';
+    }
+
+    return EXIT_FAILURE;
+}
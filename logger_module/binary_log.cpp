@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "binary_log.h"
+#include "binary_log_format.h"
+#include "module_interoperation.h"
+
+extern std::chrono::steady_clock::time_point starting_time;
+
+namespace {
+    constexpr std::size_t flush_threshold = 1 << 20;
+
+    std::mutex binary_log_lock;
+    std::ofstream binary_log_file{};
+    std::string binary_log_buffer{};
+    std::atomic<std::uint32_t> next_site_id = logger_module::binary_log::preformatted_site + 1;
+    // Checked on every log call, so it is read without taking the lock.
+    std::atomic<bool> binary_log_open = false;
+
+    std::string_view make_string_view(const char* value) {
+        return value == nullptr ? std::string_view{} : std::string_view{ value };
+    }
+
+    void flush_binary_log() {
+        binary_log_file.write(binary_log_buffer.data(), static_cast<std::streamsize>(binary_log_buffer.size()));
+        binary_log_file.flush();
+        binary_log_buffer.clear();
+    }
+
+    void write_binary_record(const std::string& record, bool flush_immediately) {
+        std::lock_guard lock{ binary_log_lock };
+        if (!binary_log_open) {
+            return;
+        }
+
+        binary_log_buffer += record;
+        if (flush_immediately || binary_log_buffer.size() >= flush_threshold) {
+            flush_binary_log();
+        }
+    }
+
+    void write_message_record(std::uint32_t site_id, std::uint8_t message_type, const char* arguments, std::size_t arguments_size) {
+        using namespace logger_module::binary_log;
+
+        std::uint64_t timestamp = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - starting_time).count()
+        );
+
+        /* Program messages (types 4-7) carry the thread and the thread group they were logged from. */
+        current_thread_information thread_information = message_type >= 4 ?
+            get_current_thread_information() : current_thread_information{};
+
+        std::string record{};
+        record.reserve(38 + arguments_size);
+
+        append_value(record, record_type::message);
+        append_value(record, site_id);
+        append_value(record, message_type);
+        append_value(record, timestamp);
+        append_value(record, thread_information.thread_id);
+        append_value(record, thread_information.thread_group_id);
+        append_value(record, static_cast<std::uint32_t>(arguments_size));
+        record.append(arguments, arguments_size);
+
+        /* Errors are written right away, the process may not live long enough to flush them later. */
+        write_binary_record(record, message_type % 4 >= 2);
+    }
+}
+
+bool open_binary_log(const std::filesystem::path& path) {
+    std::lock_guard lock{ binary_log_lock };
+    binary_log_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!binary_log_file.is_open()) {
+        return false;
+    }
+
+    binary_log_buffer.reserve(flush_threshold);
+    binary_log_buffer.append(std::begin(logger_module::binary_log::signature), std::end(logger_module::binary_log::signature));
+    logger_module::binary_log::append_value(binary_log_buffer, logger_module::binary_log::version);
+
+    binary_log_open.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void close_binary_log() {
+    std::lock_guard lock{ binary_log_lock };
+    if (binary_log_open) {
+        flush_binary_log();
+        binary_log_file.close();
+        binary_log_open.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool is_binary_log_open() {
+    return binary_log_open.load(std::memory_order_relaxed);
+}
+
+void write_preformatted_binary_message(
+    std::uint8_t message_type,
+    const char* file_name,
+    std::size_t file_line,
+    const char* function_name,
+    const char* module_name,
+    const char* message
+) {
+    std::string arguments{};
+    logger_module::binary_log::append_argument(arguments, make_string_view(file_name));
+    logger_module::binary_log::append_argument(arguments, static_cast<std::uint64_t>(file_line));
+    logger_module::binary_log::append_argument(arguments, make_string_view(function_name));
+    logger_module::binary_log::append_argument(arguments, make_string_view(module_name));
+    logger_module::binary_log::append_argument(arguments, make_string_view(message));
+
+    write_message_record(logger_module::binary_log::preformatted_site, message_type, arguments.data(), arguments.size());
+}
+
+module_mediator::return_value is_binary_log_enabled(module_mediator::arguments_string_type) {
+    return is_binary_log_open();
+}
+
+module_mediator::return_value register_binary_log_site(module_mediator::arguments_string_type bundle) {
+    using namespace logger_module::binary_log;
+
+    auto [file_name, file_line, function_name, module_name, message_type, format, format_size] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory,
+            module_mediator::eight_bytes,
+            module_mediator::memory,
+            module_mediator::memory,
+            module_mediator::one_byte,
+            module_mediator::memory,
+            module_mediator::eight_bytes
+        >(bundle);
+
+    std::uint32_t site_id = next_site_id.fetch_add(1, std::memory_order_relaxed);
+
+    std::string record{};
+    append_value(record, record_type::site);
+    append_value(record, site_id);
+    append_value(record, message_type);
+    append_value(record, static_cast<std::uint64_t>(file_line));
+    append_string(record, make_string_view(static_cast<char*>(file_name)));
+    append_string(record, make_string_view(static_cast<char*>(function_name)));
+    append_string(record, make_string_view(static_cast<char*>(module_name)));
+    append_string(record, std::string_view{ static_cast<char*>(format), format_size });
+
+    write_binary_record(record, false);
+    return site_id;
+}
+
+module_mediator::return_value binary_log_message(module_mediator::arguments_string_type bundle) {
+    auto [site_id, message_type, arguments, arguments_size] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::eight_bytes,
+            module_mediator::one_byte,
+            module_mediator::memory,
+            module_mediator::eight_bytes
+        >(bundle);
+
+    write_message_record(static_cast<std::uint32_t>(site_id), message_type, static_cast<char*>(arguments), arguments_size);
+    return module_mediator::module_success;
+}
@@ -0,0 +1,23 @@
+#ifndef LOGGER_MODULE_BINARY_LOG_H
+#define LOGGER_MODULE_BINARY_LOG_H
+
+#include "pch.h"
+#include "logger_module.h"
+
+// Binary log is written instead of the text log if FSI_BINARY_LOG names a file. Use fsi-log-decoder to read it.
+// Records are buffered and written when the buffer grows past 1 MiB, on errors, and when the logger is unloaded.
+bool open_binary_log(const std::filesystem::path& path);
+void close_binary_log();
+bool is_binary_log_open();
+
+// Stores a message that was formatted before it reached the logger. Message types are the ones used by LOG_* macros.
+void write_preformatted_binary_message(
+    std::uint8_t message_type,
+    const char* file_name,
+    std::size_t file_line,
+    const char* function_name,
+    const char* module_name,
+    const char* message
+);
+
+#endif
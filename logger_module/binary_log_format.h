@@ -0,0 +1,96 @@
+#ifndef LOGGER_MODULE_BINARY_LOG_FORMAT_H
+#define LOGGER_MODULE_BINARY_LOG_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <format>
+#include <type_traits>
+
+// Layout of binary logs. Shared by the modules that emit log messages, the logger, and the log decoder.
+// A log starts with the signature and the version, followed by records. Values are stored in the native byte order.
+// Site record:    record type, site id (4), message type (1), line (8), file, function, module, format.
+// Message record: record type, site id (4), message type (1), timestamp (8), thread id (8), thread group id (8),
+//                 arguments size (4), arguments.
+// Strings are stored as their size (4) followed by their bytes. Empty strings stand for unspecified values.
+// Every argument is stored as its type (1) followed by its value: 8 bytes for numbers and pointers, 1 byte for
+// booleans and characters, a string for strings.
+namespace logger_module::binary_log {
+    inline constexpr char signature[]{ 'F', 'S', 'I', 'L' };
+    inline constexpr std::uint32_t version = 1;
+
+    // Messages that were formatted before they reached the logger (e.g. program messages) are stored with this site id.
+    // Their arguments are file name, line, function name, module name, and message.
+    inline constexpr std::uint32_t preformatted_site = 0;
+
+    enum class record_type : std::uint8_t {
+        site = 1,
+        message = 2
+    };
+
+    enum class argument_type : std::uint8_t {
+        unsigned_integer,
+        signed_integer,
+        floating_point,
+        boolean,
+        character,
+        pointer,
+        string
+    };
+
+    template<typename value_type>
+    void append_value(std::string& buffer, value_type value) {
+        static_assert(std::is_trivially_copyable_v<value_type>);
+
+        char bytes[sizeof(value_type)]{};
+        std::memcpy(bytes, &value, sizeof(value_type));
+        buffer.append(bytes, sizeof(value_type));
+    }
+
+    inline void append_string(std::string& buffer, std::string_view value) {
+        append_value(buffer, static_cast<std::uint32_t>(value.size()));
+        buffer.append(value);
+    }
+
+    // Arguments are stored as they are, so the message is formatted only when the log is decoded.
+    // Types that don't have a binary representation are formatted right away and stored as strings.
+    template<typename argument_value_type>
+    void append_argument(std::string& buffer, const argument_value_type& argument) {
+        using decayed_type = std::remove_cvref_t<argument_value_type>;
+        if constexpr (std::is_same_v<decayed_type, bool>) {
+            append_value(buffer, argument_type::boolean);
+            append_value(buffer, static_cast<std::uint8_t>(argument));
+        }
+        else if constexpr (std::is_same_v<decayed_type, char>) {
+            append_value(buffer, argument_type::character);
+            append_value(buffer, argument);
+        }
+        else if constexpr (std::is_integral_v<decayed_type> && std::is_signed_v<decayed_type>) {
+            append_value(buffer, argument_type::signed_integer);
+            append_value(buffer, static_cast<std::int64_t>(argument));
+        }
+        else if constexpr (std::is_integral_v<decayed_type>) {
+            append_value(buffer, argument_type::unsigned_integer);
+            append_value(buffer, static_cast<std::uint64_t>(argument));
+        }
+        else if constexpr (std::is_floating_point_v<decayed_type>) {
+            append_value(buffer, argument_type::floating_point);
+            append_value(buffer, static_cast<double>(argument));
+        }
+        else if constexpr (std::is_convertible_v<const decayed_type&, std::string_view>) {
+            append_value(buffer, argument_type::string);
+            append_string(buffer, std::string_view{ argument });
+        }
+        else if constexpr (std::is_pointer_v<decayed_type> || std::is_null_pointer_v<decayed_type>) {
+            append_value(buffer, argument_type::pointer);
+            append_value(buffer, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(static_cast<const void*>(argument))));
+        }
+        else {
+            append_value(buffer, argument_type::string);
+            append_string(buffer, std::format("{}", argument));
+        }
+    }
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "logger_module.h"
 #include "module_interoperation.h"
+#include "binary_log.h"
 #include "../module_mediator/fsi_types.h"
 
 extern std::chrono::steady_clock::time_point starting_time;
@@ -50,6 +51,54 @@ namespace {
         synchronized_logger << ']';
     }
 
+    // Slots are never removed, modules keep pointers to them for as long as the logger is loaded.
+    struct log_level_slot {
+        std::string module_name;
+        std::atomic<std::uint8_t> minimum_level;
+    };
+
+    constexpr std::size_t max_log_level_slots = 64;
+    constexpr std::uint8_t log_level_none = 4;
+
+    std::mutex log_levels_lock;
+    std::array<log_level_slot, max_log_level_slots> log_level_slots{};
+    std::size_t log_level_slots_count = 0;
+
+    // Used for modules that don't specify their name and for modules that didn't fit into the table.
+    std::atomic<std::uint8_t> shared_minimum_level = 0;
+    std::uint8_t default_minimum_level = 0;
+
+    std::atomic<std::uint8_t>* find_log_level_slot(const char* module_name) {
+        if (module_name == nullptr) {
+            return &shared_minimum_level;
+        }
+
+        for (std::size_t index = 0; index < log_level_slots_count; ++index) {
+            if (log_level_slots[index].module_name == module_name) {
+                return &log_level_slots[index].minimum_level;
+            }
+        }
+
+        if (log_level_slots_count == max_log_level_slots) {
+            return &shared_minimum_level;
+        }
+
+        log_level_slot& slot = log_level_slots[log_level_slots_count++];
+        slot.module_name = module_name;
+        slot.minimum_level.store(default_minimum_level, std::memory_order_relaxed);
+
+        return &slot.minimum_level;
+    }
+
+    // Changes the level of every module, including the ones that will ask for it later.
+    void set_default_log_level(std::uint8_t level) {
+        default_minimum_level = level;
+        shared_minimum_level.store(level, std::memory_order_relaxed);
+        for (std::size_t index = 0; index < log_level_slots_count; ++index) {
+            log_level_slots[index].minimum_level.store(level, std::memory_order_relaxed);
+        }
+    }
+
     void log_message(message_type type, const char* file_name, std::size_t file_line, const char* function_name, const char* module_name, const char* message) {
         auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - starting_time).count();
         std::osyncstream synchronized_logger{ std::cerr };
@@ -78,6 +127,19 @@ namespace {
                 module_mediator::memory
             >(bundle);
 
+        if (is_binary_log_open()) {
+            write_preformatted_binary_message(
+                static_cast<std::uint8_t>(type),
+                static_cast<char*>(file_name),
+                file_line,
+                static_cast<char*>(function_name),
+                static_cast<char*>(module_name),
+                static_cast<char*>(message)
+            );
+
+            return;
+        }
+
         log_message(
             type,
             static_cast<char*>(file_name),
@@ -98,25 +160,27 @@ namespace {
                 module_mediator::memory
             >(bundle);
 
-        module_mediator::return_value current_thread_id = module_mediator::fast_call(
-            get_module_part(),
-            index_getter::excm(),
-            index_getter::excm_get_current_thread_id()
-        );
+        if (is_binary_log_open()) {
+            write_preformatted_binary_message(
+                static_cast<std::uint8_t>(static_cast<std::uint8_t>(type) + 4),
+                static_cast<char*>(file_name),
+                file_line,
+                static_cast<char*>(function_name),
+                static_cast<char*>(module_name),
+                static_cast<char*>(message)
+            );
 
-        module_mediator::return_value current_thread_group_id = module_mediator::fast_call(
-            get_module_part(),
-            index_getter::excm(),
-            index_getter::excm_get_current_thread_group_id()
-        );
+            return;
+        }
 
+        const current_thread_information& thread_information = get_current_thread_information();
         std::stringstream stream{};
-        if (current_thread_id == 0 && current_thread_group_id == 0) {
+        if (thread_information.thread_id == 0 && thread_information.thread_group_id == 0) {
             stream << "[ENGINE";
         }
         else {
-            stream << "[THREAD: " << current_thread_id;
-            stream << ", THREAD GROUP: " << current_thread_group_id;
+            stream << "[THREAD: " << thread_information.thread_id;
+            stream << ", THREAD GROUP: " << thread_information.thread_group_id;
         }
 
         stream << "] " << static_cast<char*>(message);
@@ -131,6 +195,41 @@ namespace {
     }
 }
 
+void configure_log_levels(std::string_view configuration) {
+    constexpr std::string_view level_names[]{ "info", "warning", "error", "fatal", "none" };
+    auto parse_level = [&](std::string_view name) -> std::optional<std::uint8_t> {
+        auto level = std::find(std::begin(level_names), std::end(level_names), name);
+        if (level == std::end(level_names)) {
+            return std::nullopt;
+        }
+
+        return static_cast<std::uint8_t>(level - std::begin(level_names));
+    };
+
+    std::lock_guard lock{ log_levels_lock };
+    while (!configuration.empty()) {
+        std::size_t entry_end = std::min(configuration.find(';'), configuration.size());
+        std::string_view entry = configuration.substr(0, entry_end);
+        configuration.remove_prefix(std::min(entry_end + 1, configuration.size()));
+
+        /* An entry is either "level" or "module name=level". */
+        std::size_t separator = entry.rfind('=');
+        std::optional<std::uint8_t> level = parse_level(separator == std::string_view::npos ? entry : entry.substr(separator + 1));
+        if (!level.has_value()) {
+            std::cerr << "Unknown log level in '" << entry << "', the entry is ignored." << '\n';
+            continue;
+        }
+
+        if (separator == std::string_view::npos) {
+            set_default_log_level(*level);
+        }
+        else {
+            std::string module_name{ entry.substr(0, separator) };
+            find_log_level_slot(module_name.c_str())->store(*level, std::memory_order_relaxed);
+        }
+    }
+}
+
 module_mediator::return_value info(module_mediator::arguments_string_type bundle) {
     generic_log_message(message_type::info, bundle);
     return module_mediator::module_success;
@@ -170,3 +269,24 @@ module_mediator::return_value program_fatal(module_mediator::arguments_string_ty
     generic_log_message_with_thread_information(message_type::fatal, bundle);
     return module_mediator::module_success;
 }
+
+module_mediator::return_value get_log_level(module_mediator::arguments_string_type bundle) {
+    auto [module_name] = module_mediator::arguments_string_builder::unpack<module_mediator::memory>(bundle);
+
+    std::lock_guard lock{ log_levels_lock };
+    return reinterpret_cast<std::uintptr_t>(find_log_level_slot(static_cast<char*>(module_name)));
+}
+
+module_mediator::return_value set_log_level(module_mediator::arguments_string_type bundle) {
+    auto [module_name, level] = module_mediator::arguments_string_builder::unpack<module_mediator::memory, module_mediator::one_byte>(bundle);
+    level = std::min(level, log_level_none);
+
+    std::lock_guard lock{ log_levels_lock };
+    if (module_name != nullptr) {
+        find_log_level_slot(static_cast<char*>(module_name))->store(level, std::memory_order_relaxed);
+        return module_mediator::module_success;
+    }
+
+    set_default_log_level(level);
+    return module_mediator::module_success;
+}
@@ -20,6 +20,25 @@ CONSOLEANDDEBUG_API module_mediator::return_value program_warning(module_mediato
 CONSOLEANDDEBUG_API module_mediator::return_value program_error(module_mediator::arguments_string_type bundle);
 CONSOLEANDDEBUG_API module_mediator::return_value program_fatal(module_mediator::arguments_string_type bundle);
 
+// Returns a pointer to the minimum log level of a module. The level is checked by LOG_* macros before a message is built.
+CONSOLEANDDEBUG_API module_mediator::return_value get_log_level(module_mediator::arguments_string_type bundle);
+
+// Changes the minimum log level of a module at runtime. Null module name changes the level of every module.
+CONSOLEANDDEBUG_API module_mediator::return_value set_log_level(module_mediator::arguments_string_type bundle);
+
+// Binary log functions, used by LOG_* macros instead of the functions above when the binary log is enabled.
+// Returns 1 if the binary log is enabled, 0 otherwise.
+CONSOLEANDDEBUG_API module_mediator::return_value is_binary_log_enabled(module_mediator::arguments_string_type bundle);
+
+// Returns the id of a new call site.
+CONSOLEANDDEBUG_API module_mediator::return_value register_binary_log_site(module_mediator::arguments_string_type bundle);
+CONSOLEANDDEBUG_API module_mediator::return_value binary_log_message(module_mediator::arguments_string_type bundle);
+
 CONSOLEANDDEBUG_API void initialize_m(module_mediator::module_part*);
+CONSOLEANDDEBUG_API void free_m();
+
+// Applies levels in the FSI_LOG_LEVEL format: entries separated by ';', each one is either "level" (the default for all modules)
+// or "module name=level". Module names are the ones shown in the log, levels are info, warning, error, fatal, and none.
+void configure_log_levels(std::string_view configuration);
 
 #endif
@@ -2,21 +2,22 @@
 #define MODULES_LOGGING_H
 
 #ifdef DISABLE_LOGGING
-#define LOG_INFO(part, message) ((void)0)
-#define LOG_WARNING(part, message) ((void)0)
-#define LOG_ERROR(part, message) ((void)0)
-#define LOG_FATAL(part, message) ((void)0)
-
-#define LOG_PROGRAM_INFO(part, message) ((void)0)
-#define LOG_PROGRAM_WARNING(part, message) ((void)0)
-#define LOG_PROGRAM_ERROR(part, message) ((void)0)
-#define LOG_PROGRAM_FATAL(part, message) ((void)0)
+#define LOG_INFO(part, ...) ((void)0)
+#define LOG_WARNING(part, ...) ((void)0)
+#define LOG_ERROR(part, ...) ((void)0)
+#define LOG_FATAL(part, ...) ((void)0)
+
+#define LOG_PROGRAM_INFO(part, ...) ((void)0)
+#define LOG_PROGRAM_WARNING(part, ...) ((void)0)
+#define LOG_PROGRAM_ERROR(part, ...) ((void)0)
+#define LOG_PROGRAM_FATAL(part, ...) ((void)0)
 #else
 
 #include <string>
 #include <iostream>
 #include <atomic>
 
+#include "binary_log_format.h"
 #include "../module_mediator/fsi_types.h"
 #include "../module_mediator/module_part.h"
 #include "../startup_components/local_crash_handlers.h"
@@ -24,6 +25,16 @@
 #define ONLY_FILE_NAME strrchr("\\" __FILE__, '\\') + 1 
 
 namespace logger_module {
+    // Messages below the minimum level of a module are discarded before they are built.
+    // Program variants (message types 4-7) share the levels of their engine counterparts.
+    enum class log_level : std::uint8_t {
+        info,
+        warning,
+        error,
+        fatal,
+        none
+    };
+
     class global_logging_instance {
         static inline std::atomic_flag logging_enabled = ATOMIC_FLAG_INIT;
 
@@ -42,6 +53,128 @@ namespace logger_module {
         }
     };
 
+    inline std::size_t get_logger_index(module_mediator::module_part* part) {
+        static std::size_t logger = part->find_module_index("logger");
+        if (logger == module_mediator::module_part::module_not_found) {
+            std::cerr << "One of the modules uses logging. 'logger' was not found. Terminating the process." << '\n';
+            ENVIRONMENT_REQUEST_TERMINATION();
+        }
+
+        return logger;
+    }
+
+    inline std::size_t get_logger_function_index(module_mediator::module_part* part, const char* function_name) {
+        std::size_t function = part->find_function_index(get_logger_index(part), function_name);
+        if (function == module_mediator::module_part::function_not_found) {
+            std::cerr << "One of the required logging functions was not found. Terminating the process." << '\n';
+            ENVIRONMENT_REQUEST_TERMINATION();
+        }
+
+        return function;
+    }
+
+    // The level itself is owned by the logger module, so it can be changed at runtime with set_log_level.
+    // Every module gets its own level, looked up by the module name on the first use.
+    inline const std::atomic<std::uint8_t>* find_module_log_level(module_mediator::module_part* part) {
+        return reinterpret_cast<const std::atomic<std::uint8_t>*>(
+            module_mediator::fast_call<module_mediator::memory>(
+                part,
+                get_logger_index(part),
+                get_logger_function_index(part, "get_log_level"),
+#ifdef LOGGER_MODULE_EMITTER_MODULE_NAME
+                const_cast<char*>(LOGGER_MODULE_EMITTER_MODULE_NAME)
+#else
+                nullptr
+#endif
+            )
+        );
+    }
+
+    // Called by LOG_* macros before the message is evaluated. Costs two atomic loads when the message is discarded.
+    inline bool is_log_level_enabled(module_mediator::module_part* part, std::size_t message_type) {
+        if (!global_logging_instance::is_logging_enabled()) {
+            return false;
+        }
+
+        static const std::atomic<std::uint8_t>* minimum_level = find_module_log_level(part);
+        return message_type % 4 >= minimum_level->load(std::memory_order_relaxed);
+    }
+
+    // Binary log mode is chosen by the logger when it is loaded and doesn't change afterwards.
+    inline bool is_binary_log_enabled(module_mediator::module_part* part) {
+        static bool binary_log_enabled = module_mediator::fast_call(
+            part,
+            get_logger_index(part),
+            get_logger_function_index(part, "is_binary_log_enabled")
+        ) != 0;
+
+        return binary_log_enabled;
+    }
+
+    // Every LOG_* call site has its own id. It is registered in the binary log on the first use, together with
+    // everything about the call site that doesn't change: file, line, function, module, and format string.
+    using log_site_id = std::atomic<std::uint32_t>;
+
+    inline void binary_log_message(
+        module_mediator::module_part* part,
+        std::size_t message_type,
+        log_site_id& site,
+        const char* file_name,
+        std::size_t file_line,
+        const char* function_name,
+        const char* module_name,
+        std::string_view format,
+        std::string& arguments
+    ) {
+        std::size_t logger = get_logger_index(part);
+        static std::size_t register_site = get_logger_function_index(part, "register_binary_log_site");
+        static std::size_t log_arguments = get_logger_function_index(part, "binary_log_message");
+
+        std::uint32_t site_id = site.load(std::memory_order_relaxed);
+        if (site_id == binary_log::preformatted_site) {
+            /* Two threads may register the same site at the same time, the decoder doesn't care which id is used. */
+            site_id = static_cast<std::uint32_t>(
+                module_mediator::fast_call<
+                    module_mediator::memory,
+                    module_mediator::eight_bytes,
+                    module_mediator::memory,
+                    module_mediator::memory,
+                    module_mediator::one_byte,
+                    module_mediator::memory,
+                    module_mediator::eight_bytes
+                >(
+                    part,
+                    logger,
+                    register_site,
+                    const_cast<char*>(file_name),
+                    file_line,
+                    const_cast<char*>(function_name),
+                    const_cast<char*>(module_name),
+                    static_cast<module_mediator::one_byte>(message_type),
+                    const_cast<char*>(format.data()),
+                    format.size()
+                )
+            );
+
+            site.store(site_id, std::memory_order_relaxed);
+        }
+
+        module_mediator::fast_call<
+            module_mediator::eight_bytes,
+            module_mediator::one_byte,
+            module_mediator::memory,
+            module_mediator::eight_bytes
+        >(
+            part,
+            logger,
+            log_arguments,
+            site_id,
+            static_cast<module_mediator::one_byte>(message_type),
+            arguments.data(),
+            arguments.size()
+        );
+    }
+
     inline void generic_log_message(
         module_mediator::module_part* part,
         std::size_t message_type,
@@ -61,12 +194,7 @@ namespace logger_module {
             return;
         }
 
-        static std::size_t logger = part->find_module_index("logger");
-        if (logger == module_mediator::module_part::module_not_found) {
-            std::cerr << "One of the modules uses logging. 'logger' was not found. Terminating the process." << '\n';
-            ENVIRONMENT_REQUEST_TERMINATION();
-        }
-
+        std::size_t logger = get_logger_index(part);
         static std::size_t info = part->find_function_index(logger, "info");
         static std::size_t warning = part->find_function_index(logger, "warning");
         static std::size_t error = part->find_function_index(logger, "error");
@@ -107,33 +235,104 @@ namespace logger_module {
             message.data()
         );
     }
-}
 
+    // Used by LOG_* macros when the message is already built.
+    inline void log_message(
+        module_mediator::module_part* part,
+        std::size_t message_type,
+        log_site_id& site,
+        const char* file_name,
+        std::size_t file_line,
+        const char* function_name,
+        [[maybe_unused]] const char* module_name,
+        std::string message
+    ) {
+        if (is_binary_log_enabled(part)) {
+            std::string arguments{};
+            binary_log::append_argument(arguments, message);
+            binary_log_message(part, message_type, site, file_name, file_line, function_name, module_name, "{}", arguments);
+
+            return;
+        }
+
+        generic_log_message(
+            part,
+            message_type,
+            file_name,
+            file_line,
+            function_name,
 #ifdef LOGGER_MODULE_EMITTER_MODULE_NAME
+            module_name,
+#endif
+            std::move(message)
+        );
+    }
 
-#define LOG_INFO(part, message) logger_module::generic_log_message(part, 0, ONLY_FILE_NAME, __LINE__, __func__, LOGGER_MODULE_EMITTER_MODULE_NAME, message)
-#define LOG_WARNING(part, message) logger_module::generic_log_message(part, 1, ONLY_FILE_NAME, __LINE__, __func__, LOGGER_MODULE_EMITTER_MODULE_NAME, message)
-#define LOG_ERROR(part, message) logger_module::generic_log_message(part, 2, ONLY_FILE_NAME, __LINE__, __func__, LOGGER_MODULE_EMITTER_MODULE_NAME, message)
-#define LOG_FATAL(part, message) logger_module::generic_log_message(part, 3, ONLY_FILE_NAME, __LINE__, __func__, LOGGER_MODULE_EMITTER_MODULE_NAME, message)
+    // Used by LOG_* macros when the message is given as a format string and its arguments.
+    // In binary log mode the message is never formatted, arguments are passed to the logger as they are.
+    template<typename first_argument_type, typename... other_argument_types>
+    void log_message(
+        module_mediator::module_part* part,
+        std::size_t message_type,
+        log_site_id& site,
+        const char* file_name,
+        std::size_t file_line,
+        const char* function_name,
+        const char* module_name,
+        std::format_string<first_argument_type, other_argument_types...> format,
+        first_argument_type&& first_argument,
+        other_argument_types&&... other_arguments
+    ) {
+        if (is_binary_log_enabled(part)) {
+            std::string arguments{};
+            binary_log::append_argument(arguments, first_argument);
+            (binary_log::append_argument(arguments, other_arguments), ...);
+            binary_log_message(part, message_type, site, file_name, file_line, function_name, module_name, format.get(), arguments);
 
-#define LOG_PROGRAM_INFO(part, message) logger_module::generic_log_message(part, 4, ONLY_FILE_NAME, __LINE__, __func__, LOGGER_MODULE_EMITTER_MODULE_NAME, message)
-#define LOG_PROGRAM_WARNING(part, message) logger_module::generic_log_message(part, 5, ONLY_FILE_NAME, __LINE__, __func__, LOGGER_MODULE_EMITTER_MODULE_NAME, message)
-#define LOG_PROGRAM_ERROR(part, message) logger_module::generic_log_message(part, 6, ONLY_FILE_NAME, __LINE__, __func__, LOGGER_MODULE_EMITTER_MODULE_NAME, message)
-#define LOG_PROGRAM_FATAL(part, message) logger_module::generic_log_message(part, 7, ONLY_FILE_NAME, __LINE__, __func__, LOGGER_MODULE_EMITTER_MODULE_NAME, message)
+            return;
+        }
 
+        log_message(
+            part,
+            message_type,
+            site,
+            file_name,
+            file_line,
+            function_name,
+            module_name,
+            std::format(
+                format,
+                std::forward<first_argument_type>(first_argument),
+                std::forward<other_argument_types>(other_arguments)...
+            )
+        );
+    }
+}
+
+#ifdef LOGGER_MODULE_EMITTER_MODULE_NAME
+#define LOGGER_MODULE_EMITTER_NAME LOGGER_MODULE_EMITTER_MODULE_NAME
 #else
+#define LOGGER_MODULE_EMITTER_NAME nullptr
+#endif
 
-#define LOG_INFO(part, message) logger_module::generic_log_message(part, 0, ONLY_FILE_NAME, __LINE__, __func__, message)
-#define LOG_WARNING(part, message) logger_module::generic_log_message(part, 1, ONLY_FILE_NAME, __LINE__, __func__, message)
-#define LOG_ERROR(part, message) logger_module::generic_log_message(part, 2, ONLY_FILE_NAME, __LINE__, __func__, message)
-#define LOG_FATAL(part, message) logger_module::generic_log_message(part, 3, ONLY_FILE_NAME, __LINE__, __func__, message)
+#define LOGGER_MODULE_LOG_SITE_ID() ([]() -> logger_module::log_site_id& { static logger_module::log_site_id site{}; return site; }())
 
-#define LOG_PROGRAM_INFO(part, message) logger_module::generic_log_message(part, 4, ONLY_FILE_NAME, __LINE__, __func__, message)
-#define LOG_PROGRAM_WARNING(part, message) logger_module::generic_log_message(part, 5, ONLY_FILE_NAME, __LINE__, __func__, message)
-#define LOG_PROGRAM_ERROR(part, message) logger_module::generic_log_message(part, 6, ONLY_FILE_NAME, __LINE__, __func__, message)
-#define LOG_PROGRAM_FATAL(part, message) logger_module::generic_log_message(part, 7, ONLY_FILE_NAME, __LINE__, __func__, message)
+// A message is either a string or a format string followed by its arguments, the same ones std::format accepts.
+// The message is evaluated only if its level is enabled.
+#define LOGGER_MODULE_LOG_MESSAGE(part, message_type, ...) \
+    (logger_module::is_log_level_enabled(part, message_type) ? \
+        logger_module::log_message(part, message_type, LOGGER_MODULE_LOG_SITE_ID(), ONLY_FILE_NAME, __LINE__, __func__, LOGGER_MODULE_EMITTER_NAME, __VA_ARGS__) : \
+        (void)0)
 
-#endif
+#define LOG_INFO(part, ...) LOGGER_MODULE_LOG_MESSAGE(part, 0, __VA_ARGS__)
+#define LOG_WARNING(part, ...) LOGGER_MODULE_LOG_MESSAGE(part, 1, __VA_ARGS__)
+#define LOG_ERROR(part, ...) LOGGER_MODULE_LOG_MESSAGE(part, 2, __VA_ARGS__)
+#define LOG_FATAL(part, ...) LOGGER_MODULE_LOG_MESSAGE(part, 3, __VA_ARGS__)
+
+#define LOG_PROGRAM_INFO(part, ...) LOGGER_MODULE_LOG_MESSAGE(part, 4, __VA_ARGS__)
+#define LOG_PROGRAM_WARNING(part, ...) LOGGER_MODULE_LOG_MESSAGE(part, 5, __VA_ARGS__)
+#define LOG_PROGRAM_ERROR(part, ...) LOGGER_MODULE_LOG_MESSAGE(part, 6, __VA_ARGS__)
+#define LOG_PROGRAM_FATAL(part, ...) LOGGER_MODULE_LOG_MESSAGE(part, 7, __VA_ARGS__)
 
 #endif
 
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "logger_module.h"
 #include "module_interoperation.h"
+#include "binary_log.h"
 
 #include "../module_mediator/module_part.h"
 
@@ -16,4 +17,20 @@ extern std::chrono::steady_clock::time_point starting_time;
 void initialize_m(module_mediator::module_part* module_part) {
 	part = module_part;
 	starting_time = std::chrono::steady_clock::now();
+
+	char configuration[1024]{};
+	DWORD dwConfigurationSize = GetEnvironmentVariableA("FSI_LOG_LEVEL", configuration, static_cast<DWORD>(std::size(configuration)));
+	if (dwConfigurationSize != 0 && dwConfigurationSize < std::size(configuration)) {
+		configure_log_levels(std::string_view{ configuration, dwConfigurationSize });
+	}
+
+	wchar_t binary_log_path[MAX_PATH]{};
+	DWORD dwBinaryLogPathSize = GetEnvironmentVariableW(L"FSI_BINARY_LOG", binary_log_path, static_cast<DWORD>(std::size(binary_log_path)));
+	if (dwBinaryLogPathSize != 0 && dwBinaryLogPathSize < std::size(binary_log_path) && !open_binary_log(binary_log_path)) {
+		std::cerr << "Unable to open the binary log file, text log will be used instead." << '\n';
+	}
+}
+
+void free_m() {
+	close_binary_log();
 }
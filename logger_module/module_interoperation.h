@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "../module_mediator/module_part.h"
+#include "../execution_module/current_thread_information.h"
 
 module_mediator::module_part* get_module_part();
 class index_getter {
@@ -12,15 +13,33 @@ public:
 		return index;
 	}
 
-	static std::size_t excm_get_current_thread_id() {
-		static std::size_t index = get_module_part()->find_function_index(excm(), "get_current_thread_id");
+	static std::size_t excm_get_current_thread_information() {
+		static std::size_t index = get_module_part()->find_function_index(excm(), "get_current_thread_information");
 		return index;
 	}
+};
 
-	static std::size_t excm_get_current_thread_group_id() {
-		static std::size_t index = get_module_part()->find_function_index(excm(), "get_current_thread_group_id");
-		return index;
+// The execution module keeps the ids of the running program thread in a per-thread structure and updates it on every
+// context switch. Its address is asked for once per system thread, after that the ids are read without calling the module.
+inline const current_thread_information& get_current_thread_information() {
+	static const current_thread_information engine_thread_information{};
+	thread_local const current_thread_information* cached_thread_information = nullptr;
+	if (cached_thread_information == nullptr) {
+		cached_thread_information = reinterpret_cast<const current_thread_information*>(
+			module_mediator::fast_call(
+				get_module_part(),
+				index_getter::excm(),
+				index_getter::excm_get_current_thread_information()
+			)
+		);
+
+		/* System threads that the execution module doesn't know about never run program threads. */
+		if (cached_thread_information == nullptr) {
+			cached_thread_information = &engine_thread_information;
+		}
 	}
-};
+
+	return *cached_thread_information;
+}
 
 #endif
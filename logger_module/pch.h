@@ -18,5 +18,15 @@
 #include <syncstream>
 #include <format>
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <array>
+#include <string>
+#include <algorithm>
+#include <string_view>
+#include <optional>
+#include <utility>
+#include <fstream>
+#include <filesystem>
 
 #endif
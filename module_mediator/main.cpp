@@ -17,6 +17,7 @@
 #include <filesystem>
 #include <format>
 #include <syncstream>
+#include <string_view>
 
 #include "fsi_types.h"
 #include "module_mediator.h"
@@ -153,6 +154,25 @@ namespace {
         return compressed_bytecode;
     }
 
+    // Must match the values of executors_placement::policy in the execution module.
+    module_mediator::one_byte parse_executors_placement_policy(std::string_view policy_name) {
+        if (policy_name == "none") {
+            return 0;
+        }
+
+        if (policy_name == "cores") {
+            return 1;
+        }
+
+        if (policy_name == "numa") {
+            return 2;
+        }
+
+        throw std::runtime_error{
+            std::format("Unknown executors placement policy: {}. Expected one of: none, cores, numa.", policy_name)
+        };
+    }
+
     module_mediator::module_part* global_module_part{ nullptr };
     BOOL CtrlHandler(DWORD dwCtrlType) {
         if (dwCtrlType == CTRL_C_EVENT) {
@@ -192,9 +212,9 @@ APPLICATION_ENTRYPOINT(LOGGER_MODULE_EMITTER_MODULE_NAME, FSI_PROJECT_VERSION, a
     // So we need to call this in each thread that the program uses.
     crash_handling::install_local_crash_handlers();
 
-    if (argc != 4) {
-        std::cerr << "You need to provide three arguments: text file with the modules descriptions, executors count and a compiled file." <<
-            '\n';
+    if (argc != 4 && argc != 5) {
+        std::cerr << "You need to provide three arguments: text file with the modules descriptions, executors count and a compiled file. " <<
+            "Optionally, you can also provide executors placement policy (none, cores, numa)." << '\n';
         return EXIT_FAILURE;
     }
 
@@ -222,17 +242,16 @@ APPLICATION_ENTRYPOINT(LOGGER_MODULE_EMITTER_MODULE_NAME, FSI_PROJECT_VERSION, a
             );
 
             std::uint16_t executors_count = static_cast<std::uint16_t>(std::stoi(argv[2])); //no point in starting an app if unable to parse the executors count
+            module_mediator::one_byte executors_placement_policy = argc == 5 ? parse_executors_placement_policy(argv[4]) : 0;
             std::filesystem::path decompressed_bytecode = decompress_bytecode(
                 consume_compressed_bytecode(argv[3])
             );
 
             LOG_PROGRAM_INFO(
                 global_module_part,
-                std::format(
-                    "Decompressed bytecode '{}' into file: '{}'.",
-                    argv[3],
-                    decompressed_bytecode.generic_string()
-                )
+                "Decompressed bytecode '{}' into file: '{}'.",
+                argv[3],
+                decompressed_bytecode.generic_string()
             );
 
             std::size_t program_loader = global_module_part->find_module_index("progload");
@@ -258,9 +277,10 @@ APPLICATION_ENTRYPOINT(LOGGER_MODULE_EMITTER_MODULE_NAME, FSI_PROJECT_VERSION, a
 
             std::size_t execution_module = global_module_part->find_module_index("excm");
             std::size_t startup = global_module_part->find_function_index(execution_module, "start");
-            module_mediator::fast_call<module_mediator::two_bytes>(
+            module_mediator::fast_call<module_mediator::two_bytes, module_mediator::one_byte>(
                 global_module_part, execution_module, startup,
-                executors_count
+                executors_count,
+                executors_placement_policy
             );
 
             std::size_t detach_from_stdio = global_module_part->find_function_index(program_runtime_services, "detach_from_stdio");
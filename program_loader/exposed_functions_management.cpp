@@ -26,8 +26,8 @@ void remove_exposed_functions(std::span<void*> function_addresses) {
             if (result != 1) {
                 LOG_WARNING(
                     interoperation::get_module_part(),
-                    std::format("Failed to remove exposed function with address {} "
-                                "from exposed functions list.", std::bit_cast<std::uintptr_t>(function_address))
+                    "Failed to remove exposed function with address {} "
+                    "from exposed functions list.", std::bit_cast<std::uintptr_t>(function_address)
                 );
             }
         }
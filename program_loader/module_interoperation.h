@@ -24,6 +24,11 @@ namespace interoperation {
             return index;
         }
 
+        static std::size_t resource_module_get_stack_guard_size() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "get_stack_guard_size");
+            return index;
+        }
+
         static std::size_t execution_module() {
             static std::size_t index = get_module_part()->find_module_index("excm");
             return index;
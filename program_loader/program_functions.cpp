@@ -1,9 +1,23 @@
 #include "pch.h"
 #include "program_functions.h"
+#include "module_interoperation.h"
 
 namespace {
-    std::uint32_t nullify_function_pointer_variables(std::vector<char>& destination, const memory_layouts_builder::memory_addresses& locals) {
-        std::uint32_t instructions_size = 0;
+    // Displacement of the stack end in the thread state, see program_state_manager in the execution module.
+    constexpr std::uint8_t thread_state_stack_end_displacement = 72;
+
+    bool is_stack_guarded() {
+        // The guard region doesn't change after the resource module is initialized.
+        static bool is_guarded = module_mediator::fast_call(
+            interoperation::get_module_part(),
+            interoperation::index_getter::resource_module(),
+            interoperation::index_getter::resource_module_get_stack_guard_size()
+        ) >= min_stack_guard_size;
+
+        return is_guarded;
+    }
+
+    void nullify_function_pointer_variables(std::vector<char>& destination, const memory_layouts_builder::memory_addresses& locals) {
         for (const auto& variable : locals | std::views::values) {
             if (variable.second == 4) { //if local is a pointer
                 destination.push_back('\x48');
@@ -11,12 +25,8 @@ namespace {
                 destination.push_back('\x85');
                 write_bytes(variable.first, destination);
                 write_bytes<std::uint32_t>(0, destination);
-
-                instructions_size += 11;
             }
         }
-
-        return instructions_size;
     }
 }
 
@@ -43,9 +53,15 @@ void generate_stack_allocation_code(std::vector<char>& destination, std::uint32_
 
     write_bytes(size, destination);
 
-    destination.push_back('\x4c'); //cmp rbp, r9
-    destination.push_back('\x39');
-    destination.push_back('\xcd');
+    // Small allocations rely on the guard region, see max_unchecked_stack_allocation.
+    if (size <= max_unchecked_stack_allocation && is_stack_guarded()) {
+        return;
+    }
+
+    destination.push_back('\x48'); //cmp rbp, [rcx + stack end]
+    destination.push_back('\x3b');
+    destination.push_back('\x69');
+    destination.push_back(static_cast<char>(thread_state_stack_end_displacement));
 
     destination.push_back('\x72'); //jb end
     destination.push_back(char{ program_termination_code_size });
@@ -68,6 +84,8 @@ void generate_stack_deallocation_code(std::vector<char>& destination, std::uint3
 }
 
 std::uint32_t generate_function_prologue(std::vector<char>& destination, std::uint32_t allocation_size, const memory_layouts_builder::memory_addresses& locals) {
+    std::size_t prologue_start = destination.size();
+
     destination.push_back('\x48'); //mov rax, [rsp]
     destination.push_back('\x8b');
     destination.push_back('\x04');
@@ -84,7 +102,10 @@ std::uint32_t generate_function_prologue(std::vector<char>& destination, std::ui
     destination.push_back('\x08');
 
     generate_stack_allocation_code(destination, allocation_size + 8); //8 = return address
-    return nullify_function_pointer_variables(destination, locals) + stack_allocation_code_size + 12;
+    nullify_function_pointer_variables(destination, locals);
+
+    // The stack check may be left out, so the size is measured.
+    return static_cast<std::uint32_t>(destination.size() - prologue_start);
 }
 
 void generate_function_epilogue(std::vector<char>& destination, std::uint32_t deallocation_size, std::uint32_t arguments_deallocation_size) {
@@ -6,9 +6,18 @@
 #include "program_termination_codes.h"
 
 constexpr std::uint32_t program_termination_code_size = 11;
-constexpr std::uint32_t stack_allocation_code_size = 12 + program_termination_code_size;
 constexpr std::uint32_t function_save_return_address_size = 12;
 
+/*
+* If thread stacks are followed by a guard region of at least min_stack_guard_size bytes (see get_stack_guard_size in the resource module),
+* stack allocations up to max_unchecked_stack_allocation bytes are not checked against the end of the stack,
+* the execution module turns an access to the guard region into a stack overflow. Every function writes its return address
+* to the top of the stack on entry, so the top can move by at most two unchecked allocations (locals and arguments)
+* between two writes, which is much less than the guard region.
+*/
+constexpr std::uint32_t max_unchecked_stack_allocation = 4096;
+constexpr std::uint64_t min_stack_guard_size = 16 * max_unchecked_stack_allocation;
+
 template<typename T>
 void write_bytes(T value, std::vector<char>& destination) {
 	char* symbols = reinterpret_cast<char*>(&value);
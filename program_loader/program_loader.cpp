@@ -437,10 +437,8 @@ namespace {
         if (compiled_function_body.empty()) {
             LOG_PROGRAM_WARNING(
                 interoperation::get_module_part(),
-                std::format(
-                    "Function with id {} has no executable code.",
-                    current_function.function_signature
-                )
+                "Function with id {} has no executable code.",
+                current_function.function_signature
             );
         }
 
@@ -572,8 +570,8 @@ namespace {
 
             image = std::get<application_image>(application_image_or_error);
             LOG_PROGRAM_INFO(interoperation::get_module_part(),
-                std::format("Built application image at {:#x}, length {} bytes.",
-                    std::bit_cast<std::uint64_t>(image.image_base), image.image_size));
+                "Built application image at {:#x}, length {} bytes.",
+                std::bit_cast<std::uint64_t>(image.image_base), image.image_size);
 
             module_mediator::return_value image_verification_result = module_mediator::fast_call<
                 module_mediator::memory, module_mediator::eight_bytes,
@@ -670,10 +668,8 @@ module_mediator::return_value load_program_to_memory(module_mediator::arguments_
     try {
         LOG_PROGRAM_INFO(
             interoperation::get_module_part(),
-            std::format(
-                "Starting a new program: \"{}\"...",
-                program_name
-            )
+            "Starting a new program: \"{}\"...",
+            program_name
         );
 
         // janky use of constructor for its side effects, I don't care about refactoring this 
@@ -703,23 +699,21 @@ module_mediator::return_value load_program_to_memory(module_mediator::arguments_
 
         LOG_PROGRAM_INFO(
             interoperation::get_module_part(),
-            std::format(
-                "Successfully compiled \"{}\":" \
-                "\n--> Preferred stack size:      {}" \
-                "\n--> Total function signatures: {}{}"
-                "\n--> Compiled functions count:  {}" \
-                "\n--> Exposed functions count:   {}" \
-                "\n--> Total loaded strings:      {}" \
-                "\n--> Total module dependencies: {}",
-                program_name,
-                result.preferred_stack_size,
-                container.function_signatures.size(),
-                container.function_signatures.size() == result.functions_count ? "" : " - DOES NOT MATCH FUNCTIONS COUNT",
-                result.functions_count,
-                result.exposed_functions_count,
-                result.program_strings_count,
-                container.modules.size()
-            )
+            "Successfully compiled \"{}\":" \
+            "\n--> Preferred stack size:      {}" \
+            "\n--> Total function signatures: {}{}"
+            "\n--> Compiled functions count:  {}" \
+            "\n--> Exposed functions count:   {}" \
+            "\n--> Total loaded strings:      {}" \
+            "\n--> Total module dependencies: {}",
+            program_name,
+            result.preferred_stack_size,
+            container.function_signatures.size(),
+            container.function_signatures.size() == result.functions_count ? "" : " - DOES NOT MATCH FUNCTIONS COUNT",
+            result.functions_count,
+            result.exposed_functions_count,
+            result.program_strings_count,
+            container.modules.size()
         );
 
         return add_program(
@@ -742,63 +736,51 @@ module_mediator::return_value load_program_to_memory(module_mediator::arguments_
         if (found_entity_name != container.entities_names.end()) {
             LOG_ERROR(
                 interoperation::get_module_part(),
-                std::format(
-                    "Failed to compile \"{}\": {} " \
-                    "(It appears that this error is related to the following object: '{}')",
-                    program_name,
-                    exc.what(),
-                    found_entity_name->second
-                )
+                "Failed to compile \"{}\": {} " \
+                "(It appears that this error is related to the following object: '{}')",
+                program_name,
+                exc.what(),
+                found_entity_name->second
             );
         }
         else if (exc.get_associated_id() != 0) { // Id 0 means that the error is not associated with any entity
             LOG_ERROR(
                 interoperation::get_module_part(),
-                std::format(
-                    "Failed to compile \"{}\": {} (The error is associated with the following id: '{}')",
-                    program_name,
-                    exc.what(),
-                    exc.get_associated_id()
-                )
+                "Failed to compile \"{}\": {} (The error is associated with the following id: '{}')",
+                program_name,
+                exc.what(),
+                exc.get_associated_id()
             );
         }
         else {
            LOG_ERROR(
                 interoperation::get_module_part(),
-                std::format(
-                    "Failed to compile \"{}\": {}",
-                    program_name,
-                    exc.what()
-                )
+                "Failed to compile \"{}\": {}",
+                program_name,
+                exc.what()
            );
         }
     }
     catch ([[maybe_unused]] const std::exception& exc) {
         LOG_ERROR(
             interoperation::get_module_part(),
-            std::format(
-                "Failed to compile \"{}\": {}",
-                program_name,
-                exc.what()
-            )
+            "Failed to compile \"{}\": {}",
+            program_name,
+            exc.what()
         );
     }
     catch (...) {
         LOG_ERROR(
             interoperation::get_module_part(),
-            std::format(
-                "\"{}\": Program compilation has failed with an unexpected exception.",
-                program_name
-            )
+            "\"{}\": Program compilation has failed with an unexpected exception.",
+            program_name
         );
     }
 
     LOG_ERROR(
         interoperation::get_module_part(),
-        std::format(
-            "\"{}\": Program compilation has failed.",
-            program_name
-        )
+        "\"{}\": Program compilation has failed.",
+        program_name
     );
 
     return module_mediator::module_failure;
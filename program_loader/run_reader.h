@@ -84,10 +84,8 @@ public:
             else {
                 LOG_PROGRAM_WARNING(
                     interoperation::get_module_part(),
-                    std::format(
-                        "Unknown run with index {}. It will be ignored.",
-                        static_cast<int>(run_type) //Otherwise it'll be printed as a character
-                    )
+                    "Unknown run with index {}. It will be ignored.",
+                    static_cast<int>(run_type) //Otherwise it'll be printed as a character
                 );
             }
 
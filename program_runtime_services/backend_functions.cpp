@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "backend_functions.h"
+#include "file_input_output.h"
 
 #include "../logger_module/logging.h"
 
@@ -12,11 +13,9 @@ namespace backend {
         if (interoperation::verify_thread_memory(interoperation::get_current_thread_id(), value) == module_mediator::module_failure) {
             LOG_PROGRAM_WARNING(
                 interoperation::get_module_part(),
-                std::format(
-                    "Thread memory at {} does not belong to {}",
-                    reinterpret_cast<std::uintptr_t>(value),
-                    interoperation::get_current_thread_id()
-                )
+                "Thread memory at {} does not belong to {}",
+                reinterpret_cast<std::uintptr_t>(value),
+                interoperation::get_current_thread_id()
             );
 
             return { nullptr, 0 };
@@ -56,12 +55,14 @@ namespace backend {
             return nullptr;
         }
 
-        module_mediator::return_value value_pointer_data = interoperation::thread_allocate(
+        module_mediator::memory pointer_data = create_memory_descriptor(
             thread_id,
-            sizeof(std::uint64_t) * 3
-        ); //first 8 bytes - allocated size, second 8 bytes - base address, third 8 bytes - pointer to thread-sharing counter
+            thread_group_id,
+            std::bit_cast<module_mediator::memory>(allocated_memory),
+            size
+        );
 
-        if (value_pointer_data == null_pointer) {
+        if (pointer_data == nullptr) {
             interoperation::thread_group_deallocate(
                 thread_group_id,
                 std::bit_cast<module_mediator::memory>(allocated_memory)
@@ -70,17 +71,31 @@ namespace backend {
             return nullptr;
         }
 
+        return pointer_data;
+    }
+
+    module_mediator::memory create_memory_descriptor(
+        module_mediator::return_value thread_id,
+        module_mediator::return_value thread_group_id, 
+        module_mediator::memory base,
+        module_mediator::eight_bytes size
+    ) {
+        module_mediator::return_value null_pointer = reinterpret_cast<module_mediator::return_value>(nullptr);
+        module_mediator::return_value value_pointer_data = interoperation::thread_allocate(
+            thread_id,
+            sizeof(std::uint64_t) * 3
+        ); //first 8 bytes - allocated size, second 8 bytes - base address, third 8 bytes - pointer to thread-sharing counter
+
+        if (value_pointer_data == null_pointer) {
+            return nullptr;
+        }
+
         module_mediator::return_value cross_thread_sharing = interoperation::thread_group_allocate(
             thread_group_id,
             sizeof(std::uint64_t)
         );
 
         if (cross_thread_sharing == null_pointer) {
-            interoperation::thread_group_deallocate(
-                thread_group_id,
-                std::bit_cast<module_mediator::memory>(allocated_memory)
-            );
-
             interoperation::thread_deallocate(
                 thread_id, 
                 std::bit_cast<module_mediator::memory>(value_pointer_data)
@@ -90,12 +105,13 @@ namespace backend {
         }
 
         char* pointer_data = std::bit_cast<char*>(value_pointer_data);
+        std::uintptr_t base_address = reinterpret_cast<std::uintptr_t>(base);
 
         //fill in memory size
         std::memcpy(pointer_data, &size, sizeof(std::uint64_t));
 
         //fill in actual memory value
-        std::memcpy(pointer_data + sizeof(std::uint64_t), &allocated_memory, sizeof(std::uint64_t));
+        std::memcpy(pointer_data + sizeof(std::uint64_t), &base_address, sizeof(std::uint64_t));
 
         //fill in cross-thread sharing pointer
         std::memcpy(pointer_data + sizeof(std::uint64_t) * 2, &cross_thread_sharing, sizeof(std::uint64_t));
@@ -111,15 +127,13 @@ namespace backend {
         return pointer_data;
     }
 
-    void deallocate_program_memory(
-        module_mediator::return_value thread_id,
-        module_mediator::return_value thread_group_id, 
-        module_mediator::memory address
-    ) {
-        if (address == nullptr) {
-            return;
-        }
-
+    /*
+    * Drops the reference that the descriptor holds on its memory. If it was the last one, returns the cross-thread sharing counter
+    * and the memory itself (null for mapped files, they are not owned by the resource module),
+    * which must be returned to the thread group. Otherwise returns null pointers.
+    * Then clears the descriptor, which must be returned to the thread.
+    */
+    std::pair<module_mediator::memory, module_mediator::memory> release_memory_descriptor(module_mediator::memory address) {
         assert(
             interoperation::verify_thread_memory(interoperation::get_current_thread_id(), address) != module_mediator::module_failure
             && "Unexpected invalid memory for backend function"
@@ -147,11 +161,13 @@ namespace backend {
             *static_cast<std::uint64_t*>(cross_thread_sharing)
         );
 
+        std::pair<module_mediator::memory, module_mediator::memory> released_memory{ nullptr, nullptr };
         assert(cross_thread_sharing_synchronous.load(std::memory_order_seq_cst) > 0 && "Cross-thread sharing counter cannot be zero");
         if (cross_thread_sharing_synchronous.fetch_sub(1, std::memory_order_relaxed) == 1) {
-            // Deallocate shared data and the memory itself.
-            interoperation::thread_group_deallocate(thread_group_id, cross_thread_sharing);
-            interoperation::thread_group_deallocate(thread_group_id, base);
+            released_memory.first = cross_thread_sharing;
+            if (!release_file_mapping(base)) {
+                released_memory.second = base;
+            }
         }
 
         // Clear the allocation descriptor to avoid dangling pointers.
@@ -161,7 +177,102 @@ namespace backend {
         // immediately.
         std::memset(address, 0xff, sizeof(std::uint64_t) * 3);
 
+        return released_memory;
+    }
+
+    void deallocate_program_memory(
+        module_mediator::return_value thread_id,
+        module_mediator::return_value thread_group_id, 
+        module_mediator::memory address
+    ) {
+        if (address == nullptr) {
+            return;
+        }
+
+        auto [cross_thread_sharing, base] = release_memory_descriptor(address);
+
+        // Deallocate shared data and the memory itself.
+        if (cross_thread_sharing != nullptr) {
+            interoperation::thread_group_deallocate(thread_group_id, cross_thread_sharing);
+        }
+
+        if (base != nullptr) {
+            interoperation::thread_group_deallocate(thread_group_id, base);
+        }
+
         // Deallocate the memory descriptor for the thread.
         interoperation::thread_deallocate(thread_id, address);
     }
+
+    std::size_t allocate_program_memory_many(
+        module_mediator::return_value thread_id,
+        module_mediator::return_value thread_group_id,
+        module_mediator::eight_bytes size,
+        std::span<module_mediator::memory> pointers
+    ) {
+        // Same layout as allocate_program_memory, but each kind of block is allocated with a single call to the resource module.
+        std::vector<module_mediator::memory> bases(pointers.size());
+        std::vector<module_mediator::memory> counters(pointers.size());
+
+        std::size_t allocated_count = interoperation::thread_group_allocate_many(thread_group_id, size, bases);
+        allocated_count = interoperation::thread_group_allocate_many(
+            thread_group_id, 
+            sizeof(std::uint64_t), 
+            std::span{ counters }.first(allocated_count)
+        );
+
+        allocated_count = interoperation::thread_allocate_many(
+            thread_id, 
+            sizeof(std::uint64_t) * 3, 
+            pointers.first(allocated_count)
+        );
+
+        for (std::size_t index = 0; index < allocated_count; ++index) {
+            char* pointer_data = static_cast<char*>(pointers[index]);
+            std::uintptr_t base_address = reinterpret_cast<std::uintptr_t>(bases[index]);
+            std::uintptr_t cross_thread_sharing = reinterpret_cast<std::uintptr_t>(counters[index]);
+            std::uint64_t thread_counter_initialization = 1;
+
+            std::memcpy(pointer_data, &size, sizeof(std::uint64_t));
+            std::memcpy(pointer_data + sizeof(std::uint64_t), &base_address, sizeof(std::uint64_t));
+            std::memcpy(pointer_data + sizeof(std::uint64_t) * 2, &cross_thread_sharing, sizeof(std::uint64_t));
+            std::memcpy(counters[index], &thread_counter_initialization, sizeof(std::uint64_t));
+        }
+
+        // Return whatever is left over after a failed allocation. Blocks that weren't allocated are null and are skipped.
+        if (allocated_count != pointers.size()) {
+            std::vector<module_mediator::memory> unused_memory{};
+            unused_memory.reserve((pointers.size() - allocated_count) * 2);
+
+            unused_memory.insert(unused_memory.end(), bases.begin() + allocated_count, bases.end());
+            unused_memory.insert(unused_memory.end(), counters.begin() + allocated_count, counters.end());
+            interoperation::thread_group_deallocate_many(thread_group_id, unused_memory);
+
+            std::fill(pointers.begin() + allocated_count, pointers.end(), nullptr);
+        }
+
+        return allocated_count;
+    }
+
+    void deallocate_program_memory_many(
+        module_mediator::return_value thread_id,
+        module_mediator::return_value thread_group_id,
+        std::span<module_mediator::memory> pointers
+    ) {
+        std::vector<module_mediator::memory> thread_group_memory{};
+        thread_group_memory.reserve(pointers.size() * 2);
+
+        for (module_mediator::memory address : pointers) {
+            if (address == nullptr) {
+                continue;
+            }
+
+            auto [cross_thread_sharing, base] = release_memory_descriptor(address);
+            thread_group_memory.push_back(cross_thread_sharing);
+            thread_group_memory.push_back(base);
+        }
+
+        interoperation::thread_group_deallocate_many(thread_group_id, thread_group_memory);
+        interoperation::thread_deallocate_many(thread_id, pointers);
+    }
 }
@@ -10,12 +10,37 @@ namespace backend {
         module_mediator::eight_bytes size
     );
 
+    // Makes a program pointer for memory that was not allocated with allocate_program_memory, e.g. a mapped file.
+    // The memory is not owned by the descriptor, the caller is responsible for it if this function fails.
+    module_mediator::memory create_memory_descriptor(
+        module_mediator::return_value thread_id,
+        module_mediator::return_value thread_group_id, 
+        module_mediator::memory base,
+        module_mediator::eight_bytes size
+    );
+
     void deallocate_program_memory(
         module_mediator::return_value thread_id,
         module_mediator::return_value thread_group_id, 
         module_mediator::memory address
     );
 
+    // Allocates one block of the specified size for every element of the span and writes pointers to them there.
+    // Stops at the first failed allocation, the rest of the span is filled with null pointers. Returns the number of allocated blocks.
+    std::size_t allocate_program_memory_many(
+        module_mediator::return_value thread_id,
+        module_mediator::return_value thread_group_id,
+        module_mediator::eight_bytes size,
+        std::span<module_mediator::memory> pointers
+    );
+
+    // Analogous to deallocate_program_memory. Null pointers are skipped, the rest must be verified by the caller.
+    void deallocate_program_memory_many(
+        module_mediator::return_value thread_id,
+        module_mediator::return_value thread_group_id,
+        std::span<module_mediator::memory> pointers
+    );
+
     std::pair<module_mediator::memory, module_mediator::eight_bytes> decay_pointer(module_mediator::memory);
 }
 
@@ -0,0 +1,48 @@
+#ifndef PROGRAM_RUNTIME_SERVICES_FILE_BACKEND_H
+#define PROGRAM_RUNTIME_SERVICES_FILE_BACKEND_H
+
+#include "pch.h"
+
+// The part of PRTS file IO that talks to the operating system.
+// File table, request queues and completion live in file_input_output.cpp and are shared by all backends.
+// Exactly one backend is compiled in: file_backend_windows.cpp or file_backend_linux.cpp.
+// All functions are blocking and are called only by file workers.
+namespace file_backend {
+    // HANDLE on Windows, file descriptor on Linux.
+    using native_file = std::intptr_t;
+
+    enum class open_mode : std::uint8_t {
+        // Opens an existing file for reading.
+        read = 0,
+
+        // Creates a file for writing. Existing file is truncated.
+        write = 1,
+
+        // Opens a file for reading and writing. The file is created if it does not exist, but is not truncated.
+        read_write = 2
+    };
+
+    // The path is UTF-8 encoded.
+    std::optional<native_file> open(const std::string& path, open_mode mode);
+
+    // Both transfer the whole buffer unless EOF (for reads) or an error is encountered.
+    // Return the amount of bytes transferred, or nothing if an error occurred before anything was transferred.
+    std::optional<std::uint64_t> read_at(native_file file, void* buffer, std::uint64_t size, std::uint64_t offset);
+    std::optional<std::uint64_t> write_at(native_file file, const void* buffer, std::uint64_t size, std::uint64_t offset);
+
+    void close(native_file file);
+
+    struct mapped_file {
+        void* address;
+        std::uint64_t size;
+    };
+
+    // Maps the whole file. The file is opened read-only, but the pages are copy-on-write:
+    // writes through the mapping are private to this process and never reach the file.
+    // Pages that are not written are shared with every other process that maps the same file.
+    // Empty files cannot be mapped.
+    std::optional<mapped_file> map(const std::string& path);
+    void unmap(const mapped_file& mapping);
+}
+
+#endif // !PROGRAM_RUNTIME_SERVICES_FILE_BACKEND_H
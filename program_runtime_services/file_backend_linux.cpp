@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "file_backend.h"
+#include "module_interoperation.h"
+
+#include "../logger_module/logging.h"
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Every request is positional (pread/pwrite), so file workers never share the file offset.
+namespace {
+    // Linux transfers at most 0x7ffff000 bytes per call anyway.
+    constexpr std::uint64_t max_transfer_size = 1ull << 30;
+}
+
+namespace file_backend {
+    std::optional<native_file> open(const std::string& path, open_mode mode) {
+        int flags = O_CLOEXEC;
+        switch (mode) {
+        case open_mode::read:
+            flags |= O_RDONLY;
+            break;
+
+        case open_mode::write:
+            flags |= O_WRONLY | O_CREAT | O_TRUNC;
+            break;
+
+        case open_mode::read_write:
+            flags |= O_RDWR | O_CREAT;
+            break;
+
+        default:
+            return std::nullopt;
+        }
+
+        int descriptor = -1;
+        do {
+            descriptor = ::open(path.c_str(), flags, 0666);
+        } while (descriptor == -1 && errno == EINTR);
+
+        if (descriptor == -1) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to open file {} with error code {}.",
+                path,
+                errno
+            );
+
+            return std::nullopt;
+        }
+
+        if (mode == open_mode::read) {
+            posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+
+        return descriptor;
+    }
+
+    std::optional<std::uint64_t> read_at(native_file file, void* buffer, std::uint64_t size, std::uint64_t offset) {
+        char* destination = static_cast<char*>(buffer);
+        std::uint64_t total_read = 0;
+
+        while (total_read < size) {
+            ssize_t bytes_read = pread(
+                static_cast<int>(file),
+                destination + total_read,
+                std::min(size - total_read, max_transfer_size),
+                static_cast<off_t>(offset + total_read)
+            );
+
+            if (bytes_read == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Failed to read from file with error code {}.",
+                    errno
+                );
+
+                if (total_read == 0) {
+                    return std::nullopt;
+                }
+
+                break;
+            }
+
+            if (bytes_read == 0) {
+                break;
+            }
+
+            total_read += static_cast<std::uint64_t>(bytes_read);
+        }
+
+        return total_read;
+    }
+
+    std::optional<std::uint64_t> write_at(native_file file, const void* buffer, std::uint64_t size, std::uint64_t offset) {
+        const char* source = static_cast<const char*>(buffer);
+        std::uint64_t total_written = 0;
+
+        while (total_written < size) {
+            ssize_t bytes_written = pwrite(
+                static_cast<int>(file),
+                source + total_written,
+                std::min(size - total_written, max_transfer_size),
+                static_cast<off_t>(offset + total_written)
+            );
+
+            if (bytes_written == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Failed to write to file with error code {}.",
+                    errno
+                );
+
+                if (total_written == 0) {
+                    return std::nullopt;
+                }
+
+                break;
+            }
+
+            total_written += static_cast<std::uint64_t>(bytes_written);
+        }
+
+        return total_written;
+    }
+
+    void close(native_file file) {
+        // The descriptor is released even if close fails, so it must not be retried.
+        if (::close(static_cast<int>(file)) != 0) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to close file descriptor with error code {}.",
+                errno
+            );
+        }
+    }
+
+    std::optional<mapped_file> map(const std::string& path) {
+        std::optional<native_file> file = open(path, open_mode::read);
+        if (!file.has_value()) {
+            return std::nullopt;
+        }
+
+        struct stat file_status{};
+        if (fstat(static_cast<int>(*file), &file_status) != 0 || file_status.st_size <= 0) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Cannot map file {}: it is empty or its size is unknown (error code {}).",
+                path,
+                errno
+            );
+
+            close(*file);
+            return std::nullopt;
+        }
+
+        std::uint64_t size = static_cast<std::uint64_t>(file_status.st_size);
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, static_cast<int>(*file), 0);
+
+        // The mapping keeps the file alive, the descriptor is not needed anymore.
+        close(*file);
+        if (address == MAP_FAILED) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to map file {} with error code {}.",
+                path,
+                errno
+            );
+
+            return std::nullopt;
+        }
+
+        return mapped_file{ address, size };
+    }
+
+    void unmap(const mapped_file& mapping) {
+        if (munmap(mapping.address, mapping.size) != 0) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to unmap file with error code {}.",
+                errno
+            );
+        }
+    }
+}
+
+#endif // __linux__
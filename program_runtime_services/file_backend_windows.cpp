@@ -0,0 +1,237 @@
+#include "pch.h"
+#include "file_backend.h"
+#include "module_interoperation.h"
+
+#include "../logger_module/logging.h"
+
+#ifdef _WIN32
+
+// Files are opened for synchronous IO. ReadFile and WriteFile still accept an offset through OVERLAPPED in this case,
+// so every request is positional and file workers never share the file pointer.
+namespace {
+    // ReadFile and WriteFile accept DWORD sizes.
+    constexpr std::uint64_t max_transfer_size = 1ull << 30;
+
+    OVERLAPPED make_offset(std::uint64_t offset) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        return overlapped;
+    }
+}
+
+namespace file_backend {
+    std::optional<native_file> open(const std::string& path, open_mode mode) {
+        DWORD dwDesiredAccess = GENERIC_READ;
+        DWORD dwCreationDisposition = OPEN_EXISTING;
+        switch (mode) {
+        case open_mode::read:
+            break;
+
+        case open_mode::write:
+            dwDesiredAccess = GENERIC_WRITE;
+            dwCreationDisposition = CREATE_ALWAYS;
+            break;
+
+        case open_mode::read_write:
+            dwDesiredAccess = GENERIC_READ | GENERIC_WRITE;
+            dwCreationDisposition = OPEN_ALWAYS;
+            break;
+
+        default:
+            return std::nullopt;
+        }
+
+        std::filesystem::path native_path{ std::u8string{ path.begin(), path.end() } };
+        HANDLE hFile = CreateFileW(
+            native_path.c_str(),
+            dwDesiredAccess,
+            FILE_SHARE_READ,
+            nullptr,
+            dwCreationDisposition,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr
+        );
+
+        if (hFile == INVALID_HANDLE_VALUE) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to open file {} with error code {}.",
+                path,
+                GetLastError()
+            );
+
+            return std::nullopt;
+        }
+
+        return reinterpret_cast<native_file>(hFile);
+    }
+
+    std::optional<std::uint64_t> read_at(native_file file, void* buffer, std::uint64_t size, std::uint64_t offset) {
+        char* destination = static_cast<char*>(buffer);
+        std::uint64_t total_read = 0;
+
+        while (total_read < size) {
+            OVERLAPPED overlapped = make_offset(offset + total_read);
+            DWORD dwBytesRead = 0;
+
+            BOOL bReadResult = ReadFile(
+                reinterpret_cast<HANDLE>(file),
+                destination + total_read,
+                static_cast<DWORD>(std::min(size - total_read, max_transfer_size)),
+                &dwBytesRead,
+                &overlapped
+            );
+
+            if (!bReadResult) {
+                if (GetLastError() == ERROR_HANDLE_EOF) {
+                    break;
+                }
+
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Failed to read from file with error code {}.",
+                    GetLastError()
+                );
+
+                if (total_read == 0) {
+                    return std::nullopt;
+                }
+
+                break;
+            }
+
+            if (dwBytesRead == 0) {
+                break;
+            }
+
+            total_read += dwBytesRead;
+        }
+
+        return total_read;
+    }
+
+    std::optional<std::uint64_t> write_at(native_file file, const void* buffer, std::uint64_t size, std::uint64_t offset) {
+        const char* source = static_cast<const char*>(buffer);
+        std::uint64_t total_written = 0;
+
+        while (total_written < size) {
+            OVERLAPPED overlapped = make_offset(offset + total_written);
+            DWORD dwBytesWritten = 0;
+
+            BOOL bWriteResult = WriteFile(
+                reinterpret_cast<HANDLE>(file),
+                source + total_written,
+                static_cast<DWORD>(std::min(size - total_written, max_transfer_size)),
+                &dwBytesWritten,
+                &overlapped
+            );
+
+            if (!bWriteResult) {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Failed to write to file with error code {}.",
+                    GetLastError()
+                );
+
+                if (total_written == 0) {
+                    return std::nullopt;
+                }
+
+                break;
+            }
+
+            total_written += dwBytesWritten;
+        }
+
+        return total_written;
+    }
+
+    void close(native_file file) {
+        if (!CloseHandle(reinterpret_cast<HANDLE>(file))) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to close file handle with error code {}.",
+                GetLastError()
+            );
+        }
+    }
+
+    std::optional<mapped_file> map(const std::string& path) {
+        std::optional<native_file> file = open(path, open_mode::read);
+        if (!file.has_value()) {
+            return std::nullopt;
+        }
+
+        HANDLE hFile = reinterpret_cast<HANDLE>(*file);
+        LARGE_INTEGER liFileSize{};
+        if (!GetFileSizeEx(hFile, &liFileSize) || liFileSize.QuadPart == 0) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Cannot map file {}: it is empty or its size is unknown (error code {}).",
+                path,
+                GetLastError()
+            );
+
+            close(*file);
+            return std::nullopt;
+        }
+
+        HANDLE hMapping = CreateFileMappingW(
+            hFile,
+            nullptr,
+            PAGE_WRITECOPY,
+            0,
+            0,
+            nullptr
+        );
+
+        // The view keeps the file and the mapping object alive, their handles are not needed anymore.
+        close(*file);
+        if (hMapping == nullptr) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to create file mapping for {} with error code {}.",
+                path,
+                GetLastError()
+            );
+
+            return std::nullopt;
+        }
+
+        LPVOID lpView = MapViewOfFile(
+            hMapping,
+            FILE_MAP_COPY,
+            0,
+            0,
+            0
+        );
+
+        close(reinterpret_cast<native_file>(hMapping));
+        if (lpView == nullptr) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to map view of {} with error code {}.",
+                path,
+                GetLastError()
+            );
+
+            return std::nullopt;
+        }
+
+        return mapped_file{ lpView, static_cast<std::uint64_t>(liFileSize.QuadPart) };
+    }
+
+    void unmap(const mapped_file& mapping) {
+        if (!UnmapViewOfFile(mapping.address)) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to unmap file view with error code {}.",
+                GetLastError()
+            );
+        }
+    }
+}
+
+#endif // _WIN32
@@ -0,0 +1,681 @@
+#include "pch.h"
+#include "file_input_output.h"
+#include "backend_functions.h"
+#include "file_backend.h"
+#include "mpsc_queue.h"
+
+#include "../logger_module/logging.h"
+#include "../startup_components/local_crash_handlers.h"
+
+// This file describes file IO for the FSI programs through PRTS (Program RunTime Services) module.
+// It works like stdio: the calling thread is blocked, a deferred callback queues its request, and a worker thread
+// makes the thread runnable again when the request is done. Executors never wait for the disk.
+// Data is read into and written from the program memory directly, PRTS does not copy it.
+// Mapped files are handed to programs as ordinary program pointers (see backend::create_memory_descriptor).
+// The operating system side lives in file_backend_*.cpp, see file_backend.h.
+
+namespace {
+    // Returned by reads and writes that failed before anything was transferred.
+    constexpr module_mediator::eight_bytes file_io_failure = std::numeric_limits<module_mediator::eight_bytes>::max();
+
+    // Returned by io.file.open if the file cannot be opened.
+    constexpr module_mediator::eight_bytes invalid_file_id = 0;
+
+    struct open_file {
+        file_backend::native_file native_file;
+        module_mediator::return_value thread_group_id;
+
+        // Position for io.file.read and io.file.write. Held for the whole request, so sequential requests don't overlap.
+        std::mutex position_lock{};
+        std::uint64_t position{ 0 };
+
+        open_file(file_backend::native_file native_file, module_mediator::return_value thread_group_id)
+            :native_file{ native_file },
+            thread_group_id{ thread_group_id }
+        {}
+
+        open_file(const open_file&) = delete;
+        open_file& operator= (const open_file&) = delete;
+
+        // Requests hold a reference to the file, so it is closed only after all of them are done.
+        ~open_file() noexcept {
+            file_backend::close(this->native_file);
+        }
+    };
+
+    enum class file_operation : std::uint8_t {
+        open,
+        read,
+        write,
+        close,
+        map
+    };
+
+    struct file_request {
+        module_mediator::return_value thread_id;
+
+        // Receives the file id for open, the amount of bytes transferred for read and write,
+        // the program pointer for map. Null for close.
+        module_mediator::memory return_address;
+        file_operation operation;
+
+        std::shared_ptr<open_file> file{};
+
+        module_mediator::memory buffer{ nullptr };
+        module_mediator::eight_bytes buffer_size{ 0 };
+
+        // Empty for io.file.read and io.file.write, which use the position of the file.
+        std::optional<std::uint64_t> offset{};
+
+        // Only used by open and map.
+        std::string path{};
+        file_backend::open_mode mode{ file_backend::open_mode::read };
+        module_mediator::return_value thread_group_id{ 0 };
+    };
+
+    // Files belong to the thread group that opened them. They are closed with io.file.close or when the thread group is destroyed.
+    namespace open_files {
+        std::mutex lock;
+        std::unordered_map<module_mediator::eight_bytes, std::shared_ptr<open_file>> files;
+        module_mediator::eight_bytes next_file_id{ invalid_file_id + 1 };
+
+        // Thread groups that have close_thread_group_files registered.
+        std::unordered_set<module_mediator::return_value> registered_thread_groups;
+    }
+
+    // Mapped files belong to the thread group that mapped them. They are unmapped when the last program pointer to them
+    // is deallocated, or when the thread group is destroyed.
+    namespace file_mappings {
+        struct mapping {
+            file_backend::mapped_file file;
+            module_mediator::return_value thread_group_id;
+        };
+
+        std::mutex lock;
+        std::unordered_map<void*, mapping> mappings;
+
+        // Lets release_file_mapping skip the lookup for programs that never map files.
+        std::atomic<std::size_t> mappings_count{ 0 };
+    }
+
+    void add_file_mapping(const file_backend::mapped_file& file, module_mediator::return_value thread_group_id) {
+        std::scoped_lock mappings_lock{ file_mappings::lock };
+
+        file_mappings::mappings.emplace(file.address, file_mappings::mapping{ file, thread_group_id });
+        file_mappings::mappings_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    module_mediator::memory map_file(const file_request& request) {
+        std::optional<file_backend::mapped_file> file = file_backend::map(request.path);
+        if (!file.has_value()) {
+            return nullptr;
+        }
+
+        // Mapped files take up memory just like allocated blocks do. Uncharged by release_file_mapping.
+        if (!interoperation::thread_group_charge(request.thread_group_id, file->size)) {
+            file_backend::unmap(*file);
+            return nullptr;
+        }
+
+        add_file_mapping(*file, request.thread_group_id);
+        module_mediator::memory pointer = backend::create_memory_descriptor(
+            request.thread_id,
+            request.thread_group_id,
+            file->address,
+            file->size
+        );
+
+        if (pointer == nullptr) {
+            release_file_mapping(file->address);
+        }
+
+        return pointer;
+    }
+
+    std::shared_ptr<open_file> find_file(module_mediator::eight_bytes file_id, module_mediator::return_value thread_group_id) {
+        std::scoped_lock files_lock{ open_files::lock };
+
+        auto file_iterator = open_files::files.find(file_id);
+        if (file_iterator == open_files::files.end() || file_iterator->second->thread_group_id != thread_group_id) {
+            return {};
+        }
+
+        return file_iterator->second;
+    }
+
+    std::shared_ptr<open_file> remove_file(module_mediator::eight_bytes file_id, module_mediator::return_value thread_group_id) {
+        std::scoped_lock files_lock{ open_files::lock };
+
+        auto file_iterator = open_files::files.find(file_id);
+        if (file_iterator == open_files::files.end() || file_iterator->second->thread_group_id != thread_group_id) {
+            return {};
+        }
+
+        std::shared_ptr<open_file> file = std::move(file_iterator->second);
+        open_files::files.erase(file_iterator);
+
+        return file;
+    }
+
+    module_mediator::eight_bytes add_file(std::shared_ptr<open_file> file) {
+        std::scoped_lock files_lock{ open_files::lock };
+
+        module_mediator::eight_bytes file_id = open_files::next_file_id++;
+        open_files::files.emplace(file_id, std::move(file));
+
+        return file_id;
+    }
+
+    // Makes sure that files of a thread group are closed when the thread group is destroyed.
+    void register_thread_group_files_destroy_callback(module_mediator::return_value thread_group_id) {
+        {
+            std::scoped_lock files_lock{ open_files::lock };
+            if (!open_files::registered_thread_groups.insert(thread_group_id).second) {
+                return;
+            }
+        }
+
+        module_mediator::callback_bundle* callback_structure =
+            module_mediator::create_callback<module_mediator::return_value>(
+                "prts",
+                "close_thread_group_files",
+                thread_group_id
+            );
+
+        module_mediator::fast_call<module_mediator::return_value, module_mediator::memory>(
+            interoperation::get_module_part(),
+            interoperation::index_getter::resource_module(),
+            interoperation::index_getter::resource_module_add_container_on_destroy(),
+            thread_group_id,
+            callback_structure
+        );
+    }
+
+    std::optional<std::uint64_t> transfer_file_data(const file_request& request, std::uint64_t offset) {
+        if (request.operation == file_operation::read) {
+            return file_backend::read_at(request.file->native_file, request.buffer, request.buffer_size, offset);
+        }
+
+        return file_backend::write_at(request.file->native_file, request.buffer, request.buffer_size, offset);
+    }
+
+    void complete_file_request(file_request& request) {
+        module_mediator::eight_bytes result{ 0 };
+        switch (request.operation) {
+        case file_operation::open: {
+            std::optional<file_backend::native_file> native_file = file_backend::open(request.path, request.mode);
+
+            result = invalid_file_id;
+            if (native_file.has_value()) {
+                result = add_file(std::make_shared<open_file>(*native_file, request.thread_group_id));
+            }
+
+            break;
+        }
+
+        case file_operation::read:
+        case file_operation::write: {
+            std::optional<std::uint64_t> transferred{};
+            if (request.offset.has_value()) {
+                transferred = transfer_file_data(request, *request.offset);
+            }
+            else {
+                std::scoped_lock position_lock{ request.file->position_lock };
+
+                transferred = transfer_file_data(request, request.file->position);
+                request.file->position += transferred.value_or(0);
+            }
+
+            result = transferred.value_or(file_io_failure);
+            break;
+        }
+
+        case file_operation::close:
+            // The file is closed here, unless some other request still uses it.
+            request.file.reset();
+            break;
+
+        case file_operation::map:
+            result = reinterpret_cast<std::uintptr_t>(map_file(request));
+            break;
+        }
+
+        if (request.return_address != nullptr) {
+            std::memcpy(request.return_address, &result, sizeof(module_mediator::eight_bytes));
+        }
+
+        module_mediator::fast_call<module_mediator::return_value>(
+            interoperation::get_module_part(),
+            interoperation::index_getter::execution_module(),
+            interoperation::index_getter::execution_module_make_runnable(),
+            request.thread_id
+        );
+    }
+}
+
+// File worker threads. They are started with the first request and stopped when PRTS is unloaded.
+namespace {
+    namespace file_workers {
+        constexpr std::size_t workers_count = 4;
+
+        std::once_flag start_flag;
+        std::atomic<bool> is_running{ false };
+        std::atomic<std::size_t> next_worker{ 0 };
+
+        // Any executor can submit a request, and only the worker consumes them (see mpsc_queue).
+        std::array<mpsc_queue<file_request>, workers_count> queues{};
+        std::array<std::thread, workers_count> threads{};
+    }
+
+    void file_worker(std::size_t worker_index) {
+        // We can't call this after LOG_* function, because it might fail.
+        startup_components::crash_handling::install_local_crash_handlers();
+
+        mpsc_queue<file_request>& queue = file_workers::queues[worker_index];
+        while (true) {
+            queue.wait_for_signal();
+            while (std::optional<file_request> request = queue.try_pop()) {
+                complete_file_request(*request);
+            }
+
+            if (!file_workers::is_running.load(std::memory_order_acquire)) {
+                break;
+            }
+        }
+    }
+
+    void start_file_workers() {
+        std::call_once(file_workers::start_flag, []() {
+            LOG_INFO(
+                interoperation::get_module_part(),
+                "Starting {} file workers.",
+                file_workers::workers_count
+            );
+
+            file_workers::is_running.store(true, std::memory_order_release);
+            for (std::size_t worker_index = 0; worker_index < file_workers::workers_count; ++worker_index) {
+                file_workers::threads[worker_index] = std::thread(file_worker, worker_index);
+            }
+        });
+    }
+
+    // Blocks the current thread until the request is done. Takes ownership of the request.
+    module_mediator::return_value submit_file_request(std::unique_ptr<file_request> request) {
+        module_mediator::callback_bundle* callback_structure =
+            module_mediator::create_callback<module_mediator::return_value, module_mediator::memory>(
+                "prts",
+                "callback_register_file_request",
+                request->thread_id,
+                request.get()
+            );
+
+        request.release();
+        module_mediator::fast_call<module_mediator::memory>(
+            interoperation::get_module_part(),
+            interoperation::index_getter::execution_module(),
+            interoperation::index_getter::execution_module_register_deferred_callback(),
+            callback_structure
+        );
+
+        return module_mediator::execution_result_block;
+    }
+
+    // Common part of io.file.read, io.file.write, io.file.pread and io.file.pwrite.
+    module_mediator::return_value submit_file_transfer(
+        file_operation operation,
+        module_mediator::memory return_address,
+        module_mediator::one_byte type,
+        module_mediator::eight_bytes file_id,
+        module_mediator::memory buffer,
+        module_mediator::eight_bytes buffer_size,
+        std::optional<std::uint64_t> offset
+    ) {
+        if (type != module_mediator::eight_bytes_return_value) {
+            LOG_PROGRAM_ERROR(
+                interoperation::get_module_part(),
+                "Invalid type for file IO operation. Expected eight bytes return value."
+            );
+
+            return module_mediator::execution_result_terminate;
+        }
+
+        std::shared_ptr<open_file> file = find_file(file_id, interoperation::get_current_thread_group_id());
+        if (file == nullptr) {
+            LOG_PROGRAM_ERROR(
+                interoperation::get_module_part(),
+                "File {} is not open in the current thread group.",
+                file_id
+            );
+
+            return module_mediator::execution_result_terminate;
+        }
+
+        if (buffer_size == 0) {
+            module_mediator::eight_bytes transferred{ 0 };
+            std::memcpy(return_address, &transferred, sizeof(module_mediator::eight_bytes));
+
+            return module_mediator::execution_result_continue;
+        }
+
+        auto [memory, memory_size] =
+            backend::decay_pointer(buffer);
+
+        if (memory_size < buffer_size) {
+            LOG_PROGRAM_ERROR(
+                interoperation::get_module_part(),
+                "Requested file IO size {} exceeds memory block size of {}.",
+                buffer_size,
+                memory_size
+            );
+
+            return module_mediator::execution_result_terminate;
+        }
+
+        return submit_file_request(std::make_unique<file_request>(file_request{
+            .thread_id = interoperation::get_current_thread_id(),
+            .return_address = return_address,
+            .operation = operation,
+            .file = std::move(file),
+            .buffer = memory,
+            .buffer_size = buffer_size,
+            .offset = offset
+        }));
+    }
+}
+
+bool release_file_mapping(module_mediator::memory base) {
+    if (file_mappings::mappings_count.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    file_backend::mapped_file file{};
+    module_mediator::return_value thread_group_id{};
+    {
+        std::scoped_lock mappings_lock{ file_mappings::lock };
+
+        auto mapping_iterator = file_mappings::mappings.find(base);
+        if (mapping_iterator == file_mappings::mappings.end()) {
+            return false;
+        }
+
+        file = mapping_iterator->second.file;
+        thread_group_id = mapping_iterator->second.thread_group_id;
+
+        file_mappings::mappings.erase(mapping_iterator);
+        file_mappings::mappings_count.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    file_backend::unmap(file);
+    interoperation::thread_group_uncharge(thread_group_id, file.size);
+
+    return true;
+}
+
+void stop_file_workers() {
+    if (!file_workers::is_running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    for (mpsc_queue<file_request>& queue : file_workers::queues) {
+        queue.signal();
+    }
+
+    for (std::thread& worker : file_workers::threads) {
+        worker.join();
+    }
+}
+
+module_mediator::return_value callback_register_file_request(module_mediator::arguments_string_type bundle) {
+    auto [thread_id, request_pointer] =
+        module_mediator::respond_callback<module_mediator::return_value, module_mediator::memory>::unpack(bundle);
+
+    std::unique_ptr<file_request> request{ static_cast<file_request*>(request_pointer) };
+    start_file_workers();
+
+    // Sequential requests to one file are serialized by the file position anyway,
+    // so they are all sent to the same worker instead of blocking several of them.
+    std::size_t worker_index{};
+    if (request->file != nullptr && !request->offset.has_value()) {
+        worker_index = std::hash<open_file*>{}(request->file.get()) % file_workers::workers_count;
+    }
+    else {
+        worker_index = file_workers::next_worker.fetch_add(1, std::memory_order_relaxed) % file_workers::workers_count;
+    }
+
+    file_workers::queues[worker_index].push(std::move(*request));
+    file_workers::queues[worker_index].signal();
+
+    return module_mediator::module_success;
+}
+
+module_mediator::return_value close_thread_group_files(module_mediator::arguments_string_type bundle) {
+    auto [thread_group_id] =
+        module_mediator::respond_callback<module_mediator::return_value>::unpack(bundle);
+
+    std::vector<std::shared_ptr<open_file>> closed_files{};
+    {
+        std::scoped_lock files_lock{ open_files::lock };
+
+        open_files::registered_thread_groups.erase(thread_group_id);
+        for (auto file_iterator = open_files::files.begin(); file_iterator != open_files::files.end();) {
+            if (file_iterator->second->thread_group_id == thread_group_id) {
+                closed_files.push_back(std::move(file_iterator->second));
+                file_iterator = open_files::files.erase(file_iterator);
+            }
+            else {
+                ++file_iterator;
+            }
+        }
+    }
+
+    if (!closed_files.empty()) {
+        LOG_INFO(
+            interoperation::get_module_part(),
+            "Thread group {} did not close {} file(s). Closing them.",
+            thread_group_id,
+            closed_files.size()
+        );
+    }
+
+    std::vector<file_backend::mapped_file> unmapped_files{};
+    {
+        std::scoped_lock mappings_lock{ file_mappings::lock };
+        for (auto mapping_iterator = file_mappings::mappings.begin(); mapping_iterator != file_mappings::mappings.end();) {
+            if (mapping_iterator->second.thread_group_id == thread_group_id) {
+                unmapped_files.push_back(mapping_iterator->second.file);
+                mapping_iterator = file_mappings::mappings.erase(mapping_iterator);
+                file_mappings::mappings_count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            else {
+                ++mapping_iterator;
+            }
+        }
+    }
+
+    // The program pointers to these files are dangling now, but so is the rest of the thread group memory.
+    // Their charges are taken back together with the rest of the thread group memory as well.
+    for (const file_backend::mapped_file& file : unmapped_files) {
+        file_backend::unmap(file);
+    }
+
+    return module_mediator::module_success;
+}
+
+module_mediator::return_value file_open(module_mediator::arguments_string_type bundle) {
+    auto [return_address, type, path, path_size, mode] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory,
+            module_mediator::one_byte,
+            module_mediator::memory,
+            module_mediator::eight_bytes,
+            module_mediator::one_byte
+        >(bundle);
+
+    if (type != module_mediator::eight_bytes_return_value) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "Invalid type for file open operation. Expected eight bytes return value."
+        );
+
+        return module_mediator::execution_result_terminate;
+    }
+
+    if (mode > static_cast<module_mediator::one_byte>(file_backend::open_mode::read_write)) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "Invalid file open mode {}.",
+            mode
+        );
+
+        return module_mediator::execution_result_terminate;
+    }
+
+    auto [memory, memory_size] =
+        backend::decay_pointer(path);
+
+    if (path_size == 0 || memory_size < path_size) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "Requested path size {} is empty or exceeds memory block size of {}.",
+            path_size,
+            memory_size
+        );
+
+        return module_mediator::execution_result_terminate;
+    }
+
+    module_mediator::return_value thread_group_id = interoperation::get_current_thread_group_id();
+    register_thread_group_files_destroy_callback(thread_group_id);
+
+    const char* path_data = static_cast<const char*>(memory);
+    return submit_file_request(std::make_unique<file_request>(file_request{
+        .thread_id = interoperation::get_current_thread_id(),
+        .return_address = return_address,
+        .operation = file_operation::open,
+        .path = std::string{ path_data, path_data + path_size },
+        .mode = static_cast<file_backend::open_mode>(mode),
+        .thread_group_id = thread_group_id
+    }));
+}
+
+module_mediator::return_value file_map(module_mediator::arguments_string_type bundle) {
+    auto [return_address, type, path, path_size] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory,
+            module_mediator::one_byte,
+            module_mediator::memory,
+            module_mediator::eight_bytes
+        >(bundle);
+
+    if (type != module_mediator::memory_return_value) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "Invalid type for file map operation. Expected memory return value."
+        );
+
+        return module_mediator::execution_result_terminate;
+    }
+
+    auto [memory, memory_size] =
+        backend::decay_pointer(path);
+
+    if (path_size == 0 || memory_size < path_size) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "Requested path size {} is empty or exceeds memory block size of {}.",
+            path_size,
+            memory_size
+        );
+
+        return module_mediator::execution_result_terminate;
+    }
+
+    module_mediator::return_value thread_group_id = interoperation::get_current_thread_group_id();
+    register_thread_group_files_destroy_callback(thread_group_id);
+
+    const char* path_data = static_cast<const char*>(memory);
+    return submit_file_request(std::make_unique<file_request>(file_request{
+        .thread_id = interoperation::get_current_thread_id(),
+        .return_address = return_address,
+        .operation = file_operation::map,
+        .path = std::string{ path_data, path_data + path_size },
+        .thread_group_id = thread_group_id
+    }));
+}
+
+module_mediator::return_value file_read(module_mediator::arguments_string_type bundle) {
+    auto [return_address, type, file_id, buffer, buffer_size] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory,
+            module_mediator::one_byte,
+            module_mediator::eight_bytes,
+            module_mediator::memory,
+            module_mediator::eight_bytes
+        >(bundle);
+
+    return submit_file_transfer(file_operation::read, return_address, type, file_id, buffer, buffer_size, std::nullopt);
+}
+
+module_mediator::return_value file_write(module_mediator::arguments_string_type bundle) {
+    auto [return_address, type, file_id, buffer, buffer_size] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory,
+            module_mediator::one_byte,
+            module_mediator::eight_bytes,
+            module_mediator::memory,
+            module_mediator::eight_bytes
+        >(bundle);
+
+    return submit_file_transfer(file_operation::write, return_address, type, file_id, buffer, buffer_size, std::nullopt);
+}
+
+module_mediator::return_value file_pread(module_mediator::arguments_string_type bundle) {
+    auto [return_address, type, file_id, buffer, buffer_size, offset] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory,
+            module_mediator::one_byte,
+            module_mediator::eight_bytes,
+            module_mediator::memory,
+            module_mediator::eight_bytes,
+            module_mediator::eight_bytes
+        >(bundle);
+
+    return submit_file_transfer(file_operation::read, return_address, type, file_id, buffer, buffer_size, offset);
+}
+
+module_mediator::return_value file_pwrite(module_mediator::arguments_string_type bundle) {
+    auto [return_address, type, file_id, buffer, buffer_size, offset] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory,
+            module_mediator::one_byte,
+            module_mediator::eight_bytes,
+            module_mediator::memory,
+            module_mediator::eight_bytes,
+            module_mediator::eight_bytes
+        >(bundle);
+
+    return submit_file_transfer(file_operation::write, return_address, type, file_id, buffer, buffer_size, offset);
+}
+
+module_mediator::return_value file_close(module_mediator::arguments_string_type bundle) {
+    auto [file_id] =
+        module_mediator::arguments_string_builder::unpack<module_mediator::eight_bytes>(bundle);
+
+    std::shared_ptr<open_file> file = remove_file(file_id, interoperation::get_current_thread_group_id());
+    if (file == nullptr) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "File {} is not open in the current thread group.",
+            file_id
+        );
+
+        return module_mediator::execution_result_terminate;
+    }
+
+    return submit_file_request(std::make_unique<file_request>(file_request{
+        .thread_id = interoperation::get_current_thread_id(),
+        .return_address = nullptr,
+        .operation = file_operation::close,
+        .file = std::move(file)
+    }));
+}
@@ -0,0 +1,23 @@
+#ifndef FILE_INPUT_OUTPUT_H
+#define FILE_INPUT_OUTPUT_H
+
+#include "module_interoperation.h"
+
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value callback_register_file_request(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value close_thread_group_files(module_mediator::arguments_string_type bundle);
+
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value file_open(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value file_read(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value file_write(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value file_pread(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value file_pwrite(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value file_close(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value file_map(module_mediator::arguments_string_type bundle);
+
+// Unmaps a file mapped with io.file.map. Returns false if the memory is not a mapped file.
+bool release_file_mapping(module_mediator::memory base);
+
+// Stops file workers. Called when the module is unloaded.
+void stop_file_workers();
+
+#endif
@@ -18,6 +18,11 @@ namespace {
     }
 
     module_mediator::return_value generic_log_message(module_mediator::arguments_string_type bundle, log_type log) {
+        // Program messages are filtered by the level of PRTS. Arguments of a discarded message are not verified.
+        if (!logger_module::is_log_level_enabled(interoperation::get_module_part(), 4 + static_cast<std::size_t>(log))) {
+            return module_mediator::execution_result_continue;
+        }
+
         auto arguments = module_mediator::arguments_string_builder::unpack<
             module_mediator::memory, 
             module_mediator::eight_bytes, 
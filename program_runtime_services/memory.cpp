@@ -5,22 +5,59 @@
 #include "../logger_module/logging.h"
 
 namespace {
-    void check_if_pointer_is_saved(module_mediator::memory address) {
-        unsigned char* saved_variable =
-            reinterpret_cast<unsigned char*>(
-                module_mediator::fast_call(
-                    interoperation::get_module_part(),
-                    interoperation::index_getter::execution_module(),
-                    interoperation::index_getter::execution_module_get_thread_saved_variable()
-                ));
-
-        if (saved_variable[8] == module_mediator::memory_return_value) {
-            if (std::memcmp(saved_variable, &address, sizeof(module_mediator::memory)) == 0) {
-                module_mediator::memory null_pointer{};
-                std::memcpy(saved_variable, &null_pointer, sizeof(module_mediator::memory));
+    void check_if_pointers_are_saved(std::span<const module_mediator::memory> addresses) {
+        unsigned char* saved_variable = interoperation::get_current_thread_information().saved_variable;
+        if (saved_variable != nullptr && saved_variable[8] == module_mediator::memory_return_value) {
+            for (module_mediator::memory address : addresses) {
+                if (std::memcmp(saved_variable, &address, sizeof(module_mediator::memory)) == 0) {
+                    module_mediator::memory null_pointer{};
+                    std::memcpy(saved_variable, &null_pointer, sizeof(module_mediator::memory));
+
+                    return;
+                }
             }
         }
     }
+
+    void check_if_pointer_is_saved(module_mediator::memory address) {
+        check_if_pointers_are_saved(std::span{ &address, 1 });
+    }
+
+    bool is_accessible(module_mediator::memory address) {
+        if (interoperation::verify_thread_memory(interoperation::get_current_thread_id(), address) == module_mediator::module_failure) {
+            LOG_PROGRAM_ERROR(
+                interoperation::get_module_part(),
+                "Memory at {} is not accessible by the current thread.",
+                reinterpret_cast<std::uintptr_t>(address)
+            );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // Returns the address of the element or nullptr if the array is not accessible or the index is out of bounds.
+    char* get_pointer_array_element(module_mediator::memory array, module_mediator::eight_bytes index) {
+        auto [data, size] = backend::decay_pointer(array);
+        if (data == nullptr) {
+            LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Pointer array is not accessible by the current thread.");
+            return nullptr;
+        }
+
+        if (index >= size / sizeof(module_mediator::memory)) {
+            LOG_PROGRAM_ERROR(
+                interoperation::get_module_part(), 
+                "Index {} is out of bounds of a pointer array with {} element(s).", 
+                index, 
+                size / sizeof(module_mediator::memory)
+            );
+
+            return nullptr;
+        }
+
+        return static_cast<char*>(data) + index * sizeof(module_mediator::memory);
+    }
 }
 
 module_mediator::return_value allocate_memory(module_mediator::arguments_string_type bundle) {
@@ -61,15 +98,7 @@ module_mediator::return_value deallocate_memory(module_mediator::arguments_strin
         return module_mediator::execution_result_continue;
     }
 
-    if (interoperation::verify_thread_memory(interoperation::get_current_thread_id(), address) == module_mediator::module_failure) {
-        LOG_PROGRAM_ERROR(
-            interoperation::get_module_part(),
-            std::format(
-                "Memory at {} is not accessible by the current thread.",
-                reinterpret_cast<std::uintptr_t>(address)
-            )
-        );
-
+    if (!is_accessible(address)) {
         return module_mediator::execution_result_terminate;
     }
 
@@ -95,15 +124,7 @@ module_mediator::return_value get_allocated_size(module_mediator::arguments_stri
         return module_mediator::execution_result_terminate;
     }
 
-    if (interoperation::verify_thread_memory(interoperation::get_current_thread_id(), address) == module_mediator::module_failure) {
-        LOG_PROGRAM_ERROR(
-            interoperation::get_module_part(),
-            std::format(
-                "Memory at {} is not accessible by the current thread.",
-                reinterpret_cast<std::uintptr_t>(address)
-            )
-        );
-
+    if (!is_accessible(address)) {
         return module_mediator::execution_result_terminate;
     }
 
@@ -113,3 +134,192 @@ module_mediator::return_value get_allocated_size(module_mediator::arguments_stri
     std::memcpy(return_address, &size, sizeof(module_mediator::eight_bytes));
     return module_mediator::execution_result_continue;
 }
+
+module_mediator::return_value allocate_memory_many(module_mediator::arguments_string_type bundle) {
+    auto [return_address, return_type, array, size] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory, 
+            module_mediator::one_byte, 
+            module_mediator::memory, 
+            module_mediator::eight_bytes
+        >(bundle);
+
+    if (return_type != module_mediator::eight_bytes_return_value) {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Incorrect return type. (allocate_memory_many)");
+        return module_mediator::execution_result_terminate;
+    }
+
+    auto [data, array_size] = backend::decay_pointer(array);
+    if (data == nullptr) {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Pointer array is not accessible by the current thread.");
+        return module_mediator::execution_result_terminate;
+    }
+
+    std::vector<module_mediator::memory> pointers(array_size / sizeof(module_mediator::memory));
+    module_mediator::eight_bytes allocated_count = backend::allocate_program_memory_many(
+        interoperation::get_current_thread_id(),
+        interoperation::get_current_thread_group_id(),
+        size,
+        pointers
+    );
+
+    if (allocated_count != pointers.size()) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(), 
+            "Failed memory allocation. Allocated {} out of {} block(s).", 
+            allocated_count, 
+            pointers.size()
+        );
+    }
+
+    std::memcpy(data, pointers.data(), pointers.size() * sizeof(module_mediator::memory));
+    std::memcpy(return_address, &allocated_count, sizeof(module_mediator::eight_bytes));
+
+    return module_mediator::execution_result_continue;
+}
+
+module_mediator::return_value deallocate_memory_many(module_mediator::arguments_string_type bundle) {
+    auto [return_address, return_type, array] =
+        module_mediator::arguments_string_builder::unpack<module_mediator::memory, module_mediator::one_byte, module_mediator::memory>(bundle);
+
+    if (return_type != module_mediator::eight_bytes_return_value) {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Incorrect return type. (deallocate_memory_many)");
+        return module_mediator::execution_result_terminate;
+    }
+
+    auto [data, array_size] = backend::decay_pointer(array);
+    if (data == nullptr) {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Pointer array is not accessible by the current thread.");
+        return module_mediator::execution_result_terminate;
+    }
+
+    std::vector<module_mediator::memory> pointers(array_size / sizeof(module_mediator::memory));
+    std::memcpy(pointers.data(), data, pointers.size() * sizeof(module_mediator::memory));
+
+    /*
+    * Inaccessible pointers are left in the array, so that the program can find them.
+    * The array may contain itself, so it is cleared before anything is deallocated.
+    */
+
+    module_mediator::eight_bytes deallocated_count = 0;
+    for (std::size_t index = 0; index < pointers.size(); ++index) {
+        if (pointers[index] == nullptr) {
+            continue;
+        }
+
+        if (!is_accessible(pointers[index])) {
+            pointers[index] = nullptr;
+            continue;
+        }
+
+        module_mediator::memory null_pointer{};
+        std::memcpy(static_cast<char*>(data) + index * sizeof(module_mediator::memory), &null_pointer, sizeof(module_mediator::memory));
+        ++deallocated_count;
+    }
+
+    // The same pointer may be stored several times, it must be deallocated only once.
+    std::ranges::sort(pointers);
+    auto [duplicates_begin, duplicates_end] = std::ranges::unique(pointers);
+    pointers.erase(duplicates_begin, duplicates_end);
+
+    backend::deallocate_program_memory_many(
+        interoperation::get_current_thread_id(),
+        interoperation::get_current_thread_group_id(),
+        pointers
+    );
+
+    check_if_pointers_are_saved(pointers);
+
+    std::memcpy(return_address, &deallocated_count, sizeof(module_mediator::eight_bytes));
+    return module_mediator::execution_result_continue;
+}
+
+module_mediator::return_value take_pointer(module_mediator::arguments_string_type bundle) {
+    auto [return_address, return_type, array, index] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory, 
+            module_mediator::one_byte, 
+            module_mediator::memory, 
+            module_mediator::eight_bytes
+        >(bundle);
+
+    if (return_type != module_mediator::memory_return_value) {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Incorrect return type. (take_pointer)");
+        return module_mediator::execution_result_terminate;
+    }
+
+    char* element = get_pointer_array_element(array, index);
+    if (element == nullptr) {
+        return module_mediator::execution_result_terminate;
+    }
+
+    // The array is ordinary program memory, so anything could have been written there.
+    module_mediator::memory pointer{};
+    std::memcpy(&pointer, element, sizeof(module_mediator::memory));
+    if (pointer != nullptr && !is_accessible(pointer)) {
+        return module_mediator::execution_result_terminate;
+    }
+
+    module_mediator::memory null_pointer{};
+    std::memcpy(element, &null_pointer, sizeof(module_mediator::memory));
+    std::memcpy(return_address, &pointer, sizeof(module_mediator::memory));
+
+    return module_mediator::execution_result_continue;
+}
+
+module_mediator::return_value put_pointer(module_mediator::arguments_string_type bundle) {
+    auto [array, index, pointer] =
+        module_mediator::arguments_string_builder::unpack<module_mediator::memory, module_mediator::eight_bytes, module_mediator::memory>(bundle);
+
+    char* element = get_pointer_array_element(array, index);
+    if (element == nullptr) {
+        return module_mediator::execution_result_terminate;
+    }
+
+    if (pointer != nullptr && !is_accessible(pointer)) {
+        return module_mediator::execution_result_terminate;
+    }
+
+    std::memcpy(element, &pointer, sizeof(module_mediator::memory));
+    return module_mediator::execution_result_continue;
+}
+
+module_mediator::return_value memory_usage(module_mediator::arguments_string_type bundle) {
+    // Scopes and counters are the same as the ones accepted by get_memory_usage of the resource module.
+    constexpr module_mediator::one_byte last_scope = 2;
+    constexpr module_mediator::one_byte last_counter = 1;
+
+    auto [return_address, return_type, scope, counter] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory,
+            module_mediator::one_byte,
+            module_mediator::one_byte,
+            module_mediator::one_byte
+        >(bundle);
+
+    if (return_type != module_mediator::eight_bytes_return_value) {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Incorrect return type. (memory_usage)");
+        return module_mediator::execution_result_terminate;
+    }
+
+    if (scope > last_scope || counter > last_counter) {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Unknown memory usage scope {} or counter {}.", scope, counter);
+        return module_mediator::execution_result_terminate;
+    }
+
+    module_mediator::eight_bytes usage = module_mediator::fast_call<
+        module_mediator::return_value,
+        module_mediator::one_byte,
+        module_mediator::one_byte
+    >(
+        interoperation::get_module_part(),
+        interoperation::index_getter::resource_module(),
+        interoperation::index_getter::resource_module_get_memory_usage(),
+        interoperation::get_current_thread_id(),
+        scope,
+        counter
+    );
+
+    std::memcpy(return_address, &usage, sizeof(module_mediator::eight_bytes));
+    return module_mediator::execution_result_continue;
+}
@@ -7,4 +7,11 @@ PROGRAMRUNTIMESERVICES_API module_mediator::return_value allocate_memory(module_
 PROGRAMRUNTIMESERVICES_API module_mediator::return_value deallocate_memory(module_mediator::arguments_string_type bundle);
 PROGRAMRUNTIMESERVICES_API module_mediator::return_value get_allocated_size(module_mediator::arguments_string_type bundle);
 
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value allocate_memory_many(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value deallocate_memory_many(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value take_pointer(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value put_pointer(module_mediator::arguments_string_type bundle);
+
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value memory_usage(module_mediator::arguments_string_type bundle);
+
 #endif
@@ -0,0 +1,375 @@
+#include "pch.h"
+#include "memory_regions.h"
+
+#include "../logger_module/logging.h"
+
+// This file describes memory regions: memory that a program allocates many objects from and releases all at once.
+// Objects are bumped from a single block, and their descriptors are taken from arrays owned by the region,
+// so neither allocations nor resets go to the resource module. Descriptors have the same layout as the ones
+// made by backend::allocate_program_memory, so compiled code dereferences region objects the same way, with bounds checks.
+// Region objects are not registered in the resource module: they can't be deallocated, passed to other threads
+// or to functions that verify memory (e.g. IO). Object data is kept apart from descriptors, so after a reset an old pointer
+// can only alias a new object of the same region, it never sees a descriptor forged from program data.
+// For the same reason descriptors of a destroyed region are not given back to the heap until its thread group is destroyed.
+
+namespace {
+    // Returned by memory.region.create if the region cannot be created.
+    constexpr module_mediator::eight_bytes invalid_region_id = 0;
+
+    // Objects are aligned the same way as blocks allocated by the resource module.
+    constexpr std::uint64_t region_object_alignment = 16;
+    constexpr std::size_t descriptors_per_chunk = 256;
+
+    struct region_object_descriptor {
+        std::uint64_t size;
+        char* base;
+
+        // Region objects are never shared between threads, so the cross-thread sharing pointer is not used.
+        std::uint64_t* cross_thread_sharing;
+    };
+
+    using descriptor_chunk = std::unique_ptr<region_object_descriptor[]>;
+
+    struct memory_region {
+        module_mediator::return_value thread_group_id;
+
+        std::mutex lock{};
+        bool destroyed{ false };
+
+        // Thread group memory, so that regions count towards memory quotas. Freed by destroy_region.
+        char* data;
+        std::uint64_t capacity;
+        std::uint64_t used_size{ 0 };
+
+        // Chunks are never moved or freed until the region is destroyed, pointers to descriptors stay valid across resets.
+        std::vector<descriptor_chunk> descriptor_chunks{};
+        std::size_t used_descriptors{ 0 };
+
+        memory_region(module_mediator::return_value thread_group_id, char* data, std::uint64_t capacity)
+            :thread_group_id{ thread_group_id },
+            data{ data },
+            capacity{ capacity }
+        {}
+
+        memory_region(const memory_region&) = delete;
+        memory_region& operator= (const memory_region&) = delete;
+
+        // The lock must be held. Returns nullptr if the region has no space left.
+        region_object_descriptor* allocate(std::uint64_t size) {
+            if (this->destroyed) {
+                return nullptr;
+            }
+
+            std::uint64_t aligned_size = (size + region_object_alignment - 1) & ~(region_object_alignment - 1);
+            if (aligned_size < size || aligned_size > this->capacity - this->used_size) {
+                return nullptr;
+            }
+
+            std::size_t chunk_index = this->used_descriptors / descriptors_per_chunk;
+            if (chunk_index == this->descriptor_chunks.size()) {
+                this->descriptor_chunks.emplace_back(new(std::nothrow) region_object_descriptor[descriptors_per_chunk]{});
+                if (this->descriptor_chunks.back() == nullptr) {
+                    this->descriptor_chunks.pop_back();
+                    return nullptr;
+                }
+            }
+
+            region_object_descriptor* descriptor = &this->descriptor_chunks[chunk_index][this->used_descriptors % descriptors_per_chunk];
+            char* base = this->data + this->used_size;
+
+            // Objects are zeroed, like any other program memory. The previous object could have left anything in there.
+            std::memset(base, 0, size);
+            *descriptor = region_object_descriptor{ size, base, nullptr };
+
+            this->used_size += aligned_size;
+            ++this->used_descriptors;
+
+            return descriptor;
+        }
+
+        // The lock must be held. Doesn't touch the objects, so it takes the same time regardless of their number.
+        void reset() {
+            this->used_size = 0;
+            this->used_descriptors = 0;
+        }
+
+        // The lock must be held. Returns the descriptor chunks, which the caller must keep alive:
+        // pointers to the objects can still be used after this. Descriptors get a size of 0, so compiled code fails
+        // the bounds check of every dereference and terminates the program before it adds the base address.
+        std::vector<descriptor_chunk> destroy() {
+            for (descriptor_chunk& chunk : this->descriptor_chunks) {
+                std::fill_n(chunk.get(), descriptors_per_chunk, region_object_descriptor{ 0, nullptr, nullptr });
+            }
+
+            this->destroyed = true;
+            this->capacity = 0;
+            this->reset();
+
+            return std::move(this->descriptor_chunks);
+        }
+    };
+
+    // Regions belong to the thread group that created them. They are destroyed with memory.region.destroy
+    // or when the thread group is destroyed.
+    namespace regions {
+        std::mutex lock;
+        std::unordered_map<module_mediator::eight_bytes, std::shared_ptr<memory_region>> regions;
+        module_mediator::eight_bytes next_region_id{ invalid_region_id + 1 };
+
+        // Thread groups that have destroy_thread_group_regions registered.
+        std::unordered_set<module_mediator::return_value> registered_thread_groups;
+
+        // Poisoned descriptor chunks of destroyed regions, by thread group. Threads of the group may still hold pointers into them,
+        // if the chunks went back to the heap, the memory could be reused for program data and the pointers would see forged descriptors.
+        std::unordered_map<module_mediator::return_value, std::vector<descriptor_chunk>> quarantined_descriptors;
+    }
+
+    module_mediator::eight_bytes add_region(std::shared_ptr<memory_region> region) {
+        std::scoped_lock regions_lock{ regions::lock };
+
+        module_mediator::eight_bytes region_id = regions::next_region_id++;
+        regions::regions.emplace(region_id, std::move(region));
+
+        return region_id;
+    }
+
+    std::shared_ptr<memory_region> find_region(module_mediator::eight_bytes region_id, module_mediator::return_value thread_group_id) {
+        std::scoped_lock regions_lock{ regions::lock };
+
+        auto region_iterator = regions::regions.find(region_id);
+        if (region_iterator == regions::regions.end() || region_iterator->second->thread_group_id != thread_group_id) {
+            return {};
+        }
+
+        return region_iterator->second;
+    }
+
+    std::shared_ptr<memory_region> remove_region(module_mediator::eight_bytes region_id, module_mediator::return_value thread_group_id) {
+        std::scoped_lock regions_lock{ regions::lock };
+
+        auto region_iterator = regions::regions.find(region_id);
+        if (region_iterator == regions::regions.end() || region_iterator->second->thread_group_id != thread_group_id) {
+            return {};
+        }
+
+        std::shared_ptr<memory_region> region = std::move(region_iterator->second);
+        regions::regions.erase(region_iterator);
+
+        return region;
+    }
+
+    // Makes sure that regions of a thread group are destroyed when the thread group is destroyed.
+    void register_thread_group_regions_destroy_callback(module_mediator::return_value thread_group_id) {
+        {
+            std::scoped_lock regions_lock{ regions::lock };
+            if (!regions::registered_thread_groups.insert(thread_group_id).second) {
+                return;
+            }
+        }
+
+        module_mediator::callback_bundle* callback_structure =
+            module_mediator::create_callback<module_mediator::return_value>(
+                "prts",
+                "destroy_thread_group_regions",
+                thread_group_id
+            );
+
+        module_mediator::fast_call<module_mediator::return_value, module_mediator::memory>(
+            interoperation::get_module_part(),
+            interoperation::index_getter::resource_module(),
+            interoperation::index_getter::resource_module_add_container_on_destroy(),
+            thread_group_id,
+            callback_structure
+        );
+    }
+
+    void destroy_region(memory_region& region, bool is_thread_group_destroyed) {
+        std::vector<descriptor_chunk> poisoned_chunks{};
+        char* data = nullptr;
+        {
+            std::scoped_lock region_lock{ region.lock };
+            poisoned_chunks = region.destroy();
+            data = std::exchange(region.data, nullptr);
+        }
+
+        // Memory of a destroyed thread group is freed by the resource module.
+        if (data != nullptr && !is_thread_group_destroyed) {
+            interoperation::thread_group_deallocate(region.thread_group_id, data);
+        }
+
+        if (poisoned_chunks.empty()) {
+            return;
+        }
+
+        std::scoped_lock regions_lock{ regions::lock };
+        std::vector<descriptor_chunk>& quarantine = regions::quarantined_descriptors[region.thread_group_id];
+        quarantine.insert(
+            quarantine.end(),
+            std::make_move_iterator(poisoned_chunks.begin()),
+            std::make_move_iterator(poisoned_chunks.end())
+        );
+    }
+}
+
+module_mediator::return_value destroy_thread_group_regions(module_mediator::arguments_string_type bundle) {
+    auto [thread_group_id] =
+        module_mediator::respond_callback<module_mediator::return_value>::unpack(bundle);
+
+    std::vector<std::shared_ptr<memory_region>> destroyed_regions{};
+    {
+        std::scoped_lock regions_lock{ regions::lock };
+
+        regions::registered_thread_groups.erase(thread_group_id);
+        for (auto region_iterator = regions::regions.begin(); region_iterator != regions::regions.end();) {
+            if (region_iterator->second->thread_group_id == thread_group_id) {
+                destroyed_regions.push_back(std::move(region_iterator->second));
+                region_iterator = regions::regions.erase(region_iterator);
+            }
+            else {
+                ++region_iterator;
+            }
+        }
+    }
+
+    if (!destroyed_regions.empty()) {
+        LOG_INFO(
+            interoperation::get_module_part(),
+            "Thread group {} did not destroy {} memory region(s). Destroying them.",
+            thread_group_id,
+            destroyed_regions.size()
+        );
+    }
+
+    for (const std::shared_ptr<memory_region>& region : destroyed_regions) {
+        destroy_region(*region, true);
+    }
+
+    // All threads of the group are gone, nobody can use the descriptors anymore.
+    std::vector<descriptor_chunk> released_chunks{};
+    {
+        std::scoped_lock regions_lock{ regions::lock };
+
+        auto quarantine_iterator = regions::quarantined_descriptors.find(thread_group_id);
+        if (quarantine_iterator != regions::quarantined_descriptors.end()) {
+            released_chunks = std::move(quarantine_iterator->second);
+            regions::quarantined_descriptors.erase(quarantine_iterator);
+        }
+    }
+
+    return module_mediator::module_success;
+}
+
+module_mediator::return_value region_create(module_mediator::arguments_string_type bundle) {
+    auto [return_address, type, capacity] =
+        module_mediator::arguments_string_builder::unpack<module_mediator::memory, module_mediator::one_byte, module_mediator::eight_bytes>(bundle);
+
+    if (type != module_mediator::eight_bytes_return_value) {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Incorrect return type. (region_create)");
+        return module_mediator::execution_result_terminate;
+    }
+
+    module_mediator::eight_bytes region_id = invalid_region_id;
+    module_mediator::return_value thread_group_id = interoperation::get_current_thread_group_id();
+
+    // Fails if the region would exceed a memory quota as well.
+    char* data = static_cast<char*>(
+        std::bit_cast<module_mediator::memory>(interoperation::thread_group_allocate(thread_group_id, capacity))
+    );
+
+    if (data != nullptr) {
+        register_thread_group_regions_destroy_callback(thread_group_id);
+        region_id = add_region(std::make_shared<memory_region>(thread_group_id, data, capacity));
+    }
+    else {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Failed to allocate memory region of {} bytes.", capacity);
+    }
+
+    std::memcpy(return_address, &region_id, sizeof(module_mediator::eight_bytes));
+    return module_mediator::execution_result_continue;
+}
+
+module_mediator::return_value region_allocate(module_mediator::arguments_string_type bundle) {
+    auto [return_address, type, region_id, size] =
+        module_mediator::arguments_string_builder::unpack<
+            module_mediator::memory,
+            module_mediator::one_byte,
+            module_mediator::eight_bytes,
+            module_mediator::eight_bytes
+        >(bundle);
+
+    if (type != module_mediator::memory_return_value) {
+        LOG_PROGRAM_ERROR(interoperation::get_module_part(), "Incorrect return type. (region_allocate)");
+        return module_mediator::execution_result_terminate;
+    }
+
+    std::shared_ptr<memory_region> region = find_region(region_id, interoperation::get_current_thread_group_id());
+    if (region == nullptr) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "Memory region {} does not exist in the current thread group.",
+            region_id
+        );
+
+        return module_mediator::execution_result_terminate;
+    }
+
+    region_object_descriptor* descriptor = nullptr;
+    {
+        std::scoped_lock region_lock{ region->lock };
+        descriptor = region->allocate(size);
+    }
+
+    if (descriptor == nullptr) {
+        LOG_PROGRAM_WARNING(
+            interoperation::get_module_part(),
+            "Memory region {} has no space left for an object of {} bytes.",
+            region_id,
+            size
+        );
+    }
+
+    module_mediator::memory pointer = descriptor;
+    std::memcpy(return_address, &pointer, sizeof(module_mediator::memory));
+
+    return module_mediator::execution_result_continue;
+}
+
+module_mediator::return_value region_reset(module_mediator::arguments_string_type bundle) {
+    auto [region_id] =
+        module_mediator::arguments_string_builder::unpack<module_mediator::eight_bytes>(bundle);
+
+    std::shared_ptr<memory_region> region = find_region(region_id, interoperation::get_current_thread_group_id());
+    if (region == nullptr) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "Memory region {} does not exist in the current thread group.",
+            region_id
+        );
+
+        return module_mediator::execution_result_terminate;
+    }
+
+    std::scoped_lock region_lock{ region->lock };
+    region->reset();
+
+    return module_mediator::execution_result_continue;
+}
+
+module_mediator::return_value region_destroy(module_mediator::arguments_string_type bundle) {
+    auto [region_id] =
+        module_mediator::arguments_string_builder::unpack<module_mediator::eight_bytes>(bundle);
+
+    std::shared_ptr<memory_region> region = remove_region(region_id, interoperation::get_current_thread_group_id());
+    if (region == nullptr) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "Memory region {} does not exist in the current thread group.",
+            region_id
+        );
+
+        return module_mediator::execution_result_terminate;
+    }
+
+    destroy_region(*region, false);
+    return module_mediator::execution_result_continue;
+}
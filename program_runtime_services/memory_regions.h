@@ -0,0 +1,13 @@
+#ifndef PRTS_MEMORY_REGIONS_H
+#define PRTS_MEMORY_REGIONS_H
+
+#include "module_interoperation.h"
+
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value destroy_thread_group_regions(module_mediator::arguments_string_type bundle);
+
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value region_create(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value region_allocate(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value region_reset(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value region_destroy(module_mediator::arguments_string_type bundle);
+
+#endif
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "module_interoperation.h"
 #include "standard_input_output.h"
+#include "file_input_output.h"
 #include "../logger_module/logging.h"
 
 namespace {
@@ -25,20 +26,33 @@ namespace interoperation {
         );
     }
 
+    const current_thread_information& get_current_thread_information() {
+        static const current_thread_information engine_thread_information{};
+        thread_local const current_thread_information* cached_thread_information = nullptr;
+        if (cached_thread_information == nullptr) {
+            cached_thread_information = reinterpret_cast<const current_thread_information*>(
+                module_mediator::fast_call(
+                    get_module_part(),
+                    index_getter::execution_module(),
+                    index_getter::execution_module_get_current_thread_information()
+                )
+            );
+
+            // System threads that the execution module doesn't know about (e.g. IO workers) never run program threads.
+            if (cached_thread_information == nullptr) {
+                cached_thread_information = &engine_thread_information;
+            }
+        }
+
+        return *cached_thread_information;
+    }
+
     module_mediator::return_value get_current_thread_id() {
-        return module_mediator::fast_call(
-            get_module_part(),
-            index_getter::execution_module(),
-            index_getter::execution_module_get_current_thread_id()
-        );
+        return get_current_thread_information().thread_id;
     }
 
     module_mediator::return_value get_current_thread_group_id() {
-        return module_mediator::fast_call(
-            get_module_part(),
-            index_getter::execution_module(),
-            index_getter::execution_module_get_current_thread_group_id()
-        );
+        return get_current_thread_information().thread_group_id;
     }
 
     module_mediator::return_value thread_allocate(
@@ -92,6 +106,102 @@ namespace interoperation {
             pointer
         );
     }
+
+    bool thread_group_charge(
+        module_mediator::return_value thread_group_id,
+        module_mediator::eight_bytes size
+    ) {
+        return module_mediator::fast_call<module_mediator::return_value, module_mediator::eight_bytes>(
+            get_module_part(),
+            index_getter::resource_module(),
+            index_getter::resource_module_charge_program_memory(),
+            thread_group_id,
+            size
+        ) == module_mediator::module_success;
+    }
+
+    void thread_group_uncharge(
+        module_mediator::return_value thread_group_id,
+        module_mediator::eight_bytes size
+    ) {
+        module_mediator::fast_call<module_mediator::return_value, module_mediator::eight_bytes>(
+            get_module_part(),
+            index_getter::resource_module(),
+            index_getter::resource_module_uncharge_program_memory(),
+            thread_group_id,
+            size
+        );
+    }
+
+    std::size_t thread_allocate_many(
+        module_mediator::return_value thread_id,
+        module_mediator::eight_bytes size,
+        std::span<module_mediator::memory> pointers
+    ) {
+        return module_mediator::fast_call<
+            module_mediator::return_value, 
+            module_mediator::eight_bytes, 
+            module_mediator::eight_bytes, 
+            module_mediator::memory
+        >(
+            get_module_part(),
+            index_getter::resource_module(),
+            index_getter::resource_module_allocate_thread_memory_many(),
+            thread_id,
+            pointers.size(),
+            size,
+            pointers.data()
+        );
+    }
+
+    void thread_deallocate_many(
+        module_mediator::return_value thread_id,
+        std::span<module_mediator::memory> pointers
+    ) {
+        module_mediator::fast_call<module_mediator::return_value, module_mediator::eight_bytes, module_mediator::memory>(
+            get_module_part(),
+            index_getter::resource_module(),
+            index_getter::resource_module_deallocate_thread_memory_many(),
+            thread_id,
+            pointers.size(),
+            pointers.data()
+        );
+    }
+
+    std::size_t thread_group_allocate_many(
+        module_mediator::return_value thread_group_id,
+        module_mediator::eight_bytes size,
+        std::span<module_mediator::memory> pointers
+    ) {
+        return module_mediator::fast_call<
+            module_mediator::return_value, 
+            module_mediator::eight_bytes, 
+            module_mediator::eight_bytes, 
+            module_mediator::memory
+        >(
+            get_module_part(),
+            index_getter::resource_module(),
+            index_getter::resource_module_allocate_program_memory_many(),
+            thread_group_id,
+            pointers.size(),
+            size,
+            pointers.data()
+        );
+    }
+
+    void thread_group_deallocate_many(
+        module_mediator::return_value thread_group_id,
+        std::span<module_mediator::memory> pointers
+    ) {
+        module_mediator::fast_call<module_mediator::return_value, module_mediator::eight_bytes, module_mediator::memory>(
+            get_module_part(),
+            index_getter::resource_module(),
+            index_getter::resource_module_deallocate_program_memory_many(),
+            thread_group_id,
+            pointers.size(),
+            pointers.data()
+        );
+    }
 }
 
 void initialize_m(module_mediator::module_part* module_part) {
@@ -100,6 +210,7 @@ void initialize_m(module_mediator::module_part* module_part) {
 }
 
 void free_m() {
+    stop_file_workers();
     logger_module::global_logging_instance::set_logging_enabled(false);
 }
 
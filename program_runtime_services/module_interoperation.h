@@ -3,8 +3,11 @@
 
 #include "../module_mediator/module_part.h"
 #include "../module_mediator/fsi_types.h"
+#include "../execution_module/current_thread_information.h"
 
-#ifdef PROGRAMRUNTIMESERVICES_EXPORTS
+#ifndef _WIN32
+#define PROGRAMRUNTIMESERVICES_API extern "C" __attribute__((visibility("default")))
+#elif defined(PROGRAMRUNTIMESERVICES_EXPORTS)
 #define PROGRAMRUNTIMESERVICES_API extern "C" __declspec(dllexport)
 #else
 #define PROGRAMRUNTIMESERVICES_API extern "C" __declspec(dllimport) 
@@ -20,6 +23,10 @@ namespace interoperation {
         module_mediator::memory pointer
     );
 
+    // Information about the program thread that runs on the calling system thread. Read without calling the execution module,
+    // except for the first call on each system thread.
+    const current_thread_information& get_current_thread_information();
+
     module_mediator::return_value get_current_thread_id();
     module_mediator::return_value get_current_thread_group_id();
 
@@ -43,6 +50,42 @@ namespace interoperation {
         module_mediator::memory pointer
     );
 
+    // Counts memory that PRTS got elsewhere (e.g. mapped files) towards the quotas of a thread group.
+    // Returns false if that would exceed a quota.
+    bool thread_group_charge(
+        module_mediator::return_value thread_group_id,
+        module_mediator::eight_bytes size
+    );
+
+    void thread_group_uncharge(
+        module_mediator::return_value thread_group_id,
+        module_mediator::eight_bytes size
+    );
+
+    // Bulk versions of the functions above, each one locks the resource container only once.
+    // Allocation functions write blocks to the start of the span and return their number.
+    std::size_t thread_allocate_many(
+        module_mediator::return_value thread_id,
+        module_mediator::eight_bytes size,
+        std::span<module_mediator::memory> pointers
+    );
+
+    void thread_deallocate_many(
+        module_mediator::return_value thread_id,
+        std::span<module_mediator::memory> pointers
+    );
+
+    std::size_t thread_group_allocate_many(
+        module_mediator::return_value thread_group_id,
+        module_mediator::eight_bytes size,
+        std::span<module_mediator::memory> pointers
+    );
+
+    void thread_group_deallocate_many(
+        module_mediator::return_value thread_group_id,
+        std::span<module_mediator::memory> pointers
+    );
+
     class index_getter {
     public:
         static std::size_t program_loader() {
@@ -75,8 +118,8 @@ namespace interoperation {
             return index;
         }
 
-        static std::size_t execution_module_get_thread_saved_variable() {
-            static std::size_t index = get_module_part()->find_function_index(execution_module(), "get_thread_saved_variable");
+        static std::size_t execution_module_get_current_thread_information() {
+            static std::size_t index = get_module_part()->find_function_index(execution_module(), "get_current_thread_information");
             return index;
         }
 
@@ -135,6 +178,51 @@ namespace interoperation {
             return index;
         }
 
+        static std::size_t resource_module_allocate_thread_memory_many() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "allocate_thread_memory_many");
+            return index;
+        }
+
+        static std::size_t resource_module_deallocate_thread_memory_many() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "deallocate_thread_memory_many");
+            return index;
+        }
+
+        static std::size_t resource_module_allocate_program_memory_many() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "allocate_program_memory_many");
+            return index;
+        }
+
+        static std::size_t resource_module_deallocate_program_memory_many() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "deallocate_program_memory_many");
+            return index;
+        }
+
+        static std::size_t resource_module_charge_program_memory() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "charge_program_memory");
+            return index;
+        }
+
+        static std::size_t resource_module_uncharge_program_memory() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "uncharge_program_memory");
+            return index;
+        }
+
+        static std::size_t resource_module_add_container_on_destroy() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "add_container_on_destroy");
+            return index;
+        }
+
+        static std::size_t resource_module_add_thread_on_destroy() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "add_thread_on_destroy");
+            return index;
+        }
+
+        static std::size_t resource_module_get_memory_usage() {
+            static std::size_t index = get_module_part()->find_function_index(resource_module(), "get_memory_usage");
+            return index;
+        }
+
         static std::size_t resource_module_get_jump_table() {
             static std::size_t index = get_module_part()->find_function_index(resource_module(), "get_jump_table");
             return index;
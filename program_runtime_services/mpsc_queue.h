@@ -0,0 +1,87 @@
+#ifndef PROGRAM_RUNTIME_SERVICES_MPSC_QUEUE_H
+#define PROGRAM_RUNTIME_SERVICES_MPSC_QUEUE_H
+
+#include "pch.h"
+
+/*
+* Unbounded lock-free queue for many producers and a single consumer (intrusive MPSC queue by Dmitry Vyukov).
+* A push is one exchange and one store, producers never wait for each other or for the consumer.
+*
+* The consumer may see the queue as empty while a producer is in the middle of a push.
+* This is why every push is followed by signal(), which is raised only after the push is complete:
+* the consumer calls wait_for_signal() and then pops everything it can, so no request is ever left behind.
+*/
+template<typename value_type>
+class mpsc_queue {
+private:
+    struct node {
+        std::atomic<node*> next{ nullptr };
+        std::optional<value_type> value{};
+    };
+
+    // Not std::hardware_destructive_interference_size: GCC warns about every use of it in a header, since its value may differ
+    // between compilers and -mtune options. The queue is not shared across such boundaries, so a fixed line size is enough.
+    static constexpr std::size_t cache_line_size = 64;
+
+    // Producers only touch the tail and the signal, the consumer only touches the head.
+    alignas(cache_line_size) std::atomic<node*> tail;
+    alignas(cache_line_size) node* head;
+    alignas(cache_line_size) std::atomic<bool> signaled{ false };
+
+public:
+    mpsc_queue() {
+        node* stub = new node{};
+
+        this->head = stub;
+        this->tail.store(stub, std::memory_order_relaxed);
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator= (const mpsc_queue&) = delete;
+
+    // Can be called by any thread.
+    void push(value_type value) {
+        node* new_node = new node{};
+        new_node->value.emplace(std::move(value));
+
+        node* previous = this->tail.exchange(new_node, std::memory_order_acq_rel);
+        previous->next.store(new_node, std::memory_order_release);
+    }
+
+    // Can be called by any thread. Wakes the consumer up, if it is waiting.
+    void signal() {
+        if (!this->signaled.exchange(true, std::memory_order_acq_rel)) {
+            this->signaled.notify_one();
+        }
+    }
+
+    // Consumer only. Blocks until signal() is called, returns immediately if it was called since the last wait.
+    void wait_for_signal() {
+        this->signaled.wait(false, std::memory_order_acquire);
+        this->signaled.exchange(false, std::memory_order_acq_rel);
+    }
+
+    // Consumer only.
+    std::optional<value_type> try_pop() {
+        node* next = this->head->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return std::nullopt;
+        }
+
+        // The popped node becomes the new stub.
+        std::optional<value_type> result{ std::move(next->value) };
+        next->value.reset();
+
+        delete this->head;
+        this->head = next;
+
+        return result;
+    }
+
+    ~mpsc_queue() noexcept {
+        while (this->try_pop()) {}
+        delete this->head;
+    }
+};
+
+#endif // !PROGRAM_RUNTIME_SERVICES_MPSC_QUEUE_H
@@ -0,0 +1,128 @@
+// Standalone stress test for mpsc_queue.h, not a part of the PRTS project. Build and run it (GCC 13 or newer, pch.h needs <format>) with:
+//   g++ -std=c++20 -O2 -pthread mpsc_queue_stress_test.cpp -o mpsc_queue_stress_test && ./mpsc_queue_stress_test
+//   cl /std:c++20 /O2 /EHsc mpsc_queue_stress_test.cpp && mpsc_queue_stress_test.exe
+// Add -fsanitize=thread (or -fsanitize=address) to check the memory orderings and node lifetimes as well.
+//
+// Producers push numbered values and signal, the consumer waits for a signal and pops everything it can,
+// the same way PRTS workers do. The test fails if a value is lost, duplicated, or if the values of one producer
+// are popped out of order. A lost wake up makes the consumer wait forever, so the test is aborted by a watchdog.
+
+#include "mpsc_queue.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    struct test_value {
+        std::size_t producer_id;
+        std::size_t sequence_number;
+
+        // Makes the values non-trivial to move, so that use after free shows up under sanitizers.
+        std::unique_ptr<std::size_t> checksum;
+    };
+
+    constexpr std::size_t rounds_count = 20;
+    constexpr std::size_t values_per_producer = 100000;
+    constexpr std::chrono::seconds test_timeout{ 120 };
+
+    bool run_round(std::size_t producers_count) {
+        mpsc_queue<test_value> queue{};
+        std::barrier start_line{ static_cast<std::ptrdiff_t>(producers_count + 1) };
+
+        std::vector<std::thread> producers{};
+        for (std::size_t producer_id = 0; producer_id < producers_count; ++producer_id) {
+            producers.emplace_back([&queue, &start_line, producer_id] {
+                start_line.arrive_and_wait();
+                for (std::size_t sequence_number = 0; sequence_number < values_per_producer; ++sequence_number) {
+                    queue.push({
+                        .producer_id = producer_id,
+                        .sequence_number = sequence_number,
+                        .checksum = std::make_unique<std::size_t>(producer_id ^ sequence_number)
+                    });
+
+                    queue.signal();
+                }
+            });
+        }
+
+        std::vector<std::size_t> next_sequence_numbers(producers_count, 0);
+        std::size_t values_left = producers_count * values_per_producer;
+        bool is_valid = true;
+
+        start_line.arrive_and_wait();
+        while (values_left != 0 && is_valid) {
+            queue.wait_for_signal();
+            while (std::optional<test_value> value = queue.try_pop()) {
+                if (value->producer_id >= producers_count ||
+                    value->sequence_number != next_sequence_numbers[value->producer_id] ||
+                    *value->checksum != (value->producer_id ^ value->sequence_number)) {
+                    std::fprintf(
+                        stderr,
+                        "Unexpected value %zu from producer %zu.\n",
+                        value->sequence_number,
+                        value->producer_id
+                    );
+
+                    is_valid = false;
+                    break;
+                }
+
+                ++next_sequence_numbers[value->producer_id];
+                --values_left;
+            }
+        }
+
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+
+        // Nothing may be left over once every value was received.
+        if (is_valid && queue.try_pop()) {
+            std::fprintf(stderr, "The queue returned more values than were pushed.\n");
+            is_valid = false;
+        }
+
+        return is_valid;
+    }
+}
+
+int main() {
+    // At least a few producers, even on small machines, preemption interleaves their pushes as well.
+    constexpr std::size_t min_producers_count = 4;
+    std::size_t producers_count = std::max<std::size_t>(std::thread::hardware_concurrency(), min_producers_count + 1) - 1;
+
+    // The consumer never gives up waiting, so a lost value or a lost signal would hang the test instead of failing it.
+    std::atomic<bool> is_finished{ false };
+    std::thread watchdog{ [&is_finished] {
+        auto deadline = std::chrono::steady_clock::now() + test_timeout;
+        while (!is_finished.load(std::memory_order_acquire)) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                std::fprintf(stderr, "Timed out: the consumer missed a value or a signal.\n");
+                std::abort();
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    } };
+
+    bool is_valid = true;
+    auto start_time = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds_count && is_valid; ++round) {
+        is_valid = run_round(producers_count);
+    }
+
+    auto elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+    is_finished.store(true, std::memory_order_release);
+    watchdog.join();
+
+    std::printf(
+        "%s: %zu rounds, %zu producers, %zu values per producer, %lld ms.\n",
+        is_valid ? "PASSED" : "FAILED",
+        rounds_count,
+        producers_count,
+        values_per_producer,
+        static_cast<long long>(elapsed_time.count())
+    );
+
+    return is_valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
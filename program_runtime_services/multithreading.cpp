@@ -136,11 +136,9 @@ module_mediator::return_value dynamic_call(module_mediator::arguments_string_typ
     else {
         LOG_PROGRAM_ERROR(
             interoperation::get_module_part(),
-            std::format(
-                "Function displacement '{}' is out of bounds for the current thread group jump table size '{}'.",
-                function_displacement,
-                get_current_thread_group_jump_table_size()
-            )
+            "Function displacement '{}' is out of bounds for the current thread group jump table size '{}'.",
+            function_displacement,
+            get_current_thread_group_jump_table_size()
         );
 
         return module_mediator::execution_result_terminate;
@@ -202,11 +200,9 @@ module_mediator::return_value create_thread(module_mediator::arguments_string_ty
     else {
         LOG_PROGRAM_ERROR(
              interoperation::get_module_part(),
-             std::format(
-                 "Function displacement '{}' is out of bounds for the current thread group jump table size '{}'.",
-                 function_displacement,
-                 get_current_thread_group_jump_table_size()
-             )
+             "Function displacement '{}' is out of bounds for the current thread group jump table size '{}'.",
+             function_displacement,
+             get_current_thread_group_jump_table_size()
          );
 
         return module_mediator::execution_result_terminate;
@@ -274,11 +270,9 @@ module_mediator::return_value create_thread_group(module_mediator::arguments_str
     else {
         LOG_PROGRAM_ERROR(
             interoperation::get_module_part(),
-            std::format(
-                "Function displacement '{}' is out of bounds for the current thread group jump table size '{}'.",
-                function_displacement,
-                get_current_thread_group_jump_table_size()
-            )
+            "Function displacement '{}' is out of bounds for the current thread group jump table size '{}'.",
+            function_displacement,
+            get_current_thread_group_jump_table_size()
         );
 
         return module_mediator::execution_result_terminate;
@@ -10,11 +10,14 @@
 //#include <vld.h>
 #endif
 
+// The Linux backends (*_backend_linux.cpp) are built with GCC or Clang, everything else needs MSVC.
+#ifdef _WIN32
 #ifndef _MSC_VER
 #error "Currently only MSVC is supported for the program runtime services module."
 #endif
 
 #include <Windows.h>
+#endif
 #include <memory>
 #include <vector>
 #include <utility>
@@ -28,8 +31,18 @@
 #include <thread>
 #include <limits>
 #include <barrier>
+#include <semaphore>
 #include <filesystem>
 #include <cassert>
 #include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+#include <array>
+#include <string>
+#include <chrono>
+#include <optional>
+#include <new>
+#include <span>
+#include <algorithm>
 
 #endif //PCH_H
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "standard_input_output.h"
 #include "backend_functions.h"
+#include "mpsc_queue.h"
+#include "stdio_backend.h"
 
 #include "../logger_module/logging.h"
 #include "../startup_components/local_crash_handlers.h"
@@ -9,1017 +11,306 @@
 // I use global variables because they are isolated to this cpp file, they cannot be accessed elsewhere.
 // You should view PRTS as an assortment of "classes" or "objects" that are isolated in their own cpp files.
 
+// The operating system side of IO (consoles, pipes, files) lives in stdio_backend_*.cpp, see stdio_backend.h.
+
 // Global synchronization primitives to ensure that IO can always be cancelled or processed correctly.
 namespace {
     // Ensures that you can't start attach operation for PRTS while detach is in progress, and vice versa.
     std::mutex stdio_control_synchronizer;
 
-    // Readers: input or output operations for stdin/stdout.
-    // Writers: functions that attach or detach PRTS from stdio.
-    // Ensures that all pending operations are completed before attach/detach occurs.
-    std::shared_mutex io_synchronizer;
-
     // Mostly bear a cosmetic effect.
     // 3: input_worker, output_worker, whatever thread calls detach or attach.
     std::barrier phase_coordination{ 3 };
 
     // PRTS expects that it is the only entity that can write to stdout and stdin to work correctly.
-    bool is_stdio_attached = false;
+    // Only changed by attach and detach, but can be read without any locks.
+    std::atomic<bool> is_stdio_attached{ false };
     bool check_stdio_attached() {
-        std::shared_lock lock(io_synchronizer);
-        return is_stdio_attached;
+        return is_stdio_attached.load(std::memory_order_acquire);
     }
-}
-
-// WinAPI thingies for console input/output management.
-namespace {
-    // Available only if attached.
-    HANDLE hCapturedStdOut;
-    HANDLE hCapturedStdIn;
-
-    // The handle to the worker thread that is responsible for reading from stdin.
-    // Allows to exit the thread gracefully when PRTS is detached from stdin.
-    HANDLE hIOCancellationSignal;
 
-    // The state of the console before PRTS attached to it.
-    DWORD dwSavedConsoleState;
+    // The amount of threads that are putting a request into one of the IO queues right now.
+    std::atomic<std::size_t> active_submitters{ 0 };
 
-    bool InitializeConsoleInput(HANDLE hStdin, DWORD& dwOutOriginalMode) {
-        if (!GetConsoleMode(hStdin, &dwOutOriginalMode)) {
-            return false;
-        }
+    /*
+    * Must be held while a request is put into an IO queue. This replaces locking the queues:
+    * 1. Submitter announces itself, then checks whether PRTS is attached.
+    * 2. Detach marks PRTS as detached, then waits until there are no submitters left.
+    * Both sides use sequentially consistent operations, so either the submitter sees that PRTS is detached,
+    * or detach waits for its request to be queued, and it will be cleaned up with the rest of the queue.
+    */
+    struct io_submission {
+        bool is_accepted;
 
-        // Keep only line input, echo, processed input; disable mouse/window events.
-        // Enable ASCII control characters processing with wrapping at EOL.
-        DWORD mode = ENABLE_LINE_INPUT
-                   | ENABLE_ECHO_INPUT
-                   | ENABLE_PROCESSED_INPUT
-                   | ENABLE_PROCESSED_OUTPUT
-                   | ENABLE_WRAP_AT_EOL_OUTPUT;  // NOLINT(misc-redundant-expression)
-        if (!SetConsoleMode(hStdin, mode)) {
-            return false;
+        io_submission() {
+            active_submitters.fetch_add(1, std::memory_order_seq_cst);
+            this->is_accepted = is_stdio_attached.load(std::memory_order_seq_cst);
         }
 
-        // Discard any pending input events (mouse, focus, etc.)
-        return FlushConsoleInputBuffer(hStdin) != FALSE;
-    } 
-
-    BOOL RestoreConsoleInput(HANDLE hStdin, DWORD dwOriginalMode) {
-        return SetConsoleMode(hStdin, dwOriginalMode);
-    }
+        io_submission(const io_submission&) = delete;
+        io_submission& operator= (const io_submission&) = delete;
 
-    void CloseHandleReport(HANDLE& handle, const char* lpsHandleName) {
-        if (handle != nullptr && handle != INVALID_HANDLE_VALUE) {
-            if (!CloseHandle(handle)) {
-                LOG_WARNING(
-                    interoperation::get_module_part(),
-                    std::format(
-                        "Failed to close {} handle with error code {}.",
-                        lpsHandleName,
-                        GetLastError()
-                    )
-                );
-            }
-            else {
-                handle = nullptr;
-            }
+        ~io_submission() noexcept {
+            active_submitters.fetch_sub(1, std::memory_order_release);
         }
-    }
-
-    std::pair<std::vector<char>, bool> ConsumeConsoleInput(HANDLE hStdIn, HANDLE hCancelIO) {
-        HANDLE haWaitingHandles[]{ hStdIn, hCancelIO };
-        std::vector<char> result{};
-
-        // Ensure that PRTS knows that we are waiting on console input, so that it can try and cancel it if needed.
-        std::shared_lock synchronous_io_lock{ io_synchronizer };
-        while (std::ranges::find(result, '\n') == result.end()) {
-            DWORD dwConsoleWaitResult = WaitForMultipleObjects(std::size(haWaitingHandles), haWaitingHandles, FALSE, INFINITE);
-            if (dwConsoleWaitResult == WAIT_OBJECT_0 + 1) {
-                return { {}, true }; // We received shutdown signal while waiting.
-            }
-
-            if (dwConsoleWaitResult == WAIT_OBJECT_0) {
-                DWORD dwAvailableInput = 0;
-                BOOL bEventsResult = GetNumberOfConsoleInputEvents(hStdIn, &dwAvailableInput);
-                if (!bEventsResult) {
-                    LOG_WARNING(
-                        interoperation::get_module_part(),
-                        std::format(
-                            "GetNumberOfConsoleInputEvents failed with error code {}. " \
-                            "Cannot read from console input.",
-                            GetLastError()
-                        )
-                    );
-
-                    return { {}, true };
-                }
-
-                constexpr DWORD dwBufferSize = 128;
-
-                INPUT_RECORD buffer[dwBufferSize];
-                DWORD dwReadEvents = 0;
-
-                DWORD dwAcquiredInput = std::min(dwAvailableInput, dwBufferSize);
-                BOOL bEventPeekedResult = PeekConsoleInputA(
-                    hStdIn,
-                    buffer,
-                    dwAcquiredInput,
-                    &dwReadEvents
-                );
-
-                if (!bEventPeekedResult) {
-                    LOG_WARNING(
-                        interoperation::get_module_part(),
-                        std::format(
-                            "ReadConsoleInput failed with error code {}. " \
-                            "Cannot read from console input.",
-                            GetLastError()
-                        )
-                    );
-
-                    return { {}, true };
-                }
+    };
+}
 
-#ifdef __clang__
-
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wtautological-constant-out-of-range-compare"
-
-#endif
-
-                WORD dwTotalTextSize = 0;
-                for (DWORD dwInputBufferIndex = 0; dwInputBufferIndex < dwReadEvents; ++dwInputBufferIndex) {
-                    if (buffer[dwInputBufferIndex].EventType == KEY_EVENT) {
-                        const KEY_EVENT_RECORD& keyEvent = buffer[dwInputBufferIndex].Event.KeyEvent;
-                        if (keyEvent.bKeyDown) {
-                            if (keyEvent.uChar.AsciiChar >= 0 && keyEvent.uChar.AsciiChar < 128) {  // NOLINT(clang-diagnostic-tautological-constant-out-of-range-compare)
-                                dwTotalTextSize += keyEvent.wRepeatCount;
-                            }
-                        }
-                        else if (keyEvent.wVirtualKeyCode == VK_RETURN) {
-                            dwTotalTextSize += 1;
-                        }
-                    }
-                }
+// Define IO queues for asynchronous input/output operations.
+namespace {
+    struct thread_input_descriptor {
+        module_mediator::return_value thread_id;
+        module_mediator::memory return_address;
 
-#ifdef __clang__
+        module_mediator::memory input_buffer;
+        module_mediator::eight_bytes buffer_size;
 
-#pragma clang diagnostic pop
+        // If set, the thread is woken up only when the buffer is full, or when no more input can be read.
+        // Otherwise it gets whatever input is available with one read.
+        bool fill_buffer{ false };
+    };
 
-#endif
+    struct thread_output_descriptor {
+        module_mediator::return_value thread_id;
 
-                if (dwTotalTextSize > 0) {
-                    DWORD dwTextRead = 0;
-                    std::unique_ptr<CHAR[]> lpTextBuffer{ new CHAR[dwTotalTextSize] };
+        module_mediator::memory buffer_address;
+        module_mediator::eight_bytes buffer_size;
 
-                    BOOL bConsoleReadResult = ReadConsoleA(
-                        hStdIn,
-                        lpTextBuffer.get(),
-                        dwTotalTextSize,
-                        &dwTextRead,
-                        nullptr 
-                    );
+        // Not empty if the output was buffered by PRTS, buffer_address points into it then.
+        std::vector<char> owned_buffer{};
 
-                    if (!bConsoleReadResult) {
-                        LOG_WARNING(
-                            interoperation::get_module_part(),
-                            std::format(
-                                "ReadConsole failed with error code {}. " \
-                                "Cannot read from console input.",
-                                GetLastError()
-                            )
-                        );
+        // Terminated threads don't wait for their output to be written.
+        bool wake_up_thread{ true };
+    };
 
-                        return { {}, true };
-                    }
+    // Both are used by their respective worker threads to ensure that all IO is asynchronous.
+    // Any executor can submit a request, and only the worker consumes them.
+    mpsc_queue<thread_input_descriptor> input_queue{};
 
-                    for (DWORD dwTextIndex = 0; dwTextIndex < dwTextRead; ++dwTextIndex) {
-                        if (lpTextBuffer[dwTextIndex] == '\x1a') {
-                            // Ctrl+Z is pressed, EOF.
-                            return { result, true };
-                        }
-                        if (lpTextBuffer[dwTextIndex] != '\r') {
-                            result.push_back(lpTextBuffer[dwTextIndex]);
-                        }
-                    }
-                }
-            }
-            else {
+    void clean_input_queue() {
+        bool is_warning_reported = false;
+        while (std::optional<thread_input_descriptor> pending_descriptor = input_queue.try_pop()) {
+            thread_input_descriptor& descriptor = *pending_descriptor;
+            if (!is_warning_reported) {
                 LOG_WARNING(
                     interoperation::get_module_part(),
-                    std::format(
-                        "Unexpected wait result {}. Received error: {}.",
-                        dwConsoleWaitResult,
-                        GetLastError()
-                    )
+                    "Input queue was not empty before detaching. All threads will be woken up."
                 );
 
-                return { {}, true };
+                is_warning_reported = true;
             }
-        }
 
-        return { result, false };
-    }
+            // So as not to trick the thread into reading or writing to a buffer that is not initialized.
+            module_mediator::eight_bytes input_size{ 0 };
+            std::memcpy(descriptor.return_address, &input_size, sizeof(module_mediator::eight_bytes));
 
-    // This function is unified for both file and pipe input.
-    // The absolute monster that handles both files and pipes. (Refactoring likely needed)
-    // With all possible edge cases and fallback to synchronous IO if overlapped IO fails.
-    template<auto file_type>
-    std::pair<std::vector<char>, bool> ConsumeAsynchronous(
-        HANDLE hStdIn, 
-        HANDLE hCancelIO, 
-        DWORD& dwOffset, 
-        DWORD& dwOffsetHigh
-    ) {
-        constexpr bool is_pipe = file_type == FILE_TYPE_PIPE;
-        HANDLE haWaitHandles[]{ hStdIn, hCancelIO };
-
-        OVERLAPPED overlapped{};
-        overlapped.hEvent = CreateEvent(
-            nullptr, 
-            TRUE,
-            FALSE,
-            nullptr 
-        );
-        
-        if (overlapped.hEvent == nullptr) {
-            LOG_WARNING(
+            module_mediator::fast_call<module_mediator::return_value>(
                 interoperation::get_module_part(),
-                std::format(
-                    "CreateEvent failed with error code {}. " \
-                    "Cannot perform asynchronous read operation for file.",
-                    GetLastError()
-                )
+                interoperation::index_getter::execution_module(),
+                interoperation::index_getter::execution_module_make_runnable(),
+                descriptor.thread_id
             );
-
-            return { {}, true };
-        }
-        
-        if constexpr (is_pipe) {
-            overlapped.Offset = 0;
-            overlapped.OffsetHigh = 0;
-        }
-        else {
-            overlapped.Offset = dwOffset;
-            overlapped.OffsetHigh = dwOffsetHigh;
-        }
-
-        constexpr DWORD dwDefaultBufferSize = 4096;
-        DWORD dwBufferSize = 0;
-
-        if constexpr (is_pipe) {
-            DWORD dwMessageLeft = 0;
-            PeekNamedPipe(hStdIn, nullptr, 0, nullptr, &dwBufferSize, &dwMessageLeft);
-
-            dwBufferSize = std::max(dwBufferSize, dwMessageLeft);
-            if (dwBufferSize == 0) { // If we still don't have any idea about what the buffer size should be.
-                dwBufferSize = dwDefaultBufferSize;
-            }
         }
-        else {
-            dwBufferSize = dwDefaultBufferSize;
-        }
-
-        std::unique_ptr<CHAR[]> buffer{ new CHAR[dwBufferSize] {} };
-        DWORD dwBytesRead = 0;
-        
-        BOOL bReadResult = ReadFile(
-            hStdIn,
-            buffer.get(),
-            dwBufferSize,
-            &dwBytesRead,
-            &overlapped
-        );
-        
-        if (!bReadResult) { // This is just how ridiculously complicated overlapped I/O is in Windows.
-            if (GetLastError() == ERROR_IO_PENDING) {
-                DWORD waitResult = WaitForMultipleObjects(
-                    std::size(haWaitHandles),
-                    haWaitHandles,
-                    FALSE,
-                    INFINITE
-                );
-
-                if (waitResult == WAIT_OBJECT_0) {
-                    if (!GetOverlappedResult(hStdIn, &overlapped, &dwBytesRead, FALSE)) {
-                        CloseHandleReport(overlapped.hEvent, "overlapped.hEvent");
-                        if (GetLastError() == ERROR_HANDLE_EOF) {
-                            return { { buffer.get(), buffer.get() + dwBytesRead }, false };
-                        }
-
-                        if constexpr (is_pipe) {
-                            if (GetLastError() == ERROR_BROKEN_PIPE) {
-                                LOG_WARNING(
-                                    interoperation::get_module_part(),
-                                    std::format(
-                                        "Pipe closed before detaching PRTS from stdio."
-                                    )
-                                );
-
-                                return { { buffer.get(), buffer.get() + dwBytesRead }, true};
-                            }
-
-                            if (GetLastError() == ERROR_MORE_DATA) {
-                                LOG_WARNING(
-                                    interoperation::get_module_part(),
-                                    std::format(
-                                        "Unexpected more data is available in a pipe. A second call will be required."
-                                    )
-                                );
-
-                                auto [result, shutdown] = 
-                                    ConsumeAsynchronous<file_type>(hStdIn, hCancelIO, dwOffset, dwOffsetHigh);
-
-                                result.insert(result.begin(), buffer.get(),
-                                    buffer.get() + dwBytesRead);
-
-                                return { result, shutdown };
-                            }
-                        }
-
-                        LOG_WARNING(
-                            interoperation::get_module_part(),
-                            std::format(
-                                "GetOverlappedResult failed with error code {}. " \
-                                "Cannot read from file.",
-                                GetLastError()
-                            )
-                        );
-
-                        return { {}, true };
-                    }
-                }
-                else if (waitResult == WAIT_OBJECT_0 + 1) {
-                    BOOL bIOCancelResult = CancelIo(hStdIn);
-                    if (!bIOCancelResult) {
-                        LOG_WARNING(
-                            interoperation::get_module_part(),
-                            std::format(
-                                "CancelIo failed with error code {}. "
-                                "Cannot cancel I/O operation.",
-                                GetLastError()
-                            )
-                        );
-                    }
-
-                    CloseHandleReport(overlapped.hEvent, "overlapped.hEvent");
-                    return { {}, true };
-                }
-                else {
-                    LOG_WARNING(
-                        interoperation::get_module_part(),
-                        std::format(
-                            "WaitForMultipleObjects failed with error code {}. " \
-                            "Cannot read from file.",
-                            GetLastError()
-                        )
-                    );
+    }
 
-                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                    return { {}, true };
-                }
-            }
-            else if (GetLastError() == ERROR_HANDLE_EOF) {
-                CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                return { {}, false };
-            }
-            else {
-                if constexpr (is_pipe) {
-                    if (GetLastError() == ERROR_BROKEN_PIPE) {
-                        LOG_WARNING(
-                            interoperation::get_module_part(),
-                            std::format(
-                                "Pipe closed before detaching PRTS from stdio."
-                            )
-                        );
+    mpsc_queue<thread_output_descriptor> output_queue{};
 
-                        CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                        return { { buffer.get(), buffer.get() + dwBytesRead }, true};
-                    }
+    // Requests that were queued, but not yet written. Allows detach to wait for the output of terminated threads.
+    std::atomic<std::size_t> unfinished_output_requests{ 0 };
 
-                    if (GetLastError() == ERROR_MORE_DATA) {
-                        LOG_WARNING(
-                            interoperation::get_module_part(),
-                            std::format(
-                                "Unexpected more data is available in a pipe. A second call will be required."
-                            )
-                        );
+    // Released by the output worker whenever it has written everything that was queued, detach waits on it.
+    // C++20 atomics can't wait with a timeout, the semaphore is built on the same wait/notify and can.
+    // Releases that nobody waited for are dropped by detach before it starts waiting.
+    std::counting_semaphore<> output_drained{ 0 };
 
-                        auto [result, shutdown] = 
-                            ConsumeAsynchronous<file_type>(hStdIn, hCancelIO, dwOffset, dwOffsetHigh);
+    void submit_output_request(thread_output_descriptor descriptor) {
+        unfinished_output_requests.fetch_add(1, std::memory_order_relaxed);
 
-                        result.insert(result.begin(), buffer.get(),
-                            buffer.get() + dwBytesRead);
-
-                        return { result, shutdown };
-                    }
-                }
+        output_queue.push(std::move(descriptor));
+        output_queue.signal();
+    }
 
-                std::shared_lock synchronous_io_lock{ io_synchronizer };
-                BOOL bSynchronousReadResult = ReadFile(
-                    hStdIn,
-                    buffer.get(),
-                    dwBufferSize - 1,
-                    &dwBytesRead,
-                    nullptr 
+    void clean_output_queue() {
+        bool is_warning_reported = false;
+        while (std::optional<thread_output_descriptor> pending_descriptor = output_queue.try_pop()) {
+            thread_output_descriptor& descriptor = *pending_descriptor;
+            if (!is_warning_reported) {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Output queue was not empty before detaching. All threads will be woken up."
                 );
 
-                synchronous_io_lock.unlock();
-                if (WaitForSingleObject(hCancelIO, 0) == WAIT_OBJECT_0 || GetLastError() == ERROR_OPERATION_ABORTED) {
-                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                    return { {}, true };
-                }
-
-                // This also means that EOF was reached. Applies to files only.
-                if (bSynchronousReadResult && dwBytesRead == 0) {
-                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                    return { {}, false };
-                }
-
-                if (!bSynchronousReadResult) {
-                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                    if constexpr (is_pipe) {
-                        if (GetLastError() == ERROR_BROKEN_PIPE) {
-                            LOG_WARNING(
-                                interoperation::get_module_part(),
-                                std::format(
-                                    "Pipe closed before detaching PRTS from stdio."
-                                )
-                            );
-
-                            return { { buffer.get(), buffer.get() + dwBytesRead }, true };
-                        }
-
-                        if (GetLastError() == ERROR_MORE_DATA) {
-                            LOG_WARNING(
-                                interoperation::get_module_part(),
-                                std::format(
-                                    "Unexpected more data is available in a pipe. A second call will be required."
-                                )
-                            );
-
-                            auto [result, shutdown] = 
-                                ConsumeAsynchronous<file_type>(hStdIn, hCancelIO, dwOffset, dwOffsetHigh);
-
-                            result.insert(result.begin(), buffer.get(),
-                                buffer.get() + dwBytesRead);
-
-                            return { result, shutdown };
-                        }
-                    }
-
-                    LOG_WARNING(
-                        interoperation::get_module_part(),
-                        std::format(
-                            "ReadFile failed with error code {}. " \
-                            "Cannot read from file both async and sync have failed.",
-                            GetLastError()
-                        )
-                    );
-
-                    return { {}, true };
-                }
+                is_warning_reported = true;
             }
-        }
-
-        // Files must have their offsets updated after a successful read.
-        if constexpr (!is_pipe) {
-            ULARGE_INTEGER newPosition;
-            newPosition.LowPart = dwOffset;
-            newPosition.HighPart = dwOffsetHigh;
-            newPosition.QuadPart += dwBytesRead;
-
-            dwOffset = newPosition.LowPart;
-            dwOffsetHigh = newPosition.HighPart;
-        }
-        
-        CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-        return { { buffer.get(), buffer.get() + dwBytesRead }, false};
-    }
 
-    // Dispatches the input reading operation based on the type of the input handle.
-    std::pair<std::vector<char>, bool> ConsumeStdIn(
-        HANDLE hStdIn, 
-        HANDLE hCancelIO, 
-        DWORD& dwOverlappedOffset, 
-        DWORD& dwOverlappedOffsetHigh
-    ) {
-        switch (GetFileType(hStdIn)) {
-            case FILE_TYPE_CHAR: {
-                return ConsumeConsoleInput(hStdIn, hCancelIO);
-            }
-            case FILE_TYPE_DISK: {
-                // For files and pipes, we are looking for a newline character to determine the end of input.
-                // All other input goes into the buffer.
-                return ConsumeAsynchronous<FILE_TYPE_DISK>(
-                    hStdIn,
-                    hCancelIO,
-                    dwOverlappedOffset,
-                    dwOverlappedOffsetHigh
-                );
-            }
-            case FILE_TYPE_PIPE: {
-               return ConsumeAsynchronous<FILE_TYPE_PIPE>(
-                    hStdIn,
-                    hCancelIO,
-                    dwOverlappedOffset,
-                    dwOverlappedOffsetHigh
-                );
-            }
-            default: {
-                LOG_WARNING(
+            if (descriptor.wake_up_thread) {
+                module_mediator::fast_call<module_mediator::return_value>(
                     interoperation::get_module_part(),
-                    std::format(
-                        "Unknown file type for STDIN: {}. " \
-                        "Cannot read from stdin. Shutting down the worker.",
-                        GetFileType(hCapturedStdIn)
-                    )
+                    interoperation::index_getter::execution_module(),
+                    interoperation::index_getter::execution_module_make_runnable(),
+                    descriptor.thread_id
                 );
-
-                return { {}, true };
             }
         }
+
+        unfinished_output_requests.store(0, std::memory_order_relaxed);
     }
 
-    bool PushConsoleOutput(
-        HANDLE hStdOut, 
-        module_mediator::memory output_buffer,
-        module_mediator::eight_bytes buffer_size
-    ) {
-        if (buffer_size == 0) {
-            return false;
-        }
-        if (buffer_size > std::numeric_limits<DWORD>::max()) {
-            LOG_WARNING(
-                interoperation::get_module_part(),
-                std::format(
-                    "Buffer size {} exceeds maximum allowed size of {}.",
-                    buffer_size,
-                    std::numeric_limits<DWORD>::max()
-                )
-            );
+    // Program threads accumulate their output here, so that printing in a loop does not block the thread on every call.
+    // A buffer is flushed when it grows past the threshold, on a new line (if stdout is a console), on io.std.flush,
+    // before its thread reads from stdin, or when its thread is destroyed.
+    namespace output_buffers {
+        constexpr std::size_t flush_threshold = 4096;
 
-            return true;
-        }
+        std::mutex lock;
+        std::unordered_map<module_mediator::return_value, std::vector<char>> buffers;
 
-        DWORD dwBytesWritten = 0;
-        std::shared_lock synchronous_io_lock{ io_synchronizer };
+        // Set on attach, before the workers are started.
+        std::atomic<bool> is_line_buffered{ false };
+    }
 
-        BOOL writeResult = WriteConsoleA(
-            hStdOut,
-            output_buffer,
-            static_cast<DWORD>(buffer_size),
-            &dwBytesWritten,
-            nullptr 
-        );
+    void clean_output_buffers() {
+        std::scoped_lock lock{ output_buffers::lock };
 
-        synchronous_io_lock.unlock();
-        if (GetLastError() == ERROR_OPERATION_ABORTED) {
-            return true;
+        std::size_t lost_output_size = 0;
+        for (auto& [thread_id, buffer] : output_buffers::buffers) {
+            lost_output_size += buffer.size();
+            buffer.clear();
         }
 
-        if (!writeResult || dwBytesWritten == 0) {
+        if (lost_output_size != 0) {
             LOG_WARNING(
                 interoperation::get_module_part(),
-                std::format(
-                    "WriteConsole failed with error code {}. " \
-                    "Cannot write to console.",
-                    GetLastError()
-                )
+                "Output buffers were not empty before detaching. {} byte(s) of output were discarded.",
+                lost_output_size
             );
-
-            return true;
         }
-
-        return false;
     }
 
-    // Similarly to ConsumeAsynchronous, this function handles both files and pipes.
-    // It uses overlapped IO for files and pipes, and falls back to synchronous IO if necessary.
-    template<auto file_type>
-    bool PushAsynchronous(
-        HANDLE hStdOut, 
-        HANDLE hCancelIO, 
-        module_mediator::memory output_buffer,
-        module_mediator::eight_bytes buffer_size,
-        DWORD& dwOffset, 
-        DWORD& dwOffsetHigh
-    ) {
-        constexpr bool is_pipe = file_type == FILE_TYPE_PIPE;
-        HANDLE waitHandles[]{ hStdOut, hCancelIO };
-
-        if (buffer_size == 0) {
-            return false;
-        }
-        if (buffer_size > std::numeric_limits<DWORD>::max()) {
-            LOG_WARNING(
-                interoperation::get_module_part(),
-                std::format(
-                    "Buffer size {} exceeds maximum allowed size of {}.",
-                    buffer_size,
-                    std::numeric_limits<DWORD>::max()
-                )
-            );
-
-            return true;
-        }
-
-        OVERLAPPED overlapped{};
-        overlapped.hEvent = CreateEvent(
-            nullptr,
-            TRUE,
-            FALSE,
-            nullptr 
-        );
-
-        if (overlapped.hEvent == nullptr) {
-            LOG_WARNING(
-                interoperation::get_module_part(),
-                std::format(
-                    "CreateEvent failed with error code {}. " \
-                    "Cannot perform asynchronous write operation.",
-                    GetLastError()
-                )
+    // Makes sure that whatever is left in the buffer of a thread will be written when the thread is destroyed.
+    void register_output_buffer_destroy_callback(module_mediator::return_value thread_id) {
+        module_mediator::callback_bundle* callback_structure =
+            module_mediator::create_callback<module_mediator::return_value>(
+                "prts",
+                "flush_thread_output_on_destroy",
+                thread_id
             );
 
-            return true;
-        }
-
-        if constexpr (is_pipe) {
-            overlapped.Offset = 0;
-            overlapped.OffsetHigh = 0;
-        }
-        else {
-            overlapped.Offset = dwOffset;
-            overlapped.OffsetHigh = dwOffsetHigh;
-        }
-
-        DWORD dwBytesWritten = 0;
-        BOOL bWriteResult = WriteFile(
-            hStdOut,
-            output_buffer,
-            static_cast<DWORD>(buffer_size),
-            &dwBytesWritten,
-            &overlapped
+        module_mediator::fast_call<module_mediator::return_value, module_mediator::memory>(
+            interoperation::get_module_part(),
+            interoperation::index_getter::resource_module(),
+            interoperation::index_getter::resource_module_add_thread_on_destroy(),
+            thread_id,
+            callback_structure
         );
-
-        if (!bWriteResult) {
-            if (GetLastError() == ERROR_IO_PENDING) {
-                DWORD dwWaitResult = WaitForMultipleObjects(
-                    std::size(waitHandles),
-                    waitHandles,
-                    FALSE,
-                    INFINITE
-                );
-
-                if (dwWaitResult == WAIT_OBJECT_0) {
-                    if (!GetOverlappedResult(hStdOut, &overlapped, &dwBytesWritten, FALSE)) {
-                        LOG_WARNING(
-                            interoperation::get_module_part(),
-                            std::format(
-                                "GetOverlappedResult failed with error code {}. " \
-                                "Cannot write to file. Is pipe: {}.",
-                                GetLastError(),
-                                is_pipe
-                            )
-                        );
-
-                        CloseHandle(overlapped.hEvent);
-                        return true;
-                    }
-                }
-                else if (dwWaitResult == WAIT_OBJECT_0 + 1) {
-                    BOOL bIOCancelResult = CancelIo(hStdOut);
-                    if (!bIOCancelResult) {
-                        LOG_WARNING(
-                            interoperation::get_module_part(),
-                            std::format(
-                                "CancelIo failed with error code {}. " \
-                                "Cannot cancel I/O operation. Is pipe: {}.",
-                                GetLastError(),
-                                is_pipe
-                            )
-                        );
-                    }
-
-                    CloseHandle(overlapped.hEvent);
-                    return true;
-                }
-                else {
-                    LOG_WARNING(
-                        interoperation::get_module_part(),
-                        std::format(
-                            "WaitForSingleObject failed with error code {}. " \
-                            "Cannot write to file/pipe. Is pipe: {}.",
-                            GetLastError(),
-                            is_pipe
-                        )
-                    );
-
-                    return true;
-                }
-            }
-            else {
-                if constexpr (is_pipe) {
-                    if (GetLastError() == ERROR_BROKEN_PIPE) {
-                        LOG_WARNING(
-                            interoperation::get_module_part(),
-                            std::format(
-                                "Pipe closed before detaching PRTS from stdio."
-                            )
-                        );
-
-                        CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                        return true;
-                    }
-                }
-
-                std::shared_lock synchronous_io_lock{ io_synchronizer };
-                BOOL bSynchronousWriteResult = WriteFile(
-                    hStdOut,
-                    output_buffer,
-                    static_cast<DWORD>(buffer_size),
-                    &dwBytesWritten,
-                    nullptr 
-                );
-
-                synchronous_io_lock.unlock();
-                if (WaitForSingleObject(hCancelIO, 0) == WAIT_OBJECT_0 || GetLastError() == ERROR_OPERATION_ABORTED) {
-                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                    return true;
-                }
-
-                if (!bSynchronousWriteResult) {
-                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                    LOG_WARNING(
-                        interoperation::get_module_part(),
-                        std::format(
-                            "WriteFile failed with error code {}. " \
-                            "Cannot write to file both async and sync have failed. Is pipe: {}.",
-                            GetLastError(),
-                            is_pipe
-                        )
-                    );
-
-                    return true;
-                }
-            }
-        }
-
-        if constexpr (!is_pipe) {
-            BOOL bResult = FlushFileBuffers(hStdOut);
-            if (!bResult) {
-                LOG_WARNING(
-                    interoperation::get_module_part(),
-                    std::format(
-                        "FlushFileBuffers failed with error code {}. " \
-                        "Cannot flush file buffers.",
-                        GetLastError()
-                    )
-                );
-
-                CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-                return true;
-            }
-        }
-
-        // Files must have their offsets updated after a successful write.
-        CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
-        if constexpr (!is_pipe) {
-            ULARGE_INTEGER newPosition;
-            newPosition.LowPart = dwOffset;
-            newPosition.HighPart = dwOffsetHigh;
-            newPosition.QuadPart += dwBytesWritten;
-
-            dwOffset = newPosition.LowPart;
-            dwOffsetHigh = newPosition.HighPart;
-        }
-
-        return false;
     }
 
-    bool PushStdOut(
-        HANDLE hStdOut, 
-        HANDLE hCancelIO, 
-        module_mediator::memory output_buffer, 
-        module_mediator::eight_bytes buffer_size, 
-        DWORD& dwOverlappedOffset, 
-        DWORD& dwOverlappedOffsetHigh
-    ) {
-        switch (GetFileType(hStdOut)) {
-            case FILE_TYPE_CHAR: {
-                return PushConsoleOutput(hStdOut, output_buffer, buffer_size);
-            }
-            case FILE_TYPE_DISK: {
-                return PushAsynchronous<FILE_TYPE_DISK>(
-                    hStdOut,
-                    hCancelIO,
-                    output_buffer,
-                    buffer_size,
-                    dwOverlappedOffset,
-                    dwOverlappedOffsetHigh
-                );
-            }
-            case FILE_TYPE_PIPE: {
-                return PushAsynchronous<FILE_TYPE_PIPE>(
-                    hStdOut,
-                    hCancelIO,
-                    output_buffer,
-                    buffer_size,
-                    dwOverlappedOffset,
-                    dwOverlappedOffsetHigh
-                );
-            }
-            default: {
-                LOG_WARNING(
-                    interoperation::get_module_part(),
-                    std::format(
-                        "Unknown file type for STDOUT: {}. " \
-                        "Cannot write to stdout.",
-                        GetFileType(hCapturedStdOut)
-                    )
-                );
+    // Takes whatever the thread has put into its output buffer. The buffer itself stays registered.
+    std::vector<char> take_output_buffer(module_mediator::return_value thread_id) {
+        std::scoped_lock buffers_lock{ output_buffers::lock };
 
-                return true;
-            }
+        auto buffer_iterator = output_buffers::buffers.find(thread_id);
+        if (buffer_iterator == output_buffers::buffers.end()) {
+            return {};
         }
-    }
-}
-
-// Define IO queues for asynchronous input/output operations.
-namespace {
-    struct thread_input_descriptor {
-        module_mediator::return_value thread_id;
-        module_mediator::memory return_address;
-
-        module_mediator::memory input_buffer;
-        module_mediator::eight_bytes buffer_size;
-    };
-
-    struct thread_output_descriptor {
-        module_mediator::return_value thread_id;
-
-        module_mediator::memory buffer_address;
-        module_mediator::eight_bytes buffer_size;
-    };
 
-    // Both are used by their respective worker threads to ensure that all IO is asynchronous.
-    namespace input_queue {
-        std::mutex lock;
-        std::condition_variable signaling;
-        std::queue<thread_input_descriptor> input_queue;
+        return std::exchange(buffer_iterator->second, {});
     }
 
-    void clean_input_queue() {
-        if (!input_queue::input_queue.empty()) {
+    // Queues the output without blocking its thread. Returns false if PRTS was detached and the output was discarded.
+    bool submit_detached_output(module_mediator::return_value thread_id, std::vector<char> buffer) {
+        io_submission submission{};
+        if (!submission.is_accepted) {
             LOG_WARNING(
                 interoperation::get_module_part(),
-                "Input queue was not empty before detaching. All threads will be woken up."
+                "PRTS was detached from stdio before the output of the thread {} was flushed. {} byte(s) of output were discarded.",
+                thread_id,
+                buffer.size()
             );
-        }
 
-        while (!input_queue::input_queue.empty()) {
-            thread_input_descriptor descriptor = std::move(input_queue::input_queue.front());
-            input_queue::input_queue.pop();
+            return false;
+        }
 
-            // So as not to trick the thread into reading or writing to a buffer that is not initialized.
-            module_mediator::eight_bytes input_size{ 0 };
-            std::memcpy(descriptor.input_buffer, &input_size, sizeof(module_mediator::eight_bytes));
+        thread_output_descriptor descriptor{
+            .thread_id = thread_id,
+            .buffer_address = nullptr,
+            .buffer_size = buffer.size(),
+            .owned_buffer = std::move(buffer),
+            .wake_up_thread = false
+        };
 
-            module_mediator::fast_call<module_mediator::return_value>(
-                interoperation::get_module_part(),
-                interoperation::index_getter::execution_module(),
-                interoperation::index_getter::execution_module_make_runnable(),
-                descriptor.thread_id
-            );
-        }
-    }
+        descriptor.buffer_address = descriptor.owned_buffer.data();
+        submit_output_request(std::move(descriptor));
 
-    namespace output_queue {
-        std::mutex lock;
-        std::condition_variable signaling;
-        std::queue<thread_output_descriptor> output_queue;
+        return true;
     }
 
-    void clean_output_queue() {
-        if (!output_queue::output_queue.empty()) {
-            LOG_WARNING(
-                interoperation::get_module_part(),
-                "Output queue was not empty before detaching. All threads will be woken up."
+    // Blocks the current thread until the buffer is written. Takes ownership of the buffer.
+    module_mediator::return_value submit_buffered_output(std::vector<char>* buffer) {
+        module_mediator::callback_bundle* callback_structure =
+            module_mediator::create_callback<module_mediator::return_value, module_mediator::memory>(
+                "prts",
+                "callback_register_buffered_output",
+                interoperation::get_current_thread_id(),
+                buffer
             );
-        }
 
-        while (!output_queue::output_queue.empty()) {
-            thread_output_descriptor descriptor = std::move(output_queue::output_queue.front());
-            output_queue::output_queue.pop();
-            module_mediator::fast_call<module_mediator::return_value>(
-                interoperation::get_module_part(),
-                interoperation::index_getter::execution_module(),
-                interoperation::index_getter::execution_module_make_runnable(),
-                descriptor.thread_id
-            );
-        }
+        module_mediator::fast_call<module_mediator::memory>(
+            interoperation::get_module_part(),
+            interoperation::index_getter::execution_module(),
+            interoperation::index_getter::execution_module_register_deferred_callback(),
+            callback_structure
+        );
+
+        return module_mediator::execution_result_block;
     }
 }
 
 // IO worker threads.
 namespace {
     std::thread input_worker_thread{};
-    void input_worker(HANDLE hStdIn, HANDLE hCancelIO) {
+    void input_worker() {
         // We can't call this after LOG_* function, because it might fail.
         startup_components::crash_handling::install_local_crash_handlers();
-
-        LOG_INFO(
-            interoperation::get_module_part(),
-            std::format(
-                "PRTS is attached to stdio. Starting input worker. System thread is: {}.",
-                GetCurrentThreadId()
-            )
-        );
-
-        ULONG ulDesiredStackSize = 8192;
-        BOOL bResult = SetThreadStackGuarantee(&ulDesiredStackSize);
-        if (!bResult) {
-            LOG_WARNING(
-                interoperation::get_module_part(),
-                "Failed to set thread stack guarantee for input worker. " \
-                "This may impede fatal error reporting."
-            );
-        }
+        stdio_backend::prepare_worker_thread("input");
 
         phase_coordination.arrive_and_wait();
 
-        DWORD dwOverlappedOffset = 0;
-        DWORD dwOverlappedOffsetHigh = 0;
-
-        std::vector<char> global_input_buffer{};
         bool input_shutdown = false;
 
         while (check_stdio_attached()) {
             std::queue<thread_input_descriptor> local_input_queue{};
-            std::unique_lock lock(input_queue::lock);
-
-            input_queue::signaling.wait(lock, [] {
-                return !check_stdio_attached() || !input_queue::input_queue.empty();
-            });
+            input_queue.wait_for_signal();
 
             // Exit prematurely if PRTS is detached from stdio.
             if (!check_stdio_attached()) {
                 break;
             }
 
-            while (!input_queue::input_queue.empty()) {
-                local_input_queue.push(std::move(input_queue::input_queue.front()));
-                input_queue::input_queue.pop();
+            while (std::optional<thread_input_descriptor> descriptor = input_queue.try_pop()) {
+                local_input_queue.push(std::move(*descriptor));
             }
 
-            lock.unlock(); // It is critical that we do not hold the lock while processing input.
             while (!local_input_queue.empty()) {
                 thread_input_descriptor descriptor = std::move(local_input_queue.front());
-                std::vector<char> input_portion{};
 
-                if (!global_input_buffer.empty() && global_input_buffer.size() <= descriptor.buffer_size) {
-                    input_portion = std::move(global_input_buffer);
-                    global_input_buffer = {};
-                }
-                else if (descriptor.buffer_size < global_input_buffer.size()) {
-                    input_portion.insert(
-                        input_portion.end(),
-                        global_input_buffer.begin(),
-                        global_input_buffer.begin() + static_cast<std::ptrdiff_t>(descriptor.buffer_size)
-                    );
+                // Input goes straight into the program memory, PRTS does not stage it.
+                char* input_buffer = static_cast<char*>(descriptor.input_buffer);
+                module_mediator::eight_bytes input_size{ 0 };
 
-                    global_input_buffer.erase(
-                        global_input_buffer.begin(),
-                        global_input_buffer.begin() + static_cast<std::ptrdiff_t>(descriptor.buffer_size)
-                    );
-                }
-                else if (!input_shutdown) {
-                    auto [input_data, shutdown_requested] =
-                        ConsumeStdIn(hStdIn, hCancelIO, dwOverlappedOffset, dwOverlappedOffsetHigh);
+                while (!input_shutdown && input_size < descriptor.buffer_size) {
+                    auto [bytes_read, shutdown_requested] = 
+                        stdio_backend::read_input(input_buffer + input_size, descriptor.buffer_size - input_size);
 
                     input_shutdown = shutdown_requested;
-                    std::size_t additional_input = descriptor.buffer_size - input_portion.size();
-
-                    std::ptrdiff_t consume_end =
-                        static_cast<std::ptrdiff_t>(std::min(additional_input, input_data.size()));
-
-                    input_portion.insert(
-                        input_portion.end(),
-                        input_data.begin(),
-                        input_data.begin() + consume_end
-                    );
+                    input_size += bytes_read;
 
-                    global_input_buffer.insert(
-                        global_input_buffer.end(),
-                        input_data.begin() + consume_end,
-                        input_data.end()
-                    );
+                    // EOF, or the thread is fine with whatever input is available right now.
+                    if (bytes_read == 0 || !descriptor.fill_buffer) {
+                        break;
+                    }
                 }
 
-                module_mediator::eight_bytes input_size{ input_portion.size() };
-
-                std::memcpy(descriptor.input_buffer, input_portion.data(), input_portion.size());
                 std::memcpy(descriptor.return_address, &input_size, sizeof(module_mediator::eight_bytes));
 
                 local_input_queue.pop();
@@ -1040,66 +331,87 @@ namespace {
     }
 
     std::thread output_worker_thread{};
-    void output_worker(HANDLE hStdOut, HANDLE hCancelIO) {
+    void output_worker() {
         // We can't call this after LOG_* function, because it might fail.
         startup_components::crash_handling::install_local_crash_handlers();
-
-        LOG_INFO(
-            interoperation::get_module_part(),
-            std::format(
-                "PRTS is attached to stdio. Starting output worker. System thread is: {}.",
-                GetCurrentThreadId()
-            )
-        );
-
-        ULONG ulDesiredStackSize = 8192;
-        BOOL bResult = SetThreadStackGuarantee(&ulDesiredStackSize);
-        if (!bResult) {
-            LOG_WARNING(
-                interoperation::get_module_part(),
-                "Failed to set thread stack guarantee for output worker. " \
-                "This may impede fatal error reporting."
-            );
-        }
+        stdio_backend::prepare_worker_thread("output");
 
         phase_coordination.arrive_and_wait();
 
-        DWORD dwOverlappedOffset = 0;
-        DWORD dwOverlappedOffsetHigh = 0;
+        // Everything that was queued while we were busy is written with one call.
+        // Each thread has at most one pending output request (it is blocked until the request is done), and requests
+        // are concatenated in the order they were queued, so the output of each thread stays in order.
+        constexpr std::size_t max_coalesced_output_size = 1024 * 1024;
+        std::vector<char> coalesced_output{};
 
         bool output_shutdown = false;
         while (check_stdio_attached()) {
-            std::unique_lock lock(output_queue::lock);
-            output_queue::signaling.wait(lock, [] {
-                return  !check_stdio_attached() || !output_queue::output_queue.empty();
-            });
+            std::vector<thread_output_descriptor> local_output_queue{};
+            output_queue.wait_for_signal();
 
             if (!check_stdio_attached()) {
                 break;
             }
 
-            thread_output_descriptor descriptor = std::move(output_queue::output_queue.front());
-            output_queue::output_queue.pop();
+            while (std::optional<thread_output_descriptor> descriptor = output_queue.try_pop()) {
+                local_output_queue.push_back(std::move(*descriptor));
+            }
 
-            lock.unlock(); // It is critical that we do not hold the lock while processing output.
+            std::size_t batch_begin = 0;
+            while (batch_begin < local_output_queue.size()) {
+                std::size_t batch_end = batch_begin + 1;
+                std::uint64_t batch_size = local_output_queue[batch_begin].buffer_size;
+                while (batch_end < local_output_queue.size() && 
+                       batch_size + local_output_queue[batch_end].buffer_size <= max_coalesced_output_size) {
+                    batch_size += local_output_queue[batch_end].buffer_size;
+                    ++batch_end;
+                }
 
-            if (!output_shutdown) {
-                output_shutdown = PushStdOut(
-                    hStdOut,
-                    hCancelIO,
-                    descriptor.buffer_address,
-                    descriptor.buffer_size,
-                    dwOverlappedOffset,
-                    dwOverlappedOffsetHigh
-                );
+                module_mediator::memory batch_buffer = local_output_queue[batch_begin].buffer_address;
+                if (batch_end - batch_begin > 1) { // A single request is written directly from the program memory.
+                    coalesced_output.clear();
+                    for (std::size_t index = batch_begin; index < batch_end; ++index) {
+                        const char* buffer = static_cast<const char*>(local_output_queue[index].buffer_address);
+                        coalesced_output.insert(
+                            coalesced_output.end(), 
+                            buffer, 
+                            buffer + local_output_queue[index].buffer_size
+                        );
+                    }
+
+                    batch_buffer = coalesced_output.data();
+                }
+
+                if (!output_shutdown) {
+                    output_shutdown = stdio_backend::write_output(batch_buffer, batch_size);
+                }
+
+                for (std::size_t index = batch_begin; index < batch_end; ++index) {
+                    if (!local_output_queue[index].wake_up_thread) {
+                        continue;
+                    }
+
+                    module_mediator::fast_call<module_mediator::return_value>(
+                        interoperation::get_module_part(),
+                        interoperation::index_getter::execution_module(),
+                        interoperation::index_getter::execution_module_make_runnable(),
+                        local_output_queue[index].thread_id
+                    );
+                }
+
+                batch_begin = batch_end;
             }
 
-            module_mediator::fast_call<module_mediator::return_value>(
-                interoperation::get_module_part(),
-                interoperation::index_getter::execution_module(),
-                interoperation::index_getter::execution_module_make_runnable(),
-                descriptor.thread_id
-            );
+            std::size_t finished_requests = local_output_queue.size();
+            if (finished_requests != 0 && 
+                unfinished_output_requests.fetch_sub(finished_requests, std::memory_order_release) == finished_requests) {
+                output_drained.release();
+            }
+
+            // Don't keep a huge buffer around after a burst of output.
+            if (coalesced_output.capacity() > max_coalesced_output_size) {
+                coalesced_output = {};
+            }
         }
 
         phase_coordination.arrive_and_wait();
@@ -1112,164 +424,68 @@ namespace {
 
 module_mediator::return_value attach_to_stdio(module_mediator::arguments_string_type) {
     std::scoped_lock stdio_control_lock{ stdio_control_synchronizer };
-    std::scoped_lock lock{ io_synchronizer };
-
-    if (is_stdio_attached) {
+    if (check_stdio_attached()) {
         return module_mediator::module_success;
     }
 
-    hCapturedStdOut = GetStdHandle(STD_OUTPUT_HANDLE);
-    if (hCapturedStdOut == INVALID_HANDLE_VALUE || hCapturedStdOut == nullptr) {
-       LOG_WARNING(
-           interoperation::get_module_part(),
-            std::format(
-                "Failed to get STDOUT handle with error code {}. ",
-                GetLastError()
-            )
-       );
-
-       return module_mediator::module_failure;
-    }
-
-    hCapturedStdIn = GetStdHandle(STD_INPUT_HANDLE);
-    if (hCapturedStdIn == INVALID_HANDLE_VALUE || hCapturedStdIn == nullptr) {
-        LOG_WARNING(
-            interoperation::get_module_part(),
-            std::format(
-                "Failed to get STDIN handle with error code {}. ",
-                GetLastError()
-            )
-        );
-
-        hCapturedStdOut = nullptr;
-        return module_mediator::module_failure;
-    }
-
-    if (GetFileType(hCapturedStdIn) == FILE_TYPE_CHAR && !InitializeConsoleInput(hCapturedStdIn, dwSavedConsoleState)) {
-        LOG_WARNING(
-            interoperation::get_module_part(),
-            std::format(
-                "Failed to initialize console input with error code {}." \
-                "Unexpected console handle.",
-                GetLastError()
-            )
-        );
-
-        hCapturedStdIn = nullptr;
-        hCapturedStdOut = nullptr;
-
+    // Workers are not running at this point, so the backend can be set up without any other locks.
+    if (!stdio_backend::capture()) {
         return module_mediator::module_failure;
     }
 
     is_stdio_attached = true;
-    hIOCancellationSignal = CreateEventA(
-        nullptr, 
-        TRUE,    
-        FALSE,   
-        nullptr 
-    );
+    output_buffers::is_line_buffered = stdio_backend::is_output_interactive();
 
-    input_worker_thread = std::thread(input_worker, hCapturedStdIn, hIOCancellationSignal);
-    output_worker_thread = std::thread(output_worker, hCapturedStdOut, hIOCancellationSignal);
+    input_worker_thread = std::thread(input_worker);
+    output_worker_thread = std::thread(output_worker);
 
     phase_coordination.arrive_and_wait();
     return module_mediator::module_success;
 }
 
 module_mediator::return_value detach_from_stdio(module_mediator::arguments_string_type) {
-    // Detach operation will stop holding io_synchronizer lock after it sets is_stdio_attached to false,
-    // and detects that both worker threads are either waiting on their condition variables or are yet to acquire their locks.
+    // Detach operation will stop holding the backend IO lock after it sets is_stdio_attached to false.
     // However, it still has some cleanup to do, and while doing so it must ensure that it won't run into data race with
     // attach_to_stdio. Thus, we need to hold stdio_control_synchronizer for the entire duration of this function.
     // This lock is used only by attach_to_stdio and detach_from_stdio, and they always try to acquire it first,
-    // before acquiring io_synchronizer, so this should not lead to a deadlock.
+    // before interrupting the workers, so this should not lead to a deadlock.
     std::scoped_lock stdio_control_lock{ stdio_control_synchronizer };
 
     {
-        std::unique_lock io_lock(io_synchronizer, std::defer_lock);
-        std::unique_lock input_lock(input_queue::lock, std::defer_lock);
-        std::unique_lock output_lock(output_queue::lock, std::defer_lock);
-
-        // We must ensure that workers are either already waiting on their respective condition variables or
-        // are yet to acquire their locks. This avoids a potential deadlock when they check whether we are
-        // attached to stdio, and we instantly detach from it.
-        // Notice that we must use custom backoff algorithm here to avoid another possible deadlock. Simply acquiring mutexes
-        // in some specific order won't cut it here.
-
-        bool first_io_synchronizer_acquire = true;
-        while (true) {
-            std::this_thread::yield();
-            if (!io_lock.try_lock()) {
-                //Error not found is documented to be returned if the thread is not waiting on synchronous IO.
-                BOOL cancelSynchronousInput = CancelSynchronousIo(input_worker_thread.native_handle());
-                if (!cancelSynchronousInput && GetLastError() != ERROR_NOT_FOUND) {
-                    LOG_WARNING(
-                        interoperation::get_module_part(),
-                        std::format(
-                            "Failed to cancel synchronous I/O for input worker with error code {}. " \
-                            "This may lead to resource leaks.",
-                            GetLastError()
-                        )
-                    );
-
-                    return module_mediator::module_failure;
-                }
-
-                BOOL cancelSynchronousOutput = CancelSynchronousIo(output_worker_thread.native_handle());
-                if (!cancelSynchronousOutput && GetLastError() != ERROR_NOT_FOUND) {
-                    LOG_WARNING(
-                        interoperation::get_module_part(),
-                        std::format(
-                            "Failed to cancel synchronous I/O for output worker with error code {}. " \
-                            "This may lead to resource leaks.",
-                            GetLastError()
-                        )
-                    );
-
-                    return module_mediator::module_failure;
-                }
-
-                continue;
-            }
-
-            is_stdio_attached = false;
-            if (first_io_synchronizer_acquire && hIOCancellationSignal != nullptr) {
-                // Start by setting IO cancellation event so that worker threads can exit overlapped IO, and console IO operations.
-                BOOL signalIOEnd = SetEvent(hIOCancellationSignal);
-                if (!signalIOEnd) {
-                    LOG_WARNING(
-                        interoperation::get_module_part(),
-                        std::format(
-                            "Failed to set event for I/O cancellation with error code {}. " \
-                            "This will lead to resource leaks. Detaching worker threads as a last-ditch effort.",
-                            GetLastError()
-                        )
-                    );
-
-                    input_worker_thread.detach();
-                    output_worker_thread.detach();
+        // Terminated threads don't wait for their buffered output to be written.
+        // Give the output worker a chance to write it before we shut it down.
+        constexpr std::chrono::seconds output_drain_timeout{ 5 };
+        while (output_drained.try_acquire()) {}
+
+        auto drain_deadline = std::chrono::steady_clock::now() + output_drain_timeout;
+        while (check_stdio_attached() && unfinished_output_requests.load(std::memory_order_acquire) != 0) {
+            if (!output_drained.try_acquire_until(drain_deadline)) {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Output worker did not finish {} pending request(s) in time. Their output may be lost.",
+                    unfinished_output_requests.load(std::memory_order_relaxed)
+                );
 
-                    return module_mediator::module_failure;
-                }
+                break;
             }
+        }
+    }
 
-            first_io_synchronizer_acquire = false;
-            if (!input_lock.try_lock()) {
-                io_lock.unlock();
-                continue;
-            }
+    {
+        std::unique_lock io_lock = stdio_backend::interrupt_workers(input_worker_thread, output_worker_thread);
+        if (!io_lock.owns_lock()) {
+            return module_mediator::module_failure;
+        }
 
-            if (!output_lock.try_lock()) {
-                io_lock.unlock();
-                input_lock.unlock();
-                continue;
-            }
+        is_stdio_attached.store(false, std::memory_order_seq_cst);
+        if (!stdio_backend::signal_shutdown()) {
+            input_worker_thread.detach();
+            output_worker_thread.detach();
 
-            break;
+            return module_mediator::module_failure;
         }
 
-        if (hCapturedStdIn == nullptr || hCapturedStdOut == nullptr || hIOCancellationSignal == nullptr) {
-            assert(hCapturedStdIn == nullptr && hCapturedStdOut == nullptr && hIOCancellationSignal == nullptr);
+        if (!stdio_backend::is_captured()) {
             LOG_INFO(
                 interoperation::get_module_part(),
                 "PRTS was not attached to stdio. Nothing to detach."
@@ -1279,11 +495,15 @@ module_mediator::return_value detach_from_stdio(module_mediator::arguments_strin
         }
     }
 
-    // We already know that both (or at least one) worker threads are either
-    // waiting on their condition variables or are yet to acquire their locks.
-    // In the last case they will read is_stdio_attached false and exit.
-    input_queue::signaling.notify_one();
-    output_queue::signaling.notify_one();
+    // Nobody can put a request into the queues after this point (see io_submission).
+    while (active_submitters.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+
+    // Workers are either waiting for a signal or are yet to do so. In the last case they will read 
+    // is_stdio_attached false and exit, or return from waiting immediately.
+    input_queue.signal();
+    output_queue.signal();
 
     // This will block if the shutdown sequence fails.
     phase_coordination.arrive_and_wait();
@@ -1293,29 +513,12 @@ module_mediator::return_value detach_from_stdio(module_mediator::arguments_strin
 
     clean_input_queue();
     clean_output_queue();
+    clean_output_buffers();
 
-    CloseHandleReport(hIOCancellationSignal, "hIOCancellationSignal");
-    hIOCancellationSignal = nullptr;
-
-    if (GetFileType(hCapturedStdIn) == FILE_TYPE_CHAR && !RestoreConsoleInput(hCapturedStdIn, dwSavedConsoleState)) {
-        LOG_WARNING(
-            interoperation::get_module_part(),
-            std::format(
-                "Failed to restore console input with error code {}. " \
-                "This error may be generated if stdio is redirected.",
-                GetLastError()
-            )
-        );
-
-        hCapturedStdOut = nullptr;
-        hCapturedStdIn = nullptr;
-
+    if (!stdio_backend::release()) {
         return module_mediator::module_failure;
     }
 
-    hCapturedStdOut = nullptr;
-    hCapturedStdIn = nullptr;
-
     return module_mediator::module_success;
 }
 
@@ -1323,15 +526,13 @@ module_mediator::return_value callback_register_output(module_mediator::argument
     auto [thread_id, buffer_address, buffer_size] = 
         module_mediator::respond_callback<module_mediator::return_value, module_mediator::memory, module_mediator::eight_bytes>::unpack(bundle);
 
-    std::unique_lock lock(output_queue::lock);
-    if (!check_stdio_attached()) { // This should not ever lead to a deadlock because we are using a shared lock.
+    io_submission submission{};
+    if (!submission.is_accepted) {
         LOG_WARNING(
             interoperation::get_module_part(),
-            std::format(
-                "Concurrency error: PRTS was detached from stdio before the thread was added to the output queue." \
-                "Waking up the thread {}.",
-                thread_id
-            ) 
+            "Concurrency error: PRTS was detached from stdio before the thread was added to the output queue." \
+            "Waking up the thread {}.",
+            thread_id 
         );
 
         module_mediator::fast_call<module_mediator::return_value>(
@@ -1344,15 +545,12 @@ module_mediator::return_value callback_register_output(module_mediator::argument
         return module_mediator::module_failure;
     }
 
-    output_queue::output_queue.push({
+    submit_output_request({
         .thread_id = thread_id,
         .buffer_address = buffer_address,
         .buffer_size = buffer_size
     });
 
-    lock.unlock();
-    output_queue::signaling.notify_one();
-
     return module_mediator::module_success;
 }
 
@@ -1370,18 +568,15 @@ module_mediator::return_value out(module_mediator::arguments_string_type bundle)
     if (memory_size < output_size) {
         LOG_PROGRAM_ERROR(
             interoperation::get_module_part(),
-            std::format(
-                "Requested output size {} exceeds memory block size of {}.",
-                output_size,
-                memory_size
-            )
+            "Requested output size {} exceeds memory block size of {}.",
+            output_size,
+            memory_size
         );
 
         return module_mediator::execution_result_terminate;
     }
 
-    std::shared_lock lock(io_synchronizer);
-    if (!is_stdio_attached) {
+    if (!check_stdio_attached()) {
         LOG_PROGRAM_ERROR(
             interoperation::get_module_part(),
             "PRTS is not attached to stdio. Cannot write to stdout."
@@ -1390,47 +585,169 @@ module_mediator::return_value out(module_mediator::arguments_string_type bundle)
         return module_mediator::execution_result_terminate;
     }
 
-    module_mediator::callback_bundle* callback_structure =  
-        module_mediator::create_callback<module_mediator::return_value, module_mediator::memory>(
-            "prts",
-            "callback_register_output",
-            interoperation::get_current_thread_id(),
-            memory,
-            output_size
+    module_mediator::return_value thread_id = interoperation::get_current_thread_id();
+    const char* output = static_cast<const char*>(memory);
+
+    std::unique_ptr<std::vector<char>> flushed_buffer{};
+    bool is_new_buffer = false;
+    bool is_direct_output = false;
+    {
+        std::scoped_lock buffers_lock{ output_buffers::lock };
+
+        auto [buffer_iterator, is_inserted] = output_buffers::buffers.try_emplace(thread_id);
+        std::vector<char>& buffer = buffer_iterator->second;
+
+        is_new_buffer = is_inserted;
+        if (buffer.empty() && output_size >= output_buffers::flush_threshold) {
+            // Nothing to keep in order with, large output is written directly from the program memory.
+            is_direct_output = true;
+        }
+        else {
+            buffer.insert(buffer.end(), output, output + output_size);
+
+            bool is_new_line = output_buffers::is_line_buffered.load(std::memory_order_relaxed) && 
+                std::memchr(output, '\n', output_size) != nullptr;
+
+            if (buffer.size() >= output_buffers::flush_threshold || is_new_line) {
+                flushed_buffer = std::make_unique<std::vector<char>>(std::move(buffer));
+                buffer = {};
+            }
+        }
+    }
+
+    if (is_new_buffer) {
+        register_output_buffer_destroy_callback(thread_id);
+    }
+
+    if (flushed_buffer) {
+        return submit_buffered_output(flushed_buffer.release());
+    }
+
+    if (is_direct_output) {
+        module_mediator::callback_bundle* callback_structure =  
+            module_mediator::create_callback<module_mediator::return_value, module_mediator::memory>(
+                "prts",
+                "callback_register_output",
+                thread_id,
+                memory,
+                output_size
+            );
+
+        module_mediator::fast_call<module_mediator::memory>(
+            interoperation::get_module_part(),
+            interoperation::index_getter::execution_module(),
+            interoperation::index_getter::execution_module_register_deferred_callback(),
+            callback_structure
+        );
+
+        return module_mediator::execution_result_block;
+    }
+
+    return module_mediator::execution_result_continue;
+}
+
+module_mediator::return_value flush(module_mediator::arguments_string_type) {
+    if (!check_stdio_attached()) {
+        LOG_PROGRAM_ERROR(
+            interoperation::get_module_part(),
+            "PRTS is not attached to stdio. Cannot flush stdout."
         );
 
-    module_mediator::fast_call<module_mediator::memory>(
-        interoperation::get_module_part(),
-        interoperation::index_getter::execution_module(),
-        interoperation::index_getter::execution_module_register_deferred_callback(),
-        callback_structure
-    );
+        return module_mediator::execution_result_terminate;
+    }
+
+    std::vector<char> buffer = take_output_buffer(interoperation::get_current_thread_id());
+    if (buffer.empty()) {
+        return module_mediator::execution_result_continue;
+    }
 
-    return module_mediator::execution_result_block;
+    return submit_buffered_output(new std::vector<char>{ std::move(buffer) });
+}
+
+module_mediator::return_value callback_register_buffered_output(module_mediator::arguments_string_type bundle) {
+    auto [thread_id, buffer_pointer] =
+        module_mediator::respond_callback<module_mediator::return_value, module_mediator::memory>::unpack(bundle);
+
+    std::unique_ptr<std::vector<char>> buffer{ static_cast<std::vector<char>*>(buffer_pointer) };
+
+    io_submission submission{};
+    if (!submission.is_accepted) {
+        LOG_WARNING(
+            interoperation::get_module_part(),
+            "Concurrency error: PRTS was detached from stdio before the thread was added to the output queue." \
+            "Waking up the thread {}.",
+            thread_id 
+        );
+
+        module_mediator::fast_call<module_mediator::return_value>(
+            interoperation::get_module_part(),
+            interoperation::index_getter::execution_module(),
+            interoperation::index_getter::execution_module_make_runnable(),
+            thread_id
+        );
+
+        return module_mediator::module_failure;
+    }
+
+    thread_output_descriptor descriptor{
+        .thread_id = thread_id,
+        .buffer_address = nullptr,
+        .buffer_size = buffer->size(),
+        .owned_buffer = std::move(*buffer)
+    };
+
+    descriptor.buffer_address = descriptor.owned_buffer.data();
+    submit_output_request(std::move(descriptor));
+
+    return module_mediator::module_success;
+}
+
+module_mediator::return_value flush_thread_output_on_destroy(module_mediator::arguments_string_type bundle) {
+    auto [thread_id] =
+        module_mediator::respond_callback<module_mediator::return_value>::unpack(bundle);
+
+    std::vector<char> buffer{};
+    {
+        std::scoped_lock buffers_lock{ output_buffers::lock };
+
+        auto buffer_iterator = output_buffers::buffers.find(thread_id);
+        if (buffer_iterator == output_buffers::buffers.end()) {
+            return module_mediator::module_success;
+        }
+
+        buffer = std::move(buffer_iterator->second);
+        output_buffers::buffers.erase(buffer_iterator);
+    }
+
+    if (buffer.empty()) {
+        return module_mediator::module_success;
+    }
+
+    return submit_detached_output(thread_id, std::move(buffer)) ? 
+        module_mediator::module_success : module_mediator::module_failure;
 }
 
 module_mediator::return_value callback_register_input(module_mediator::arguments_string_type bundle) {
-    auto [thread_id, return_address, input_buffer, buffer_size] = 
+    auto [thread_id, return_address, input_buffer, buffer_size, fill_buffer] = 
         module_mediator::respond_callback<
             module_mediator::return_value,
             module_mediator::memory,
             module_mediator::memory,
-            module_mediator::eight_bytes
+            module_mediator::eight_bytes,
+            module_mediator::one_byte
         >::unpack(bundle);
 
-    std::unique_lock lock(input_queue::lock);
-    if (!check_stdio_attached()) { // This should not ever lead to a deadlock because we are using a shared lock.
+    io_submission submission{};
+    if (!submission.is_accepted) {
         LOG_WARNING(
             interoperation::get_module_part(),
-            std::format(
-                "Concurrency error: PRTS was detached from stdio before the thread was added to the input queue." \
-                "Waking up the thread {}.",
-                thread_id
-            )
+            "Concurrency error: PRTS was detached from stdio before the thread was added to the input queue." \
+            "Waking up the thread {}.",
+            thread_id
         );
 
         module_mediator::eight_bytes input_size{ 0 };
-        std::memcpy(input_buffer, &input_size, sizeof(module_mediator::eight_bytes));
+        std::memcpy(return_address, &input_size, sizeof(module_mediator::eight_bytes));
 
         module_mediator::fast_call<module_mediator::return_value>(
             interoperation::get_module_part(),
@@ -1442,88 +759,108 @@ module_mediator::return_value callback_register_input(module_mediator::arguments
         return module_mediator::module_failure;
     }
 
-    input_queue::input_queue.push({
+    input_queue.push({
         .thread_id = thread_id,
         .return_address = return_address,
         .input_buffer = input_buffer,
-        .buffer_size = buffer_size
+        .buffer_size = buffer_size,
+        .fill_buffer = fill_buffer != 0
     });
 
-    lock.unlock();
-    input_queue::signaling.notify_one();
+    input_queue.signal();
 
     return module_mediator::module_success;
 }
 
-module_mediator::return_value in(module_mediator::arguments_string_type bundle) {
-    auto [return_address, type, input_buffer, buffer_size] = 
-        module_mediator::arguments_string_builder::unpack<
-            module_mediator::memory,
-            module_mediator::one_byte,
-            module_mediator::memory,
-            module_mediator::eight_bytes
-        >(bundle);
+namespace {
+    // Common part of io.std.in and io.std.in-full.
+    module_mediator::return_value submit_input_request(module_mediator::arguments_string_type bundle, bool fill_buffer) {
+        auto [return_address, type, input_buffer, buffer_size] = 
+            module_mediator::arguments_string_builder::unpack<
+                module_mediator::memory,
+                module_mediator::one_byte,
+                module_mediator::memory,
+                module_mediator::eight_bytes
+            >(bundle);
+
+        if (type != module_mediator::eight_bytes_return_value) {
+            LOG_PROGRAM_ERROR(
+                interoperation::get_module_part(),
+                "Invalid type for stdio input operation. Expected eight bytes return value."
+            );
 
-    if (buffer_size == 0) {
-        return module_mediator::execution_result_continue;
-    }
+            return module_mediator::execution_result_terminate;
+        }
 
-    auto [memory, memory_size] = 
-        backend::decay_pointer(input_buffer);
+        if (buffer_size == 0) {
+            module_mediator::eight_bytes input_size{ 0 };
+            std::memcpy(return_address, &input_size, sizeof(module_mediator::eight_bytes));
 
-    if (memory_size < buffer_size) {
-       LOG_PROGRAM_ERROR(
-            interoperation::get_module_part(),
-            std::format(
+            return module_mediator::execution_result_continue;
+        }
+
+        auto [memory, memory_size] = 
+            backend::decay_pointer(input_buffer);
+
+        if (memory_size < buffer_size) {
+           LOG_PROGRAM_ERROR(
+                interoperation::get_module_part(),
                 "Requested input size {} exceeds memory block size of {}.",
                 buffer_size,
                 memory_size
-            )
-        );
+            );
 
-       return module_mediator::execution_result_terminate;
-    }
+           return module_mediator::execution_result_terminate;
+        }
 
-    if (type != module_mediator::eight_bytes_return_value) {
-        LOG_PROGRAM_ERROR(
-            interoperation::get_module_part(),
-            "Invalid type for stdio input operation. Expected eight bytes return value."
-        );
+        if (!check_stdio_attached()) {
+            LOG_PROGRAM_ERROR(
+                interoperation::get_module_part(),
+                "PRTS is not attached to stdio. Cannot read from stdin."
+            );
 
-        return module_mediator::execution_result_terminate;
-    }
+            return module_mediator::execution_result_terminate;
+        }
+
+        // A prompt without a new line would otherwise stay in the buffer while the thread waits for the answer.
+        // It is queued before the input request, the thread does not wait for it to be written.
+        module_mediator::return_value thread_id = interoperation::get_current_thread_id();
+        if (std::vector<char> buffer = take_output_buffer(thread_id); !buffer.empty()) {
+            submit_detached_output(thread_id, std::move(buffer));
+        }
+
+        module_mediator::callback_bundle* callback_structure = 
+            module_mediator::create_callback<
+                module_mediator::return_value,
+                module_mediator::memory,
+                module_mediator::memory,
+                module_mediator::eight_bytes,
+                module_mediator::one_byte
+            >(
+                "prts",
+                "callback_register_input",
+                thread_id,
+                return_address,
+                memory,
+                buffer_size,
+                static_cast<module_mediator::one_byte>(fill_buffer)
+            );
 
-    std::shared_lock lock(io_synchronizer);
-    if (!is_stdio_attached) {
-        LOG_PROGRAM_ERROR(
+        module_mediator::fast_call<module_mediator::memory>(
             interoperation::get_module_part(),
-            "PRTS is not attached to stdio. Cannot read from stdin."
+            interoperation::index_getter::execution_module(),
+            interoperation::index_getter::execution_module_register_deferred_callback(),
+            callback_structure
         );
 
-        return module_mediator::execution_result_terminate;
+        return module_mediator::execution_result_block;
     }
+}
 
-    module_mediator::callback_bundle* callback_structure = 
-        module_mediator::create_callback<
-            module_mediator::return_value,
-            module_mediator::memory,
-            module_mediator::memory,
-            module_mediator::eight_bytes
-        >(
-            "prts",
-            "callback_register_input",
-            interoperation::get_current_thread_id(),
-            return_address,
-            memory,
-            buffer_size
-        );
-
-    module_mediator::fast_call<module_mediator::memory>(
-        interoperation::get_module_part(),
-        interoperation::index_getter::execution_module(),
-        interoperation::index_getter::execution_module_register_deferred_callback(),
-        callback_structure
-    );
+module_mediator::return_value in(module_mediator::arguments_string_type bundle) {
+    return submit_input_request(bundle, false);
+}
 
-    return module_mediator::execution_result_block;
+module_mediator::return_value in_full(module_mediator::arguments_string_type bundle) {
+    return submit_input_request(bundle, true);
 }
@@ -8,8 +8,12 @@ PROGRAMRUNTIMESERVICES_API module_mediator::return_value detach_from_stdio(modul
 
 PROGRAMRUNTIMESERVICES_API module_mediator::return_value callback_register_output(module_mediator::arguments_string_type bundle);
 PROGRAMRUNTIMESERVICES_API module_mediator::return_value callback_register_input(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value callback_register_buffered_output(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value flush_thread_output_on_destroy(module_mediator::arguments_string_type bundle);
 
 PROGRAMRUNTIMESERVICES_API module_mediator::return_value out(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value flush(module_mediator::arguments_string_type bundle);
 PROGRAMRUNTIMESERVICES_API module_mediator::return_value in(module_mediator::arguments_string_type bundle);
+PROGRAMRUNTIMESERVICES_API module_mediator::return_value in_full(module_mediator::arguments_string_type bundle);
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef PROGRAM_RUNTIME_SERVICES_STDIO_BACKEND_H
+#define PROGRAM_RUNTIME_SERVICES_STDIO_BACKEND_H
+
+#include "pch.h"
+
+// The part of PRTS standard IO that talks to the operating system.
+// Request queues, completion, and output buffering live in standard_input_output.cpp and are shared by all backends.
+// Exactly one backend is compiled in: stdio_backend_windows.cpp (console and overlapped IO) or stdio_backend_linux.cpp (epoll).
+// read_input is called only by the input worker, write_output only by the output worker.
+namespace stdio_backend {
+    // Takes stdin and stdout for PRTS. Returns false if they cannot be used.
+    bool capture();
+
+    // Returns true if capture() succeeded and release() was not called yet.
+    bool is_captured();
+
+    // Interactive output (e.g. a console) is flushed on every new line.
+    bool is_output_interactive();
+
+    // Called at the start of each worker thread.
+    void prepare_worker_thread(const char* worker_name);
+
+    // Blocks until some input is available and reads at most buffer_size bytes of it directly into the buffer.
+    // Returns the amount of bytes read, and true if no more input can be read (shutdown or error).
+    // Zero bytes without shutdown means EOF.
+    std::pair<std::uint64_t, bool> read_input(void* buffer, std::uint64_t buffer_size);
+
+    // Blocks until the whole buffer is written. Returns true if no more output can be written (shutdown or error).
+    bool write_output(const void* buffer, std::uint64_t buffer_size);
+
+    // Makes sure that workers are not stuck in blocking IO. Returns an exclusive lock that keeps them out of it,
+    // or a lock that owns nothing if the workers could not be interrupted.
+    std::unique_lock<std::shared_mutex> interrupt_workers(std::thread& input_worker, std::thread& output_worker);
+
+    // Wakes up workers that wait for IO and makes all further IO return shutdown. Must be called after interrupt_workers.
+    bool signal_shutdown();
+
+    // Gives stdin and stdout back. Workers must be joined at this point.
+    bool release();
+}
+
+#endif // !PROGRAM_RUNTIME_SERVICES_STDIO_BACKEND_H
@@ -0,0 +1,390 @@
+#include "pch.h"
+#include "stdio_backend.h"
+#include "module_interoperation.h"
+
+#include "../logger_module/logging.h"
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Linux backend for PRTS standard IO. Descriptors stay blocking (their flags are shared with every process that inherited them),
+// instead workers wait with epoll until a descriptor is ready, together with an eventfd that is raised on detach,
+// and only then read or write an amount that doesn't block. Regular files can't be waited on (epoll rejects them),
+// but reads and writes on them never block for long, so they are used as is.
+namespace {
+    // Readers: workers, while they are inside of a read or write call (but not while they wait in epoll).
+    // Writers: detach (see interrupt_workers).
+    std::shared_mutex io_synchronizer;
+
+    constexpr int not_captured = -1;
+
+    struct captured_descriptor {
+        int descriptor{ not_captured };
+        bool is_pollable{ false };
+        bool is_socket{ false };
+
+        // Each worker has its own epoll instance, which watches its descriptor and the shutdown event.
+        int epoll_descriptor{ not_captured };
+    };
+
+    captured_descriptor captured_input{};
+    captured_descriptor captured_output{};
+
+    // Raised once on detach, never reset. Wakes up both workers.
+    int shutdown_event = not_captured;
+
+    // Linux transfers at most 0x7ffff000 bytes per call anyway.
+    constexpr std::uint64_t max_read_size = 1ull << 30;
+
+    // A writable pipe has room for at least PIPE_BUF bytes. Terminals have a similar amount of room,
+    // though a stopped terminal (Ctrl+S) blocks writes until it is resumed.
+    constexpr std::uint64_t max_ready_write_size = PIPE_BUF;
+
+    void close_report(int& descriptor, const char* descriptor_name) {
+        if (descriptor != not_captured) {
+            if (close(descriptor) != 0) {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Failed to close {} with error code {}.",
+                    descriptor_name,
+                    errno
+                );
+            }
+
+            descriptor = not_captured;
+        }
+    }
+
+    bool capture_descriptor(int descriptor, std::uint32_t events, captured_descriptor& captured, const char* descriptor_name) {
+        struct stat descriptor_status{};
+        if (fstat(descriptor, &descriptor_status) != 0) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to get {} status with error code {}.",
+                descriptor_name,
+                errno
+            );
+
+            return false;
+        }
+
+        captured.descriptor = descriptor;
+        captured.is_pollable = !S_ISREG(descriptor_status.st_mode) && !S_ISDIR(descriptor_status.st_mode);
+        captured.is_socket = S_ISSOCK(descriptor_status.st_mode);
+
+        captured.epoll_descriptor = epoll_create1(EPOLL_CLOEXEC);
+        if (captured.epoll_descriptor == -1) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to create epoll instance for {} with error code {}.",
+                descriptor_name,
+                errno
+            );
+
+            captured.epoll_descriptor = not_captured;
+            return false;
+        }
+
+        epoll_event shutdown_watch{ .events = EPOLLIN, .data = { .fd = shutdown_event } };
+        if (epoll_ctl(captured.epoll_descriptor, EPOLL_CTL_ADD, shutdown_event, &shutdown_watch) != 0) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to watch shutdown event for {} with error code {}.",
+                descriptor_name,
+                errno
+            );
+
+            return false;
+        }
+
+        if (!captured.is_pollable) {
+            return true;
+        }
+
+        epoll_event descriptor_watch{ .events = events, .data = { .fd = descriptor } };
+        if (epoll_ctl(captured.epoll_descriptor, EPOLL_CTL_ADD, descriptor, &descriptor_watch) != 0) {
+            // Character devices without poll support (e.g. /dev/null) never block, just like regular files.
+            if (errno == EPERM) {
+                captured.is_pollable = false;
+                return true;
+            }
+
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to watch {} with error code {}.",
+                descriptor_name,
+                errno
+            );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void release_descriptor(captured_descriptor& captured) {
+        close_report(captured.epoll_descriptor, "epoll instance");
+        captured = captured_descriptor{};
+    }
+
+    enum class descriptor_state {
+        ready,
+        busy,
+        shutdown
+    };
+
+    // Timeout is in milliseconds, -1 waits until the descriptor is ready or shutdown is requested.
+    // Descriptors that can't be waited on are always ready.
+    descriptor_state check_descriptor(const captured_descriptor& captured, int timeout) {
+        while (true) {
+            epoll_event ready_events[2]{};
+            int ready_count = epoll_wait(captured.epoll_descriptor, ready_events, std::size(ready_events), timeout);
+            if (ready_count == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Failed to wait for stdio with error code {}.",
+                    errno
+                );
+
+                return descriptor_state::shutdown;
+            }
+
+            for (int event_index = 0; event_index < ready_count; ++event_index) {
+                if (ready_events[event_index].data.fd == shutdown_event) {
+                    return descriptor_state::shutdown; // We received shutdown signal while waiting.
+                }
+            }
+
+            // Errors and hang ups are reported by the following read or write.
+            return ready_count > 0 || !captured.is_pollable ? descriptor_state::ready : descriptor_state::busy;
+        }
+    }
+
+    // Writing to a pipe whose reading end is closed raises SIGPIPE for the writing thread. Workers keep it blocked
+    // (see prepare_worker_thread), so the write fails with EPIPE and the signal stays pending. Discard it,
+    // the disposition of SIGPIPE belongs to the host process.
+    void discard_pending_sigpipe() {
+        sigset_t sigpipe_set{};
+        sigemptyset(&sigpipe_set);
+        sigaddset(&sigpipe_set, SIGPIPE);
+
+        timespec no_wait{};
+        while (sigtimedwait(&sigpipe_set, nullptr, &no_wait) == -1 && errno == EINTR) {}
+    }
+}
+
+namespace stdio_backend {
+    bool capture() {
+        shutdown_event = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (shutdown_event == -1) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to create I/O cancellation event with error code {}.",
+                errno
+            );
+
+            shutdown_event = not_captured;
+            return false;
+        }
+
+        if (!capture_descriptor(STDIN_FILENO, EPOLLIN, captured_input, "STDIN") ||
+            !capture_descriptor(STDOUT_FILENO, EPOLLOUT, captured_output, "STDOUT")) {
+            release();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool is_captured() {
+        if (captured_input.descriptor == not_captured || captured_output.descriptor == not_captured || shutdown_event == not_captured) {
+            assert(captured_input.descriptor == not_captured && captured_output.descriptor == not_captured && shutdown_event == not_captured);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool is_output_interactive() {
+        return isatty(captured_output.descriptor) == 1;
+    }
+
+    void prepare_worker_thread(const char* worker_name) {
+        // A closed pipe on the other side must be reported by write, not kill the whole process.
+        sigset_t sigpipe_set{};
+        sigemptyset(&sigpipe_set);
+        sigaddset(&sigpipe_set, SIGPIPE);
+
+        int mask_error = pthread_sigmask(SIG_BLOCK, &sigpipe_set, nullptr);
+        if (mask_error != 0) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to block SIGPIPE for {} worker with error code {}.",
+                worker_name,
+                mask_error
+            );
+        }
+
+        LOG_INFO(
+            interoperation::get_module_part(),
+            "PRTS is attached to stdio. Starting {} worker. System thread is: {}.",
+            worker_name,
+            gettid()
+        );
+    }
+
+    std::pair<std::uint64_t, bool> read_input(void* buffer, std::uint64_t buffer_size) {
+        while (true) {
+            descriptor_state state = descriptor_state::busy;
+            ssize_t bytes_read = 0;
+            {
+                std::shared_lock io_lock{ io_synchronizer };
+                state = check_descriptor(captured_input, 0);
+                if (state == descriptor_state::ready) {
+                    // Pipes, sockets and terminals return whatever is available instead of waiting for the whole buffer.
+                    bytes_read = read(captured_input.descriptor, buffer, std::min(buffer_size, max_read_size));
+                }
+            }
+
+            if (state == descriptor_state::shutdown) {
+                return { 0, true };
+            }
+
+            if (state == descriptor_state::busy) {
+                if (check_descriptor(captured_input, -1) == descriptor_state::shutdown) {
+                    return { 0, true };
+                }
+
+                continue;
+            }
+
+            if (bytes_read >= 0) {
+                return { static_cast<std::uint64_t>(bytes_read), false }; // Zero is EOF.
+            }
+
+            // EAGAIN is possible if somebody else made the descriptor non-blocking.
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
+
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to read from STDIN with error code {}.",
+                errno
+            );
+
+            return { 0, true };
+        }
+    }
+
+    bool write_output(const void* buffer, std::uint64_t buffer_size) {
+        const char* output = static_cast<const char*>(buffer);
+        while (buffer_size > 0) {
+            descriptor_state state = descriptor_state::busy;
+            ssize_t bytes_written = 0;
+            {
+                std::shared_lock io_lock{ io_synchronizer };
+                state = check_descriptor(captured_output, 0);
+                if (state == descriptor_state::ready) {
+                    if (captured_output.is_socket) {
+                        bytes_written = send(captured_output.descriptor, output, buffer_size, MSG_DONTWAIT | MSG_NOSIGNAL);
+                    }
+                    else if (captured_output.is_pollable) {
+                        bytes_written = write(captured_output.descriptor, output, std::min(buffer_size, max_ready_write_size));
+                    }
+                    else {
+                        bytes_written = write(captured_output.descriptor, output, buffer_size);
+                    }
+                }
+            }
+
+            if (state == descriptor_state::shutdown) {
+                return true;
+            }
+
+            if (state == descriptor_state::busy) {
+                if (check_descriptor(captured_output, -1) == descriptor_state::shutdown) {
+                    return true;
+                }
+
+                continue;
+            }
+
+            if (bytes_written >= 0) {
+                output += bytes_written;
+                buffer_size -= static_cast<std::uint64_t>(bytes_written);
+
+                continue;
+            }
+
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
+
+            if (errno == EPIPE) {
+                discard_pending_sigpipe();
+            }
+
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to write to STDOUT with error code {}.",
+                errno
+            );
+
+            return true;
+        }
+
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> interrupt_workers(std::thread&, std::thread&) {
+        // Workers enter read or write only after epoll reported that the descriptor is ready, and transfer no more than
+        // is available, and signal_shutdown wakes them up from epoll_wait, so the lock is acquired quickly.
+        return std::unique_lock{ io_synchronizer };
+    }
+
+    bool signal_shutdown() {
+        if (shutdown_event == not_captured) {
+            return true;
+        }
+
+        std::uint64_t signal_value = 1;
+        if (write(shutdown_event, &signal_value, sizeof(signal_value)) != sizeof(signal_value)) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to set event for I/O cancellation with error code {}. " \
+                "This will lead to resource leaks. Detaching worker threads as a last-ditch effort.",
+                errno
+            );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool release() {
+        release_descriptor(captured_input);
+        release_descriptor(captured_output);
+        close_report(shutdown_event, "I/O cancellation event");
+
+        return true;
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,975 @@
+#include "pch.h"
+#include "stdio_backend.h"
+#include "module_interoperation.h"
+
+#include "../logger_module/logging.h"
+
+#ifdef _WIN32
+
+// Windows backend for PRTS standard IO. Console IO is used for consoles, overlapped IO is used for files and pipes,
+// with a fallback to synchronous IO if overlapped IO fails.
+namespace {
+    // Readers: synchronous input or output operations for stdin/stdout.
+    // Writers: detach (see interrupt_workers).
+    // Synchronous IO can't be interrupted by the cancellation event, so detach must be sure that nobody is inside of it.
+    std::shared_mutex io_synchronizer;
+}
+
+// WinAPI thingies for console input/output management.
+namespace {
+    // Available only if captured.
+    HANDLE hCapturedStdOut;
+    HANDLE hCapturedStdIn;
+
+    // The handle to the worker thread that is responsible for reading from stdin.
+    // Allows to exit the thread gracefully when PRTS is detached from stdin.
+    HANDLE hIOCancellationSignal;
+
+    // The state of the console before PRTS attached to it.
+    DWORD dwSavedConsoleState;
+
+    bool InitializeConsoleInput(HANDLE hStdin, DWORD& dwOutOriginalMode) {
+        if (!GetConsoleMode(hStdin, &dwOutOriginalMode)) {
+            return false;
+        }
+
+        // Keep only line input, echo, processed input; disable mouse/window events.
+        // Enable ASCII control characters processing with wrapping at EOL.
+        DWORD mode = ENABLE_LINE_INPUT
+                   | ENABLE_ECHO_INPUT
+                   | ENABLE_PROCESSED_INPUT
+                   | ENABLE_PROCESSED_OUTPUT
+                   | ENABLE_WRAP_AT_EOL_OUTPUT;  // NOLINT(misc-redundant-expression)
+        if (!SetConsoleMode(hStdin, mode)) {
+            return false;
+        }
+
+        // Discard any pending input events (mouse, focus, etc.)
+        return FlushConsoleInputBuffer(hStdin) != FALSE;
+    } 
+
+    BOOL RestoreConsoleInput(HANDLE hStdin, DWORD dwOriginalMode) {
+        return SetConsoleMode(hStdin, dwOriginalMode);
+    }
+
+    void CloseHandleReport(HANDLE& handle, const char* lpsHandleName) {
+        if (handle != nullptr && handle != INVALID_HANDLE_VALUE) {
+            if (!CloseHandle(handle)) {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Failed to close {} handle with error code {}.",
+                    lpsHandleName,
+                    GetLastError()
+                );
+            }
+            else {
+                handle = nullptr;
+            }
+        }
+    }
+
+    std::pair<std::vector<char>, bool> ConsumeConsoleInput(HANDLE hStdIn, HANDLE hCancelIO) {
+        HANDLE haWaitingHandles[]{ hStdIn, hCancelIO };
+        std::vector<char> result{};
+
+        // Ensure that PRTS knows that we are waiting on console input, so that it can try and cancel it if needed.
+        std::shared_lock synchronous_io_lock{ io_synchronizer };
+        while (std::ranges::find(result, '\n') == result.end()) {
+            DWORD dwConsoleWaitResult = WaitForMultipleObjects(std::size(haWaitingHandles), haWaitingHandles, FALSE, INFINITE);
+            if (dwConsoleWaitResult == WAIT_OBJECT_0 + 1) {
+                return { {}, true }; // We received shutdown signal while waiting.
+            }
+
+            if (dwConsoleWaitResult == WAIT_OBJECT_0) {
+                DWORD dwAvailableInput = 0;
+                BOOL bEventsResult = GetNumberOfConsoleInputEvents(hStdIn, &dwAvailableInput);
+                if (!bEventsResult) {
+                    LOG_WARNING(
+                        interoperation::get_module_part(),
+                        "GetNumberOfConsoleInputEvents failed with error code {}. " \
+                        "Cannot read from console input.",
+                        GetLastError()
+                    );
+
+                    return { {}, true };
+                }
+
+                constexpr DWORD dwBufferSize = 128;
+
+                INPUT_RECORD buffer[dwBufferSize];
+                DWORD dwReadEvents = 0;
+
+                DWORD dwAcquiredInput = std::min(dwAvailableInput, dwBufferSize);
+                BOOL bEventPeekedResult = PeekConsoleInputA(
+                    hStdIn,
+                    buffer,
+                    dwAcquiredInput,
+                    &dwReadEvents
+                );
+
+                if (!bEventPeekedResult) {
+                    LOG_WARNING(
+                        interoperation::get_module_part(),
+                        "ReadConsoleInput failed with error code {}. " \
+                        "Cannot read from console input.",
+                        GetLastError()
+                    );
+
+                    return { {}, true };
+                }
+
+#ifdef __clang__
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wtautological-constant-out-of-range-compare"
+
+#endif
+
+                WORD dwTotalTextSize = 0;
+                for (DWORD dwInputBufferIndex = 0; dwInputBufferIndex < dwReadEvents; ++dwInputBufferIndex) {
+                    if (buffer[dwInputBufferIndex].EventType == KEY_EVENT) {
+                        const KEY_EVENT_RECORD& keyEvent = buffer[dwInputBufferIndex].Event.KeyEvent;
+                        if (keyEvent.bKeyDown) {
+                            if (keyEvent.uChar.AsciiChar >= 0 && keyEvent.uChar.AsciiChar < 128) {  // NOLINT(clang-diagnostic-tautological-constant-out-of-range-compare)
+                                dwTotalTextSize += keyEvent.wRepeatCount;
+                            }
+                        }
+                        else if (keyEvent.wVirtualKeyCode == VK_RETURN) {
+                            dwTotalTextSize += 1;
+                        }
+                    }
+                }
+
+#ifdef __clang__
+
+#pragma clang diagnostic pop
+
+#endif
+
+                if (dwTotalTextSize > 0) {
+                    DWORD dwTextRead = 0;
+                    std::unique_ptr<CHAR[]> lpTextBuffer{ new CHAR[dwTotalTextSize] };
+
+                    BOOL bConsoleReadResult = ReadConsoleA(
+                        hStdIn,
+                        lpTextBuffer.get(),
+                        dwTotalTextSize,
+                        &dwTextRead,
+                        nullptr 
+                    );
+
+                    if (!bConsoleReadResult) {
+                        LOG_WARNING(
+                            interoperation::get_module_part(),
+                            "ReadConsole failed with error code {}. " \
+                            "Cannot read from console input.",
+                            GetLastError()
+                        );
+
+                        return { {}, true };
+                    }
+
+                    for (DWORD dwTextIndex = 0; dwTextIndex < dwTextRead; ++dwTextIndex) {
+                        if (lpTextBuffer[dwTextIndex] == '\x1a') {
+                            // Ctrl+Z is pressed, EOF.
+                            return { result, true };
+                        }
+                        if (lpTextBuffer[dwTextIndex] != '\r') {
+                            result.push_back(lpTextBuffer[dwTextIndex]);
+                        }
+                    }
+                }
+            }
+            else {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Unexpected wait result {}. Received error: {}.",
+                    dwConsoleWaitResult,
+                    GetLastError()
+                );
+
+                return { {}, true };
+            }
+        }
+
+        return { result, false };
+    }
+
+    // This function is unified for both file and pipe input. Data is read directly into the caller's buffer.
+    // With all possible edge cases and fallback to synchronous IO if overlapped IO fails.
+    // Returns the amount of bytes read and whether no more input can be read (shutdown or error).
+    template<auto file_type>
+    std::pair<DWORD, bool> ConsumeAsynchronous(
+        HANDLE hStdIn, 
+        HANDLE hCancelIO, 
+        CHAR* lpBuffer,
+        DWORD dwBufferSize,
+        DWORD& dwOffset, 
+        DWORD& dwOffsetHigh
+    ) {
+        constexpr bool is_pipe = file_type == FILE_TYPE_PIPE;
+        HANDLE haWaitHandles[]{ hStdIn, hCancelIO };
+
+        OVERLAPPED overlapped{};
+        overlapped.hEvent = CreateEvent(
+            nullptr, 
+            TRUE,
+            FALSE,
+            nullptr 
+        );
+        
+        if (overlapped.hEvent == nullptr) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "CreateEvent failed with error code {}. " \
+                "Cannot perform asynchronous read operation for file.",
+                GetLastError()
+            );
+
+            return { 0, true };
+        }
+        
+        if constexpr (is_pipe) {
+            overlapped.Offset = 0;
+            overlapped.OffsetHigh = 0;
+        }
+        else {
+            overlapped.Offset = dwOffset;
+            overlapped.OffsetHigh = dwOffsetHigh;
+        }
+
+        // Message mode pipes report ERROR_MORE_DATA if the message does not fit. 
+        // Whatever was read is returned, and the rest of the message is read by the next call.
+        auto fnIsPartialPipeRead = []() {
+            if constexpr (is_pipe) {
+                return GetLastError() == ERROR_MORE_DATA;
+            }
+            else {
+                return false;
+            }
+        };
+
+        auto fnIsPipeClosed = []() {
+            if constexpr (is_pipe) {
+                if (GetLastError() == ERROR_BROKEN_PIPE) {
+                    LOG_WARNING(
+                        interoperation::get_module_part(),
+                        "Pipe closed before detaching PRTS from stdio."
+                    );
+
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        DWORD dwBytesRead = 0;
+        BOOL bReadResult = ReadFile(
+            hStdIn,
+            lpBuffer,
+            dwBufferSize,
+            &dwBytesRead,
+            &overlapped
+        );
+        
+        if (!bReadResult) { // This is just how ridiculously complicated overlapped I/O is in Windows.
+            if (GetLastError() == ERROR_IO_PENDING) {
+                DWORD waitResult = WaitForMultipleObjects(
+                    std::size(haWaitHandles),
+                    haWaitHandles,
+                    FALSE,
+                    INFINITE
+                );
+
+                if (waitResult == WAIT_OBJECT_0) {
+                    if (!GetOverlappedResult(hStdIn, &overlapped, &dwBytesRead, FALSE)) {
+                        if (GetLastError() == ERROR_HANDLE_EOF || fnIsPartialPipeRead()) {
+                            CloseHandleReport(overlapped.hEvent, "overlapped.hEvent");
+                            return { dwBytesRead, false };
+                        }
+
+                        if (fnIsPipeClosed()) {
+                            CloseHandleReport(overlapped.hEvent, "overlapped.hEvent");
+                            return { dwBytesRead, true };
+                        }
+
+                        LOG_WARNING(
+                            interoperation::get_module_part(),
+                            "GetOverlappedResult failed with error code {}. " \
+                            "Cannot read from file.",
+                            GetLastError()
+                        );
+
+                        CloseHandleReport(overlapped.hEvent, "overlapped.hEvent");
+                        return { 0, true };
+                    }
+                }
+                else {
+                    if (waitResult != WAIT_OBJECT_0 + 1) {
+                        LOG_WARNING(
+                            interoperation::get_module_part(),
+                            "WaitForMultipleObjects failed with error code {}. " \
+                            "Cannot read from file.",
+                            GetLastError()
+                        );
+                    }
+
+                    BOOL bIOCancelResult = CancelIo(hStdIn);
+                    if (!bIOCancelResult) {
+                        LOG_WARNING(
+                            interoperation::get_module_part(),
+                            "CancelIo failed with error code {}. "
+                            "Cannot cancel I/O operation.",
+                            GetLastError()
+                        );
+                    }
+
+                    // The buffer belongs to a program thread, the read must be over before the thread is woken up.
+                    GetOverlappedResult(hStdIn, &overlapped, &dwBytesRead, TRUE);
+
+                    CloseHandleReport(overlapped.hEvent, "overlapped.hEvent");
+                    return { 0, true };
+                }
+            }
+            else if (GetLastError() == ERROR_HANDLE_EOF) {
+                CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                return { 0, false };
+            }
+            else if (fnIsPartialPipeRead()) {
+                CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                return { dwBytesRead, false };
+            }
+            else if (fnIsPipeClosed()) {
+                CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                return { dwBytesRead, true };
+            }
+            else {
+                std::shared_lock synchronous_io_lock{ io_synchronizer };
+                BOOL bSynchronousReadResult = ReadFile(
+                    hStdIn,
+                    lpBuffer,
+                    dwBufferSize,
+                    &dwBytesRead,
+                    nullptr 
+                );
+
+                synchronous_io_lock.unlock();
+                if (WaitForSingleObject(hCancelIO, 0) == WAIT_OBJECT_0 || GetLastError() == ERROR_OPERATION_ABORTED) {
+                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                    return { 0, true };
+                }
+
+                // This also means that EOF was reached. Applies to files only.
+                if (bSynchronousReadResult && dwBytesRead == 0) {
+                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                    return { 0, false };
+                }
+
+                if (!bSynchronousReadResult) {
+                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                    if (fnIsPartialPipeRead()) {
+                        return { dwBytesRead, false };
+                    }
+
+                    if (fnIsPipeClosed()) {
+                        return { dwBytesRead, true };
+                    }
+
+                    LOG_WARNING(
+                        interoperation::get_module_part(),
+                        "ReadFile failed with error code {}. " \
+                        "Cannot read from file both async and sync have failed.",
+                        GetLastError()
+                    );
+
+                    return { 0, true };
+                }
+            }
+        }
+
+        // Files must have their offsets updated after a successful read.
+        if constexpr (!is_pipe) {
+            ULARGE_INTEGER newPosition;
+            newPosition.LowPart = dwOffset;
+            newPosition.HighPart = dwOffsetHigh;
+            newPosition.QuadPart += dwBytesRead;
+
+            dwOffset = newPosition.LowPart;
+            dwOffsetHigh = newPosition.HighPart;
+        }
+        
+        CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+        return { dwBytesRead, false };
+    }
+
+    // Console input is read line by line, the part of a line that did not fit into the caller's buffer is kept here.
+    // Shutdown (e.g. Ctrl+Z) is reported only after the remainder is consumed.
+    std::vector<char> console_line_remainder{};
+    bool is_console_input_closed = false;
+
+    // Dispatches the input reading operation based on the type of the input handle.
+    std::pair<std::uint64_t, bool> ConsumeStdIn(
+        HANDLE hStdIn, 
+        HANDLE hCancelIO, 
+        CHAR* lpBuffer,
+        std::uint64_t buffer_size,
+        DWORD& dwOverlappedOffset, 
+        DWORD& dwOverlappedOffsetHigh
+    ) {
+        // ReadFile accepts DWORD sizes.
+        constexpr std::uint64_t max_read_size = 1ull << 30;
+        DWORD dwBufferSize = static_cast<DWORD>(std::min(buffer_size, max_read_size));
+
+        switch (GetFileType(hStdIn)) {
+            case FILE_TYPE_CHAR: {
+                if (console_line_remainder.empty() && !is_console_input_closed) {
+                    std::tie(console_line_remainder, is_console_input_closed) = ConsumeConsoleInput(hStdIn, hCancelIO);
+                }
+
+                std::uint64_t copied_size = std::min<std::uint64_t>(buffer_size, console_line_remainder.size());
+                std::memcpy(lpBuffer, console_line_remainder.data(), copied_size);
+                console_line_remainder.erase(
+                    console_line_remainder.begin(), 
+                    console_line_remainder.begin() + static_cast<std::ptrdiff_t>(copied_size)
+                );
+
+                return { copied_size, is_console_input_closed && console_line_remainder.empty() };
+            }
+            case FILE_TYPE_DISK: {
+                return ConsumeAsynchronous<FILE_TYPE_DISK>(
+                    hStdIn,
+                    hCancelIO,
+                    lpBuffer,
+                    dwBufferSize,
+                    dwOverlappedOffset,
+                    dwOverlappedOffsetHigh
+                );
+            }
+            case FILE_TYPE_PIPE: {
+               return ConsumeAsynchronous<FILE_TYPE_PIPE>(
+                    hStdIn,
+                    hCancelIO,
+                    lpBuffer,
+                    dwBufferSize,
+                    dwOverlappedOffset,
+                    dwOverlappedOffsetHigh
+                );
+            }
+            default: {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Unknown file type for STDIN: {}. " \
+                    "Cannot read from stdin. Shutting down the worker.",
+                    GetFileType(hCapturedStdIn)
+                );
+
+                return { 0, true };
+            }
+        }
+    }
+
+    bool PushConsoleOutput(
+        HANDLE hStdOut, 
+        const void* output_buffer,
+        module_mediator::eight_bytes buffer_size
+    ) {
+        if (buffer_size == 0) {
+            return false;
+        }
+        if (buffer_size > std::numeric_limits<DWORD>::max()) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Buffer size {} exceeds maximum allowed size of {}.",
+                buffer_size,
+                std::numeric_limits<DWORD>::max()
+            );
+
+            return true;
+        }
+
+        DWORD dwBytesWritten = 0;
+        std::shared_lock synchronous_io_lock{ io_synchronizer };
+
+        BOOL writeResult = WriteConsoleA(
+            hStdOut,
+            output_buffer,
+            static_cast<DWORD>(buffer_size),
+            &dwBytesWritten,
+            nullptr 
+        );
+
+        synchronous_io_lock.unlock();
+        if (GetLastError() == ERROR_OPERATION_ABORTED) {
+            return true;
+        }
+
+        if (!writeResult || dwBytesWritten == 0) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "WriteConsole failed with error code {}. " \
+                "Cannot write to console.",
+                GetLastError()
+            );
+
+            return true;
+        }
+
+        return false;
+    }
+
+    // Similarly to ConsumeAsynchronous, this function handles both files and pipes.
+    // It uses overlapped IO for files and pipes, and falls back to synchronous IO if necessary.
+    template<auto file_type>
+    bool PushAsynchronous(
+        HANDLE hStdOut, 
+        HANDLE hCancelIO, 
+        const void* output_buffer,
+        module_mediator::eight_bytes buffer_size,
+        DWORD& dwOffset, 
+        DWORD& dwOffsetHigh
+    ) {
+        constexpr bool is_pipe = file_type == FILE_TYPE_PIPE;
+        HANDLE waitHandles[]{ hStdOut, hCancelIO };
+
+        if (buffer_size == 0) {
+            return false;
+        }
+        if (buffer_size > std::numeric_limits<DWORD>::max()) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Buffer size {} exceeds maximum allowed size of {}.",
+                buffer_size,
+                std::numeric_limits<DWORD>::max()
+            );
+
+            return true;
+        }
+
+        OVERLAPPED overlapped{};
+        overlapped.hEvent = CreateEvent(
+            nullptr,
+            TRUE,
+            FALSE,
+            nullptr 
+        );
+
+        if (overlapped.hEvent == nullptr) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "CreateEvent failed with error code {}. " \
+                "Cannot perform asynchronous write operation.",
+                GetLastError()
+            );
+
+            return true;
+        }
+
+        if constexpr (is_pipe) {
+            overlapped.Offset = 0;
+            overlapped.OffsetHigh = 0;
+        }
+        else {
+            overlapped.Offset = dwOffset;
+            overlapped.OffsetHigh = dwOffsetHigh;
+        }
+
+        DWORD dwBytesWritten = 0;
+        BOOL bWriteResult = WriteFile(
+            hStdOut,
+            output_buffer,
+            static_cast<DWORD>(buffer_size),
+            &dwBytesWritten,
+            &overlapped
+        );
+
+        if (!bWriteResult) {
+            if (GetLastError() == ERROR_IO_PENDING) {
+                DWORD dwWaitResult = WaitForMultipleObjects(
+                    std::size(waitHandles),
+                    waitHandles,
+                    FALSE,
+                    INFINITE
+                );
+
+                if (dwWaitResult == WAIT_OBJECT_0) {
+                    if (!GetOverlappedResult(hStdOut, &overlapped, &dwBytesWritten, FALSE)) {
+                        LOG_WARNING(
+                            interoperation::get_module_part(),
+                            "GetOverlappedResult failed with error code {}. " \
+                            "Cannot write to file. Is pipe: {}.",
+                            GetLastError(),
+                            is_pipe
+                        );
+
+                        CloseHandle(overlapped.hEvent);
+                        return true;
+                    }
+                }
+                else if (dwWaitResult == WAIT_OBJECT_0 + 1) {
+                    BOOL bIOCancelResult = CancelIo(hStdOut);
+                    if (!bIOCancelResult) {
+                        LOG_WARNING(
+                            interoperation::get_module_part(),
+                            "CancelIo failed with error code {}. " \
+                            "Cannot cancel I/O operation. Is pipe: {}.",
+                            GetLastError(),
+                            is_pipe
+                        );
+                    }
+
+                    CloseHandle(overlapped.hEvent);
+                    return true;
+                }
+                else {
+                    LOG_WARNING(
+                        interoperation::get_module_part(),
+                        "WaitForSingleObject failed with error code {}. " \
+                        "Cannot write to file/pipe. Is pipe: {}.",
+                        GetLastError(),
+                        is_pipe
+                    );
+
+                    return true;
+                }
+            }
+            else {
+                if constexpr (is_pipe) {
+                    if (GetLastError() == ERROR_BROKEN_PIPE) {
+                        LOG_WARNING(
+                            interoperation::get_module_part(),
+                            "Pipe closed before detaching PRTS from stdio."
+                        );
+
+                        CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                        return true;
+                    }
+                }
+
+                std::shared_lock synchronous_io_lock{ io_synchronizer };
+                BOOL bSynchronousWriteResult = WriteFile(
+                    hStdOut,
+                    output_buffer,
+                    static_cast<DWORD>(buffer_size),
+                    &dwBytesWritten,
+                    nullptr 
+                );
+
+                synchronous_io_lock.unlock();
+                if (WaitForSingleObject(hCancelIO, 0) == WAIT_OBJECT_0 || GetLastError() == ERROR_OPERATION_ABORTED) {
+                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                    return true;
+                }
+
+                if (!bSynchronousWriteResult) {
+                    CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                    LOG_WARNING(
+                        interoperation::get_module_part(),
+                        "WriteFile failed with error code {}. " \
+                        "Cannot write to file both async and sync have failed. Is pipe: {}.",
+                        GetLastError(),
+                        is_pipe
+                    );
+
+                    return true;
+                }
+            }
+        }
+
+        if constexpr (!is_pipe) {
+            BOOL bResult = FlushFileBuffers(hStdOut);
+            if (!bResult) {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "FlushFileBuffers failed with error code {}. " \
+                    "Cannot flush file buffers.",
+                    GetLastError()
+                );
+
+                CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+                return true;
+            }
+        }
+
+        // Files must have their offsets updated after a successful write.
+        CloseHandleReport(overlapped.hEvent, "overlapped.HEvent");
+        if constexpr (!is_pipe) {
+            ULARGE_INTEGER newPosition;
+            newPosition.LowPart = dwOffset;
+            newPosition.HighPart = dwOffsetHigh;
+            newPosition.QuadPart += dwBytesWritten;
+
+            dwOffset = newPosition.LowPart;
+            dwOffsetHigh = newPosition.HighPart;
+        }
+
+        return false;
+    }
+
+    bool PushStdOut(
+        HANDLE hStdOut, 
+        HANDLE hCancelIO, 
+        const void* output_buffer, 
+        module_mediator::eight_bytes buffer_size, 
+        DWORD& dwOverlappedOffset, 
+        DWORD& dwOverlappedOffsetHigh
+    ) {
+        switch (GetFileType(hStdOut)) {
+            case FILE_TYPE_CHAR: {
+                return PushConsoleOutput(hStdOut, output_buffer, buffer_size);
+            }
+            case FILE_TYPE_DISK: {
+                return PushAsynchronous<FILE_TYPE_DISK>(
+                    hStdOut,
+                    hCancelIO,
+                    output_buffer,
+                    buffer_size,
+                    dwOverlappedOffset,
+                    dwOverlappedOffsetHigh
+                );
+            }
+            case FILE_TYPE_PIPE: {
+                return PushAsynchronous<FILE_TYPE_PIPE>(
+                    hStdOut,
+                    hCancelIO,
+                    output_buffer,
+                    buffer_size,
+                    dwOverlappedOffset,
+                    dwOverlappedOffsetHigh
+                );
+            }
+            default: {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Unknown file type for STDOUT: {}. " \
+                    "Cannot write to stdout.",
+                    GetFileType(hCapturedStdOut)
+                );
+
+                return true;
+            }
+        }
+    }
+}
+
+// Overlapped IO offsets, only used for files. Each pair is owned by its worker.
+namespace {
+    DWORD dwInputOffset = 0;
+    DWORD dwInputOffsetHigh = 0;
+
+    DWORD dwOutputOffset = 0;
+    DWORD dwOutputOffsetHigh = 0;
+}
+
+namespace stdio_backend {
+    bool capture() {
+        hCapturedStdOut = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (hCapturedStdOut == INVALID_HANDLE_VALUE || hCapturedStdOut == nullptr) {
+           LOG_WARNING(
+               interoperation::get_module_part(),
+                "Failed to get STDOUT handle with error code {}. ",
+                GetLastError()
+           );
+
+           hCapturedStdOut = nullptr;
+           return false;
+        }
+
+        hCapturedStdIn = GetStdHandle(STD_INPUT_HANDLE);
+        if (hCapturedStdIn == INVALID_HANDLE_VALUE || hCapturedStdIn == nullptr) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to get STDIN handle with error code {}. ",
+                GetLastError()
+            );
+
+            hCapturedStdIn = nullptr;
+            hCapturedStdOut = nullptr;
+
+            return false;
+        }
+
+        if (GetFileType(hCapturedStdIn) == FILE_TYPE_CHAR && !InitializeConsoleInput(hCapturedStdIn, dwSavedConsoleState)) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to initialize console input with error code {}." \
+                "Unexpected console handle.",
+                GetLastError()
+            );
+
+            hCapturedStdIn = nullptr;
+            hCapturedStdOut = nullptr;
+
+            return false;
+        }
+
+        hIOCancellationSignal = CreateEventA(
+            nullptr, 
+            TRUE,    
+            FALSE,   
+            nullptr 
+        );
+
+        if (hIOCancellationSignal == nullptr) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to create I/O cancellation event with error code {}.",
+                GetLastError()
+            );
+
+            if (GetFileType(hCapturedStdIn) == FILE_TYPE_CHAR) {
+                RestoreConsoleInput(hCapturedStdIn, dwSavedConsoleState);
+            }
+
+            hCapturedStdIn = nullptr;
+            hCapturedStdOut = nullptr;
+
+            return false;
+        }
+
+        dwInputOffset = 0;
+        dwInputOffsetHigh = 0;
+        dwOutputOffset = 0;
+        dwOutputOffsetHigh = 0;
+
+        return true;
+    }
+
+    bool is_captured() {
+        if (hCapturedStdIn == nullptr || hCapturedStdOut == nullptr || hIOCancellationSignal == nullptr) {
+            assert(hCapturedStdIn == nullptr && hCapturedStdOut == nullptr && hIOCancellationSignal == nullptr);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool is_output_interactive() {
+        return GetFileType(hCapturedStdOut) == FILE_TYPE_CHAR;
+    }
+
+    void prepare_worker_thread(const char* worker_name) {
+        LOG_INFO(
+            interoperation::get_module_part(),
+            "PRTS is attached to stdio. Starting {} worker. System thread is: {}.",
+            worker_name,
+            GetCurrentThreadId()
+        );
+
+        ULONG ulDesiredStackSize = 8192;
+        BOOL bResult = SetThreadStackGuarantee(&ulDesiredStackSize);
+        if (!bResult) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to set thread stack guarantee for {} worker. " \
+                "This may impede fatal error reporting.",
+                worker_name
+            );
+        }
+    }
+
+    std::pair<std::uint64_t, bool> read_input(void* buffer, std::uint64_t buffer_size) {
+        return ConsumeStdIn(
+            hCapturedStdIn, 
+            hIOCancellationSignal, 
+            static_cast<CHAR*>(buffer), 
+            buffer_size, 
+            dwInputOffset, 
+            dwInputOffsetHigh
+        );
+    }
+
+    bool write_output(const void* buffer, std::uint64_t buffer_size) {
+        return PushStdOut(
+            hCapturedStdOut, 
+            hIOCancellationSignal, 
+            buffer, 
+            buffer_size, 
+            dwOutputOffset, 
+            dwOutputOffsetHigh
+        );
+    }
+
+    std::unique_lock<std::shared_mutex> interrupt_workers(std::thread& input_worker, std::thread& output_worker) {
+        std::unique_lock io_lock(io_synchronizer, std::defer_lock);
+
+        // Workers hold io_synchronizer only while they are blocked in synchronous IO, 
+        // so we keep cancelling it until we manage to acquire the lock.
+        while (!io_lock.try_lock()) {
+            std::this_thread::yield();
+
+            //Error not found is documented to be returned if the thread is not waiting on synchronous IO.
+            BOOL cancelSynchronousInput = CancelSynchronousIo(input_worker.native_handle());
+            if (!cancelSynchronousInput && GetLastError() != ERROR_NOT_FOUND) {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Failed to cancel synchronous I/O for input worker with error code {}. " \
+                    "This may lead to resource leaks.",
+                    GetLastError()
+                );
+
+                return {};
+            }
+
+            BOOL cancelSynchronousOutput = CancelSynchronousIo(output_worker.native_handle());
+            if (!cancelSynchronousOutput && GetLastError() != ERROR_NOT_FOUND) {
+                LOG_WARNING(
+                    interoperation::get_module_part(),
+                    "Failed to cancel synchronous I/O for output worker with error code {}. " \
+                    "This may lead to resource leaks.",
+                    GetLastError()
+                );
+
+                return {};
+            }
+        }
+
+        return io_lock;
+    }
+
+    bool signal_shutdown() {
+        if (hIOCancellationSignal == nullptr) {
+            return true;
+        }
+
+        // Worker threads will exit overlapped IO, and console IO operations.
+        if (!SetEvent(hIOCancellationSignal)) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to set event for I/O cancellation with error code {}. " \
+                "This will lead to resource leaks. Detaching worker threads as a last-ditch effort.",
+                GetLastError()
+            );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool release() {
+        CloseHandleReport(hIOCancellationSignal, "hIOCancellationSignal");
+        hIOCancellationSignal = nullptr;
+
+        bool is_restored = true;
+        if (GetFileType(hCapturedStdIn) == FILE_TYPE_CHAR && !RestoreConsoleInput(hCapturedStdIn, dwSavedConsoleState)) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Failed to restore console input with error code {}. " \
+                "This error may be generated if stdio is redirected.",
+                GetLastError()
+            );
+
+            is_restored = false;
+        }
+
+        hCapturedStdOut = nullptr;
+        hCapturedStdIn = nullptr;
+        console_line_remainder.clear();
+        is_console_input_closed = false;
+
+        return is_restored;
+    }
+}
+
+#endif // _WIN32
@@ -0,0 +1,60 @@
+#ifndef DESTROY_CALLBACK_H
+#define DESTROY_CALLBACK_H
+
+#include "pch.h"
+#include "module_interoperation.h"
+
+#include "../logger_module/logging.h"
+
+/*
+* A callback that runs when a resource container is destroyed.
+* Module and function are looked up once, when the callback is added, so destroying a container doesn't search for them by name.
+*/
+struct destroy_callback {
+    std::size_t module_index;
+    std::size_t function_index;
+    module_mediator::callback_bundle* bundle;
+
+    // Returns an empty optional if the module or the function doesn't exist.
+    static std::optional<destroy_callback> resolve(module_mediator::callback_bundle* bundle) {
+        std::size_t module_index = interoperation::get_module_part()->find_module_index(bundle->module_name);
+        if (module_index == module_mediator::module_part::module_not_found) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Module {} not found.",
+                bundle->module_name
+            );
+
+            return std::nullopt;
+        }
+
+        std::size_t function_index = interoperation::get_module_part()->find_function_index(
+            module_index,
+            bundle->function_name
+        );
+
+        if (function_index == module_mediator::module_part::function_not_found) {
+            LOG_WARNING(
+                interoperation::get_module_part(),
+                "Function {} not found in module {}.",
+                bundle->function_name,
+                bundle->module_name
+            );
+
+            return std::nullopt;
+        }
+
+        return destroy_callback{ module_index, function_index, bundle };
+    }
+
+    // The called function frees the bundle (see module_mediator::respond_callback), so it can't be used after this.
+    module_mediator::return_value run() const {
+        return interoperation::get_module_part()->call_module(
+            this->module_index,
+            this->function_index,
+            this->bundle->arguments_string
+        );
+    }
+};
+
+#endif // !DESTROY_CALLBACK_H
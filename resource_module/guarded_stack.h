@@ -0,0 +1,55 @@
+#ifndef GUARDED_STACK_H
+#define GUARDED_STACK_H
+
+#include "pch.h"
+
+/*
+* Thread stacks (together with thread states, see on_thread_creation in the execution module) are followed by a guard region:
+* address space that is reserved but never committed, so any access to it faults. Compiled programs don't compare
+* every small stack allocation with the end of the stack, the execution module turns a fault in the guard region into
+* a stack overflow instead. The guard region must be larger than several such allocations made in a row (see program_functions.h
+* in the program loader), it costs nothing but address space.
+*
+* Every stack is a separate reservation and the end of the stack touches the guard region.
+* Stacks are pooled (see memory_pool), reserving and releasing address space are system calls.
+*/
+namespace guarded_stack {
+    inline constexpr std::uint64_t guard_size = 64 * 1024;
+
+    inline constexpr std::uint64_t page_size = 4096;
+    inline constexpr std::uint64_t block_alignment = 16;
+
+    inline std::uint64_t align(std::uint64_t size, std::uint64_t alignment) {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Returns a zeroed stack of at least the requested size or nullptr if memory cannot be allocated.
+    inline char* allocate(std::uint64_t size) {
+        std::uint64_t stack_size = std::max(align(size, block_alignment), block_alignment);
+        std::uint64_t committed_size = align(stack_size, page_size);
+
+        char* base = static_cast<char*>(VirtualAlloc(nullptr, committed_size + guard_size, MEM_RESERVE, PAGE_NOACCESS));
+        if (base == nullptr) {
+            return nullptr;
+        }
+
+        // Committed pages are zeroed by the system.
+        if (VirtualAlloc(base, committed_size, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+            VirtualFree(base, 0, MEM_RELEASE);
+            return nullptr;
+        }
+
+        return base + committed_size - stack_size;
+    }
+
+    inline void free(char* stack, [[maybe_unused]] std::uint64_t size) {
+        // The stack starts less than a page away from the beginning of its reservation.
+        VirtualFree(
+            reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(stack) & ~(page_size - 1)),
+            0,
+            MEM_RELEASE
+        );
+    }
+}
+
+#endif // !GUARDED_STACK_H
@@ -0,0 +1,360 @@
+#ifndef HUGE_PAGE_ARENA_H
+#define HUGE_PAGE_ARENA_H
+
+#include "pch.h"
+
+/*
+* Hands out blocks carved from 2 MiB chunks, backed by large pages when the process is allowed to use them.
+* Thousands of small thread stacks then share a few large pages instead of touching their own 4 KiB pages,
+* which takes much less of the TLB.
+*
+* Block sizes are rounded up to one of a few size classes: steps of 16 bytes up to 128 bytes, then four steps
+* per power of two, so a larger block wastes at most a fifth of its size. Every chunk holds blocks of one class only and counts
+* the blocks that are handed out. Once all of them are released, the chunk is kept for any other class, unless
+* max_empty_chunks are kept already, then it is returned to the system. Large pages can't be partially freed,
+* so memory is never returned in pieces smaller than a chunk.
+*
+* Released blocks are first cached in a shard picked by the calling thread, up to max_cached_bytes_per_shard each,
+* so that executors don't all meet on one mutex; the chunks themselves are behind a separate lock that is only taken
+* when a shard has no block of the class at hand or is full. A full shard returns all of its blocks to their chunks.
+*
+* Blocks are aligned to 16 bytes, like the ones allocated by operator new[], so that memory_owners can map them.
+* Chunks are aligned to their size, the chunk of a block is found by its address.
+*
+* The arena is disabled by default, see enable. Once it is enabled, it serves every block that is not larger than max_block_size,
+* so whether a block belongs to the arena can always be told by its size alone.
+*/
+class huge_page_arena {
+public:
+    static constexpr std::uint64_t chunk_size = 2ull * 1024 * 1024;
+    static constexpr std::uint64_t max_block_size = chunk_size / 8;
+
+private:
+    static constexpr std::uint64_t block_alignment = 16;
+
+    static constexpr std::uint32_t small_size_classes_count = 8;
+    static constexpr std::uint64_t max_small_block_size = small_size_classes_count * block_alignment;
+    static constexpr std::uint32_t steps_per_power_of_two = 4;
+    static constexpr std::uint32_t size_classes_count = 52;
+
+    static constexpr std::size_t shards_count = 16;
+    static_assert(std::has_single_bit(shards_count), "shards count must be a power of two");
+
+    static constexpr std::uint64_t max_cached_bytes_per_shard = 1024 * 1024;
+    static constexpr std::size_t max_empty_chunks = 4;
+
+    struct chunk {
+        void* reservation;
+        char* base;
+
+        std::uint32_t size_class{ 0 };
+        std::uint64_t live_blocks{ 0 };
+        std::uint64_t carved_size{ 0 };
+        std::vector<char*> free_blocks{};
+
+        // Memory of a chunk that was never carved before is zeroed by the system.
+        bool is_fresh{ true };
+        bool is_available{ false };
+    };
+
+    struct alignas(std::hardware_destructive_interference_size) shard {
+        std::mutex lock;
+        std::array<std::vector<char*>, size_classes_count> free_blocks;
+        std::uint64_t cached_bytes{ 0 };
+    };
+
+    std::array<shard, shards_count> shards{};
+
+    std::mutex chunks_lock{};
+    std::unordered_map<std::uintptr_t, std::unique_ptr<chunk>> chunks{};
+    std::array<std::vector<chunk*>, size_classes_count> available_chunks{}; // Chunks that have a free or not yet carved block
+    std::vector<chunk*> empty_chunks{};
+
+    bool enabled{ false };
+    bool large_pages{ false };
+
+    // Empty blocks take space as well, every block must have its own address.
+    static constexpr std::uint32_t get_size_class(std::uint64_t size) noexcept {
+        if (size <= max_small_block_size) {
+            return static_cast<std::uint32_t>(std::max<std::uint64_t>((size + block_alignment - 1) / block_alignment, 1) - 1);
+        }
+
+        // 2^power < size <= 2^(power + 1), the range is split into steps_per_power_of_two classes.
+        std::uint64_t power = std::bit_width(size - 1) - 1;
+        std::uint64_t step = (1ull << power) / steps_per_power_of_two;
+        std::uint64_t steps = (size - (1ull << power) + step - 1) / step;
+
+        return static_cast<std::uint32_t>(
+            small_size_classes_count + (power - std::bit_width(max_small_block_size) + 1) * steps_per_power_of_two + steps - 1
+        );
+    }
+
+    static constexpr std::uint64_t get_class_size(std::uint32_t size_class) noexcept {
+        if (size_class < small_size_classes_count) {
+            return (size_class + 1) * block_alignment;
+        }
+
+        std::uint32_t large_class = size_class - small_size_classes_count;
+        std::uint64_t power_of_two = max_small_block_size << (large_class / steps_per_power_of_two);
+
+        return power_of_two + (large_class % steps_per_power_of_two + 1) * (power_of_two / steps_per_power_of_two);
+    }
+
+    // Large pages can only be allocated by a process that holds SeLockMemoryPrivilege,
+    // and the privilege has to be enabled even if the account has it.
+    static bool enable_lock_memory_privilege() {
+        HANDLE token = nullptr;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+            return false;
+        }
+
+        TOKEN_PRIVILEGES privileges{};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+        bool is_enabled =
+            LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+            AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+            GetLastError() == ERROR_SUCCESS; // AdjustTokenPrivileges succeeds with ERROR_NOT_ALL_ASSIGNED if the privilege is not held.
+
+        CloseHandle(token);
+        return is_enabled;
+    }
+
+    shard& get_shard() noexcept {
+        return this->shards[std::hash<std::thread::id>{}(std::this_thread::get_id()) & (shards_count - 1)];
+    }
+
+    // The chunks lock must be held. Memory is committed right away: large pages can't be reserved, and committed pages are zeroed.
+    chunk* add_chunk() {
+        void* reservation = nullptr;
+        char* base = nullptr;
+        if (this->large_pages) {
+            // Large page allocations are aligned to the large page size, which divides the chunk size.
+            reservation = VirtualAlloc(nullptr, chunk_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            base = static_cast<char*>(reservation);
+        }
+
+        // Large pages may run out when physical memory gets fragmented, regular pages still keep the blocks together.
+        // Regular allocations are only aligned to 64 KiB, so twice the chunk size is reserved and the aligned part is committed.
+        if (reservation == nullptr) {
+            reservation = VirtualAlloc(nullptr, chunk_size * 2, MEM_RESERVE, PAGE_NOACCESS);
+            if (reservation == nullptr) {
+                return nullptr;
+            }
+
+            base = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(reservation) + chunk_size - 1) & ~(chunk_size - 1));
+            if (VirtualAlloc(base, chunk_size, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+                VirtualFree(reservation, 0, MEM_RELEASE);
+                return nullptr;
+            }
+        }
+
+        auto [new_chunk, is_inserted] = this->chunks.emplace(
+            reinterpret_cast<std::uintptr_t>(base),
+            std::make_unique<chunk>(chunk{ .reservation = reservation, .base = base })
+        );
+
+        return new_chunk->second.get();
+    }
+
+    // The chunks lock must be held. Returns a block of the class and whether it is zeroed, or nullptr if memory cannot be allocated.
+    std::pair<char*, bool> take_block(std::uint32_t size_class) {
+        std::uint64_t class_size = get_class_size(size_class);
+        std::vector<chunk*>& available = this->available_chunks[size_class];
+        if (available.empty()) {
+            chunk* new_chunk = nullptr;
+            if (!this->empty_chunks.empty()) {
+                new_chunk = this->empty_chunks.back();
+                this->empty_chunks.pop_back();
+
+                new_chunk->carved_size = 0;
+                new_chunk->is_fresh = false;
+            }
+            else {
+                new_chunk = this->add_chunk();
+                if (new_chunk == nullptr) {
+                    return { nullptr, false };
+                }
+            }
+
+            new_chunk->size_class = size_class;
+            new_chunk->is_available = true;
+            available.push_back(new_chunk);
+        }
+
+        chunk& source = *available.back();
+
+        char* block = nullptr;
+        bool is_zeroed = false;
+        if (!source.free_blocks.empty()) {
+            block = source.free_blocks.back();
+            source.free_blocks.pop_back();
+        }
+        else {
+            block = source.base + source.carved_size;
+            source.carved_size += class_size;
+            is_zeroed = source.is_fresh;
+        }
+
+        ++source.live_blocks;
+        if (source.free_blocks.empty() && source.carved_size + class_size > chunk_size) {
+            source.is_available = false;
+            available.pop_back();
+        }
+
+        return { block, is_zeroed };
+    }
+
+    // The chunks lock must be held.
+    void return_block(char* block) {
+        auto found_chunk = this->chunks.find(reinterpret_cast<std::uintptr_t>(block) & ~(chunk_size - 1));
+        assert(found_chunk != this->chunks.end() && "block does not belong to the arena");
+
+        chunk& owner = *found_chunk->second;
+        if (--owner.live_blocks != 0) {
+            owner.free_blocks.push_back(block);
+            if (!owner.is_available) {
+                owner.is_available = true;
+                this->available_chunks[owner.size_class].push_back(&owner);
+            }
+
+            return;
+        }
+
+        // Every block of the chunk is free, so the chunk can be carved for any class from scratch.
+        if (owner.is_available) {
+            std::erase(this->available_chunks[owner.size_class], &owner);
+            owner.is_available = false;
+        }
+
+        if (this->empty_chunks.size() < max_empty_chunks) {
+            owner.free_blocks.clear();
+            this->empty_chunks.push_back(&owner);
+        }
+        else {
+            VirtualFree(owner.reservation, 0, MEM_RELEASE);
+            this->chunks.erase(found_chunk);
+        }
+    }
+
+public:
+    huge_page_arena() = default;
+
+    huge_page_arena(const huge_page_arena&) = delete;
+    huge_page_arena& operator= (const huge_page_arena&) = delete;
+
+    /*
+    * Must be called before any memory is allocated by the resource module, and only once.
+    * Returns false if large pages are not available, the arena still groups blocks into chunks of regular pages in that case.
+    */
+    bool enable() {
+        std::uint64_t large_page_size = GetLargePageMinimum();
+
+        this->enabled = true;
+        this->large_pages = large_page_size != 0 && chunk_size % large_page_size == 0 && enable_lock_memory_privilege();
+
+        return this->large_pages;
+    }
+
+    bool is_enabled() const noexcept {
+        return this->enabled;
+    }
+
+    bool serves(std::uint64_t size) const noexcept {
+        return this->enabled && size <= max_block_size;
+    }
+
+    // Returns a zeroed block or nullptr if memory cannot be allocated.
+    char* allocate(std::uint64_t size) {
+        std::uint32_t size_class = get_size_class(size);
+        shard& local_shard = this->get_shard();
+
+        char* block = nullptr;
+        {
+            std::scoped_lock shard_lock{ local_shard.lock };
+
+            std::vector<char*>& cached_blocks = local_shard.free_blocks[size_class];
+            if (!cached_blocks.empty()) {
+                block = cached_blocks.back();
+                cached_blocks.pop_back();
+                local_shard.cached_bytes -= get_class_size(size_class);
+            }
+        }
+
+        if (block == nullptr) {
+            bool is_zeroed = false;
+            {
+                std::scoped_lock arena_lock{ this->chunks_lock };
+                std::tie(block, is_zeroed) = this->take_block(size_class);
+            }
+
+            if (block == nullptr || is_zeroed) {
+                return block;
+            }
+        }
+
+        // Scrub the block, the previous owner could have left anything in there.
+        std::memset(block, 0, size);
+        return block;
+    }
+
+    void release(char* block, std::uint64_t size) {
+        std::uint32_t size_class = get_size_class(size);
+        std::uint64_t class_size = get_class_size(size_class);
+        shard& local_shard = this->get_shard();
+        {
+            std::scoped_lock shard_lock{ local_shard.lock };
+            if (local_shard.cached_bytes + class_size <= max_cached_bytes_per_shard) {
+                local_shard.free_blocks[size_class].push_back(block);
+                local_shard.cached_bytes += class_size;
+
+                return;
+            }
+        }
+
+        // A cached block keeps its chunk from being emptied, so a full shard gives all of its blocks back at once.
+        std::scoped_lock arena_lock{ local_shard.lock, this->chunks_lock };
+        for (std::vector<char*>& cached_blocks : local_shard.free_blocks) {
+            for (char* cached_block : cached_blocks) {
+                this->return_block(cached_block);
+            }
+
+            cached_blocks.clear();
+        }
+
+        local_shard.cached_bytes = 0;
+        this->return_block(block);
+    }
+
+    ~huge_page_arena() noexcept {
+        static_assert(get_size_class(max_block_size) == size_classes_count - 1, "every block size must have a size class");
+        static_assert(get_class_size(size_classes_count - 1) == max_block_size, "the largest size class must fit max_block_size exactly");
+
+        for (auto& [base, owned_chunk] : this->chunks) {
+            VirtualFree(owned_chunk->reservation, 0, MEM_RELEASE);
+        }
+    }
+};
+
+extern huge_page_arena huge_pages;
+
+// Every block of memory that the resource module hands out is allocated and freed with these two functions.
+inline char* allocate_raw_block(std::uint64_t size) {
+    if (huge_pages.serves(size)) {
+        return huge_pages.allocate(size);
+    }
+
+    return new(std::nothrow) char[size] {};
+}
+
+inline void free_raw_block(char* block, std::uint64_t size) {
+    if (huge_pages.serves(size)) {
+        huge_pages.release(block, size);
+    }
+    else {
+        delete[] block;
+    }
+}
+
+#endif // !HUGE_PAGE_ARENA_H
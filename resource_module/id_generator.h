@@ -8,39 +8,42 @@ class id_generator {
 public:
     using id_type = module_mediator::return_value;
 
+    // The low 32 bits of an id. Unique among the ids that are in use, memory_owners (see page_map.h) stores it instead of the id.
+    using index_type = std::uint32_t;
+
 private:
-#ifndef NDEBUG // We must ensure specific ordering when freeing objects. Structures must get fully destroyed in execution module before freeing them in resource module
     inline static std::stack<id_type> free_ids{};
     inline static std::mutex lock{};
     inline static id_type current_id = 1;
-#else // For release builds, there is no point doing that. This is faster, and yet it is still impossible to run out of IDs
-    inline static std::atomic<id_type> current_id{ 1 };
+
+#ifdef NDEBUG // A reused index gets a new generation (the upper 32 bits), so that an id is never handed out twice.
+    static constexpr id_type generation_increment = id_type{ 1 } << 32;
+#else // We must ensure specific ordering when freeing objects. Structures must get fully destroyed in execution module before freeing them in resource module
+    static constexpr id_type generation_increment = 0;
 #endif
 
 public:
     static id_type get_id() {
-#ifndef NDEBUG
         std::lock_guard scope{ lock };
         if (!free_ids.empty()) {
             id_type id = free_ids.top();
             free_ids.pop();
 
-            return id;
+            return id + generation_increment;
         }
 
+        assert(current_id <= std::numeric_limits<index_type>::max() && "ran out of id indices");
         return current_id++;
-#else
-        return current_id.fetch_add(1, std::memory_order_relaxed);
-#endif
     }
+
     static void free_id(id_type id) {
-#ifndef NDEBUG
         std::lock_guard scope{ lock };
         free_ids.push(id);
         assert(id != 0);
-#else
-        (void(id));
-#endif
+    }
+
+    static index_type get_index(id_type id) {
+        return static_cast<index_type>(id);
     }
 };
 
@@ -0,0 +1,108 @@
+#ifndef MEMORY_ACCOUNT_H
+#define MEMORY_ACCOUNT_H
+
+#include "pch.h"
+
+/*
+* Memory allocated by a thread group or a program, possibly limited by a quota.
+* The account of a thread group is charged for memory of the group itself and memory of its threads,
+* and passes every change on to the account of its program, so both are always up to date with each other.
+* Accounts are shared between threads, so they are made of atomics. Owners don't update them on every allocation,
+* see memory_usage for that.
+*/
+class memory_account {
+public:
+    static constexpr std::uint64_t no_quota = std::numeric_limits<std::uint64_t>::max();
+
+private:
+    std::atomic<std::uint64_t> allocated_bytes{ 0 };
+    std::atomic<std::uint64_t> allocations_count{ 0 };
+
+    const std::uint64_t bytes_quota;
+    const std::shared_ptr<memory_account> parent;
+
+    // True if this account or any of its parents has a quota. Quotas don't change after the account is created.
+    const bool limited;
+
+public:
+    memory_account(std::uint64_t bytes_quota, std::shared_ptr<memory_account> parent)
+        :bytes_quota{ bytes_quota },
+        parent{ std::move(parent) },
+        limited{ bytes_quota != no_quota || (this->parent != nullptr && this->parent->is_limited()) }
+    {}
+
+    memory_account(const memory_account&) = delete;
+    memory_account& operator= (const memory_account&) = delete;
+
+    bool is_limited() const noexcept {
+        return this->limited;
+    }
+
+    const std::shared_ptr<memory_account>& get_parent() const noexcept {
+        return this->parent;
+    }
+
+    std::uint64_t get_allocated_bytes() const noexcept {
+        return this->allocated_bytes.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t get_allocations_count() const noexcept {
+        return this->allocations_count.load(std::memory_order_relaxed);
+    }
+
+    // Charges an allocation to this account and its parents.
+    // Returns false and leaves all accounts as they were if that would exceed any of their quotas.
+    bool try_charge(std::uint64_t bytes, std::uint64_t count) noexcept {
+        std::uint64_t current_bytes = this->allocated_bytes.load(std::memory_order_relaxed);
+        do {
+            if (bytes > this->bytes_quota - std::min(current_bytes, this->bytes_quota)) {
+                return false;
+            }
+        } while (!this->allocated_bytes.compare_exchange_weak(current_bytes, current_bytes + bytes, std::memory_order_relaxed));
+
+        if (this->parent != nullptr && !this->parent->try_charge(bytes, count)) {
+            this->allocated_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            return false;
+        }
+
+        this->allocations_count.fetch_add(count, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Applies a change without checking quotas. Used for deallocations and for accounts that are not limited.
+    // Negative changes wrap around, the sum of all changes made by an owner is never negative.
+    void add(std::int64_t bytes, std::int64_t count) noexcept {
+        this->allocated_bytes.fetch_add(static_cast<std::uint64_t>(bytes), std::memory_order_relaxed);
+        this->allocations_count.fetch_add(static_cast<std::uint64_t>(count), std::memory_order_relaxed);
+
+        if (this->parent != nullptr) {
+            this->parent->add(bytes, count);
+        }
+    }
+};
+
+// Quotas given to new accounts, configured when the module is initialized.
+namespace memory_quotas {
+    inline std::uint64_t thread_group = memory_account::no_quota;
+    inline std::uint64_t program = memory_account::no_quota;
+}
+
+/*
+* Memory allocated by a single resource container. It is only changed while the lock of the container is held, so it is exact
+* and cheap to update. Changes are passed on to the account in batches: an account that is not limited may lag behind by up to
+* flush_bytes_threshold bytes and flush_count_threshold allocations per container. Limited accounts are charged right away,
+* otherwise a quota could be exceeded by that much.
+*/
+struct memory_usage {
+    static constexpr std::int64_t flush_bytes_threshold = 64 * 1024;
+    static constexpr std::int64_t flush_count_threshold = 256;
+
+    std::uint64_t allocated_bytes{ 0 };
+    std::uint64_t allocations_count{ 0 };
+
+    // Changes that are not passed on to the account yet.
+    std::int64_t pending_bytes{ 0 };
+    std::int64_t pending_count{ 0 };
+};
+
+#endif // !MEMORY_ACCOUNT_H
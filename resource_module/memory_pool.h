@@ -0,0 +1,101 @@
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+
+#include "pch.h"
+#include "huge_page_arena.h"
+
+/*
+* Keeps released memory blocks around so that they can be handed out again without going to the allocator.
+* Blocks are grouped by their exact size, because threads of one thread group always request blocks of the same size
+* (thread state with stack, memory descriptors, etc.). Every block that leaves the pool is zeroed,
+* so it is indistinguishable from the one allocated with the allocate function of the pool.
+*/
+class memory_pool {
+public:
+    using allocate_function_type = char* (*)(std::uint64_t size);
+    using free_function_type = void (*)(char* block, std::uint64_t size);
+
+private:
+    std::unordered_map<std::uint64_t, std::vector<char*>> free_blocks{};
+    std::uint64_t pooled_bytes{ 0 };
+
+    std::size_t max_blocks_per_size;
+    std::uint64_t max_pooled_bytes;
+
+    allocate_function_type allocate_function;
+    free_function_type free_function;
+
+    std::mutex lock{};
+
+public:
+    memory_pool(
+        std::size_t max_blocks_per_size, 
+        std::uint64_t max_pooled_bytes,
+        allocate_function_type allocate_function = &allocate_raw_block,
+        free_function_type free_function = &free_raw_block
+    )
+        :max_blocks_per_size{ max_blocks_per_size },
+        max_pooled_bytes{ max_pooled_bytes },
+        allocate_function{ allocate_function },
+        free_function{ free_function }
+    {}
+
+    memory_pool(const memory_pool&) = delete;
+    memory_pool& operator= (const memory_pool&) = delete;
+
+    // Returns a zeroed block of the requested size or nullptr if memory cannot be allocated.
+    char* acquire(std::uint64_t size) {
+        char* block = nullptr;
+        {
+            std::scoped_lock pool_lock{ this->lock };
+
+            auto found_blocks = this->free_blocks.find(size);
+            if (found_blocks != this->free_blocks.end() && !found_blocks->second.empty()) {
+                block = found_blocks->second.back();
+                found_blocks->second.pop_back();
+
+                this->pooled_bytes -= size;
+            }
+        }
+
+        if (block == nullptr) {
+            return this->allocate_function(size);
+        }
+
+        // Scrub the block, the previous owner could have left anything in there.
+        std::memset(block, 0, size);
+        return block;
+    }
+
+    // Takes ownership of a block. The block must have been allocated with the allocate function of the pool, with the specified size.
+    void release(char* block, std::uint64_t size) {
+        if (block == nullptr) {
+            return;
+        }
+
+        {
+            std::scoped_lock pool_lock{ this->lock };
+            if (this->pooled_bytes + size <= this->max_pooled_bytes) {
+                std::vector<char*>& blocks = this->free_blocks[size];
+                if (blocks.size() < this->max_blocks_per_size) {
+                    blocks.push_back(block);
+                    this->pooled_bytes += size;
+
+                    return;
+                }
+            }
+        }
+
+        this->free_function(block, size);
+    }
+
+    ~memory_pool() noexcept {
+        for (auto& [size, blocks] : this->free_blocks) {
+            for (char* block : blocks) {
+                this->free_function(block, size);
+            }
+        }
+    }
+};
+
+#endif // !MEMORY_POOL_H
@@ -1,12 +1,60 @@
 #include "pch.h"
 #include "resource_module.h"
 #include "module_interoperation.h"
+#include "memory_account.h"
+#include "huge_page_arena.h"
 #include "../logger_module/logging.h"
 
 #include "../module_mediator/module_part.h"
 
 namespace {
 	module_mediator::module_part* part = nullptr;
+
+	// Reads a quota in bytes from an environment variable. There is no quota if the variable is not set.
+	std::uint64_t read_memory_quota(const char* variable_name) {
+		char value[32]{};
+		DWORD dwValueSize = GetEnvironmentVariableA(variable_name, value, static_cast<DWORD>(std::size(value)));
+		if (dwValueSize == 0) {
+			return memory_account::no_quota;
+		}
+
+		std::uint64_t quota{};
+		bool is_valid = dwValueSize < std::size(value);
+		if (is_valid) {
+			auto [end, error] = std::from_chars(value, value + dwValueSize, quota);
+			is_valid = error == std::errc{} && end == value + dwValueSize;
+		}
+
+		if (!is_valid) {
+			LOG_WARNING(part, "Ignoring {}: the value must be a number of bytes.", variable_name);
+			return memory_account::no_quota;
+		}
+
+		LOG_INFO(part, "{} is set to {} bytes.", variable_name, quota);
+		return quota;
+	}
+
+	// Thread memory and small heap blocks are put on large pages if FSI_HUGE_PAGES is set to 1.
+	void configure_huge_pages() {
+		char value[2]{};
+		DWORD dwValueSize = GetEnvironmentVariableA("FSI_HUGE_PAGES", value, static_cast<DWORD>(std::size(value)));
+		if (dwValueSize != 1 || value[0] != '1') {
+			return;
+		}
+
+		if (huge_pages.enable()) {
+			LOG_INFO(part, "Memory blocks of up to {} bytes are allocated on large pages.", huge_page_arena::max_block_size);
+		}
+		else {
+			LOG_WARNING(
+				part,
+				"Large pages are not available (the process needs SeLockMemoryPrivilege). Memory blocks of up to {} bytes " \
+				"are grouped into chunks of {} bytes on regular pages instead.",
+				huge_page_arena::max_block_size,
+				huge_page_arena::chunk_size
+			);
+		}
+	}
 }
 
 namespace interoperation {
@@ -18,6 +66,11 @@ namespace interoperation {
 void initialize_m(module_mediator::module_part* module_part) {
 	part = module_part;
 	logger_module::global_logging_instance::set_logging_enabled(true);
+
+	memory_quotas::thread_group = read_memory_quota("FSI_THREAD_GROUP_MEMORY_QUOTA");
+	memory_quotas::program = read_memory_quota("FSI_PROGRAM_MEMORY_QUOTA");
+
+	configure_huge_pages();
 }
 
 void free_m() {
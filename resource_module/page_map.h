@@ -0,0 +1,181 @@
+#ifndef PAGE_MAP_H
+#define PAGE_MAP_H
+
+#include "pch.h"
+#include "id_generator.h"
+
+/*
+* Maps the start of every live memory block handed out by the resource module to the id index of its owner
+* (a thread structure or a program container, see id_generator::get_index), so that memory can be verified without looking up the owner.
+*
+* It is a radix tree over the user address space: root -> directory (1 GiB of addresses) -> page (4 KiB of addresses).
+* A page holds one 4 byte entry per 16 bytes, which is the alignment of every block (operator new[] on x64),
+* so a page of blocks costs 1 KiB of map. Directories (2 MiB each) are committed in full,
+* but the system gives them physical memory only as their parts get touched.
+*
+* Readers never take locks. Directories and pages are never freed while the map is alive,
+* so a reader can't step on freed memory, it can only see an entry that is being changed concurrently.
+* Writers update only the entries of the blocks they own, so entries themselves are never contended.
+*/
+class page_map {
+public:
+    using owner_type = id_generator::index_type;
+    static constexpr owner_type no_owner = 0;
+
+private:
+    static constexpr std::size_t address_bits = 47; // User mode addresses on x64.
+    static constexpr std::size_t granule_bits = 4;
+    static constexpr std::size_t page_bits = 12;
+    static constexpr std::size_t directory_bits = 30;
+
+    static constexpr std::size_t entries_per_page = std::size_t{ 1 } << (page_bits - granule_bits);
+    static constexpr std::size_t pages_per_directory = std::size_t{ 1 } << (directory_bits - page_bits);
+    static constexpr std::size_t directories_count = std::size_t{ 1 } << (address_bits - directory_bits);
+
+    struct page {
+        std::atomic<owner_type> owners[entries_per_page];
+    };
+
+    struct directory {
+        std::atomic<page*> pages[pages_per_directory];
+    };
+
+    std::array<std::atomic<directory*>, directories_count> directories{};
+
+    static std::uintptr_t get_address(const void* address) {
+        return reinterpret_cast<std::uintptr_t>(address);
+    }
+
+    static bool is_mapped_address(std::uintptr_t address) {
+        return (address >> address_bits) == 0 && (address & ((std::uintptr_t{ 1 } << granule_bits) - 1)) == 0;
+    }
+
+    static directory* create_directory() {
+        // Committed pages are zeroed by the system, so a fresh directory has no pages.
+        return static_cast<directory*>(VirtualAlloc(nullptr, sizeof(directory), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    }
+
+    static void destroy_directory(directory* unused_directory) {
+        VirtualFree(unused_directory, 0, MEM_RELEASE);
+    }
+
+    static page* create_page() {
+        return new(std::nothrow) page{};
+    }
+
+    static void destroy_page(page* unused_page) {
+        delete unused_page;
+    }
+
+    // Whoever loses the race for an empty slot destroys its node and uses the winner's.
+    template<typename node_type>
+    static node_type* get_or_create(std::atomic<node_type*>& slot, node_type* (*create)(), void (*destroy)(node_type*)) {
+        node_type* node = slot.load(std::memory_order_acquire);
+        if (node != nullptr) {
+            return node;
+        }
+
+        node_type* new_node = create();
+        if (new_node == nullptr) {
+            return nullptr;
+        }
+
+        if (slot.compare_exchange_strong(node, new_node, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return new_node;
+        }
+
+        destroy(new_node);
+        return node;
+    }
+
+    std::atomic<owner_type>* find_entry(std::uintptr_t address) const {
+        directory* found_directory = this->directories[address >> directory_bits].load(std::memory_order_acquire);
+        if (found_directory == nullptr) {
+            return nullptr;
+        }
+
+        page* found_page = found_directory->pages[(address >> page_bits) & (pages_per_directory - 1)].load(std::memory_order_acquire);
+        if (found_page == nullptr) {
+            return nullptr;
+        }
+
+        return &found_page->owners[(address >> granule_bits) & (entries_per_page - 1)];
+    }
+
+public:
+    page_map() = default;
+
+    page_map(const page_map&) = delete;
+    page_map& operator= (const page_map&) = delete;
+
+    // Returns false if the block can't be tracked: it is misaligned, or the memory for the map can't be allocated.
+    bool set_owner(const void* block, owner_type owner) {
+        std::uintptr_t address = get_address(block);
+        if (!is_mapped_address(address)) {
+            return false;
+        }
+
+        directory* found_directory = get_or_create(this->directories[address >> directory_bits], &create_directory, &destroy_directory);
+        if (found_directory == nullptr) {
+            return false;
+        }
+
+        page* found_page = get_or_create(
+            found_directory->pages[(address >> page_bits) & (pages_per_directory - 1)],
+            &create_page,
+            &destroy_page
+        );
+
+        if (found_page == nullptr) {
+            return false;
+        }
+
+        found_page->owners[(address >> granule_bits) & (entries_per_page - 1)].store(owner, std::memory_order_release);
+        return true;
+    }
+
+    void clear_owner(const void* block) {
+        std::uintptr_t address = get_address(block);
+        if (!is_mapped_address(address)) {
+            return;
+        }
+
+        if (std::atomic<owner_type>* entry = this->find_entry(address)) {
+            entry->store(no_owner, std::memory_order_release);
+        }
+    }
+
+    // Returns no_owner if the address is not the start of a live block.
+    owner_type get_owner(const void* block) const {
+        std::uintptr_t address = get_address(block);
+        if (!is_mapped_address(address)) {
+            return no_owner;
+        }
+
+        if (std::atomic<owner_type>* entry = this->find_entry(address)) {
+            return entry->load(std::memory_order_acquire);
+        }
+
+        return no_owner;
+    }
+
+    ~page_map() noexcept {
+        for (std::atomic<directory*>& directory_slot : this->directories) {
+            directory* used_directory = directory_slot.load(std::memory_order_relaxed);
+            if (used_directory == nullptr) {
+                continue;
+            }
+
+            for (std::atomic<page*>& page_slot : used_directory->pages) {
+                destroy_page(page_slot.load(std::memory_order_relaxed));
+            }
+
+            destroy_directory(used_directory);
+        }
+    }
+};
+
+// Owners of every block allocated through the resource module. Defined in resource_module.cpp.
+extern page_map memory_owners;
+
+#endif // !PAGE_MAP_H
@@ -30,6 +30,16 @@
 #include <algorithm>
 #include <atomic>
 #include <set>
+#include <unordered_map>
+#include <cstring>
 #include <syncstream>
+#include <array>
+#include <bit>
+#include <optional>
+#include <memory>
+#include <limits>
+#include <cstdlib>
+#include <charconv>
+#include <thread>
 
 #endif
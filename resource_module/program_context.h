@@ -2,11 +2,15 @@
 #define PROGRAM_CONTEXT_H
 
 #include "pch.h"
+#include "memory_account.h"
 
 struct program_context {
 private:
-    std::size_t references_count{ 1 };
-    std::mutex references_mutex{};
+    /*
+    * Every program container that shares this context holds one reference. A new reference is only ever made from
+    * an existing one (see duplicate), so the count can't go up from zero and no lock is needed.
+    */
+    std::atomic<std::size_t> references_count{ 1 };
 
     program_context(
         void* application_image_base, void* application_runtime_function_entries,
@@ -47,6 +51,9 @@ public:
     void** strings{};
     std::uint64_t strings_size{};
 
+    // Memory of all thread groups that share this context, see program_container::account.
+    std::shared_ptr<memory_account> account{ std::make_shared<memory_account>(memory_quotas::program, nullptr) };
+
     static program_context* create(
         void* application_image_base, void* application_runtime_function_entries,
         std::uint64_t preferred_stack_size,
@@ -72,16 +79,23 @@ public:
     program_context& operator=(const program_context&) = delete;
 
     static program_context* duplicate(program_context* object) {
-        std::scoped_lock lock{ object->references_mutex };
-        assert(object->references_count != 0);
+        // The caller holds a reference, so nothing needs to be ordered with the increment.
+        [[maybe_unused]] std::size_t previous_count = object->references_count.fetch_add(1, std::memory_order_relaxed);
+        assert(previous_count != 0);
 
-        ++object->references_count;
         return object;
     }
 
-    std::size_t decrease_references_count() {
-        std::scoped_lock lock{ this->references_mutex };
-        return --this->references_count;
+    // Drops a reference and destroys the context if it was the last one.
+    static void release(program_context* object) noexcept {
+        /*
+        * Release publishes everything that this owner did with the context before letting go of it.
+        * Acquire on the last reference makes all of that visible to the destructor, whichever thread it runs on.
+        */
+
+        if (object->references_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete object;
+        }
     }
 
     ~program_context() noexcept;
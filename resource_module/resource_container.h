@@ -4,6 +4,11 @@
 #include "pch.h"
 #include "id_generator.h"
 #include "module_interoperation.h"
+#include "memory_pool.h"
+#include "guarded_stack.h"
+#include "page_map.h"
+#include "destroy_callback.h"
+#include "memory_account.h"
 
 #include "../logger_module/logging.h"
 
@@ -17,92 +22,166 @@ private:
     };
 
 public:
-    std::vector<module_mediator::callback_bundle*> destroy_callbacks{};
-    std::set<void*, memory_comparator> allocated_memory{ memory_comparator{} };
+    std::vector<destroy_callback> destroy_callbacks{}; // Run in the order they were added.
+    std::map<void*, std::uint64_t, memory_comparator> allocated_memory{ memory_comparator{} }; // Address -> size of the block.
+    std::map<void*, std::uint64_t, memory_comparator> allocated_stacks{ memory_comparator{} }; // Same, for blocks allocated with guarded_stack.
+
+    memory_usage usage{};
+    std::shared_ptr<memory_account> account{}; // Threads are charged to the account of their thread group.
 
     std::recursive_mutex* lock{ new std::recursive_mutex{} };
 
     resource_container() = default;
     void move_resource_container_to_this(resource_container&& object) {  // NOLINT(cppcoreguidelines-rvalue-reference-param-not-moved)
         this->allocated_memory = std::move(object.allocated_memory);
+        this->allocated_stacks = std::move(object.allocated_stacks);
+        this->usage = std::exchange(object.usage, memory_usage{});
+        this->account = std::move(object.account);
     }
 
     resource_container(const resource_container& object) = delete;
     resource_container& operator= (const resource_container& object) = delete;
 
     resource_container(resource_container&& object) noexcept
-        :allocated_memory{ std::move(object.allocated_memory) }
+        :allocated_memory{ std::move(object.allocated_memory) },
+        allocated_stacks{ std::move(object.allocated_stacks) },
+        usage{ std::exchange(object.usage, memory_usage{}) },
+        account{ std::move(object.account) }
     {}
     resource_container& operator= (resource_container&& object) noexcept {
         this->move_resource_container_to_this(std::move(object));
         return *this;
     }
 
-    virtual ~resource_container() noexcept {
-        // Calls to destroy callbacks must precede the deallocation of memory
-        for (auto& destroy_callback : this->destroy_callbacks) {
-            std::size_t module_index = interoperation::get_module_part()->find_module_index(destroy_callback->module_name);
-            if (module_index == module_mediator::module_part::module_not_found) {
+    void run_destroy_callbacks() noexcept {
+        for (const destroy_callback& callback : this->destroy_callbacks) {
+            module_mediator::return_value result = callback.run();
+            if (result != module_mediator::module_success) {
                 LOG_WARNING(
                     interoperation::get_module_part(),
-                    std::format(
-                        "Module {} not found.", 
-                        destroy_callback->module_name
-                    )
+                    "Deferred callback (module index {}, function index {}) failed with error code {}." \
+                    " Failure in callback execution may lead to memory leaks.",
+                    callback.module_index,
+                    callback.function_index,
+                    result
                 );
-
-                continue;
             }
+        }
 
-            std::size_t function_index = interoperation::get_module_part()->find_function_index(
-                module_index,
-                destroy_callback->function_name
-            );
-            if (function_index == module_mediator::module_part::function_not_found) {
-                LOG_WARNING(
-                    interoperation::get_module_part(),
-                    std::format(
-                        "Function {} not found in module {}.", 
-                        destroy_callback->function_name, 
-                        destroy_callback->module_name
-                    )
-                );
+        this->destroy_callbacks.clear();
+    }
 
-                continue;
+    // The lock must be held. Returns false if the allocation would exceed a quota, nothing is charged in that case.
+    bool charge_memory(std::uint64_t size) {
+        if (this->account != nullptr) {
+            if (this->account->is_limited()) {
+                if (!this->account->try_charge(size, 1)) {
+                    return false;
+                }
+            }
+            else {
+                this->usage.pending_bytes += static_cast<std::int64_t>(size);
+                ++this->usage.pending_count;
+                this->flush_memory_usage_if_needed();
             }
+        }
 
-            module_mediator::return_value result = interoperation::get_module_part()->call_module(
-                module_index,
-                function_index,
-                destroy_callback->arguments_string
-            );
+        this->usage.allocated_bytes += size;
+        ++this->usage.allocations_count;
 
-            if (result != module_mediator::module_success) {
-                LOG_WARNING(
-                    interoperation::get_module_part(),
-                    std::format(
-                        "Deferred callback for module {} and function {} failed with error code {}." \
-                        " Failure in callback execution may lead to memory leaks.",
-                        destroy_callback->module_name,
-                        destroy_callback->function_name,
-                        result
-                    )
-                );
+        return true;
+    }
+
+    // The lock must be held.
+    void uncharge_memory(std::uint64_t size) {
+        if (this->account != nullptr) {
+            if (this->account->is_limited()) {
+                this->account->add(-static_cast<std::int64_t>(size), -1);
+            }
+            else {
+                this->usage.pending_bytes -= static_cast<std::int64_t>(size);
+                --this->usage.pending_count;
+                this->flush_memory_usage_if_needed();
             }
         }
 
-        if (!this->allocated_memory.empty()) {
+        this->usage.allocated_bytes -= size;
+        --this->usage.allocations_count;
+    }
+
+    // The lock must be held. Passes pending changes on to the account.
+    void flush_memory_usage() {
+        if (this->account != nullptr && (this->usage.pending_bytes != 0 || this->usage.pending_count != 0)) {
+            this->account->add(this->usage.pending_bytes, this->usage.pending_count);
+        }
+
+        this->usage.pending_bytes = 0;
+        this->usage.pending_count = 0;
+    }
+
+    void flush_memory_usage_if_needed() {
+        if (
+            std::abs(this->usage.pending_bytes) >= memory_usage::flush_bytes_threshold ||
+            std::abs(this->usage.pending_count) >= memory_usage::flush_count_threshold
+        ) {
+            this->flush_memory_usage();
+        }
+    }
+
+    // If pools are specified, memory blocks and stacks are returned to them instead of being deleted.
+    void free_allocated_memory(memory_pool* pool = nullptr, memory_pool* stack_pool = nullptr) noexcept {
+        if (!this->allocated_memory.empty() || !this->allocated_stacks.empty()) {
             LOG_PROGRAM_WARNING(
                 interoperation::get_module_part(), 
-                std::format("Destroyed resource container had {} dangling memory block(s).", this->allocated_memory.size())
+                "Destroyed resource container had {} dangling memory block(s).", 
+                this->allocated_memory.size() + this->allocated_stacks.size()
             );
         }
 
-        for (void* memory : this->allocated_memory) {
-            // It is guaranteed that the memory is allocated as a char array
-            delete[] static_cast<char*>(memory);
+        for (auto [memory, size] : this->allocated_memory) {
+            memory_owners.clear_owner(memory);
+
+            // It is guaranteed that the memory is allocated with allocate_raw_block
+            if (pool != nullptr) {
+                pool->release(static_cast<char*>(memory), size);
+            }
+            else {
+                free_raw_block(static_cast<char*>(memory), size);
+            }
         }
 
+        this->allocated_memory.clear();
+
+        // Stacks are not tagged in memory_owners, programs never get their addresses.
+        for (auto [stack, size] : this->allocated_stacks) {
+            if (stack_pool != nullptr) {
+                stack_pool->release(static_cast<char*>(stack), size);
+            }
+            else {
+                guarded_stack::free(static_cast<char*>(stack), size);
+            }
+        }
+
+        this->allocated_stacks.clear();
+
+        // Take everything this container was charged for back from the account.
+        this->flush_memory_usage();
+        if (this->account != nullptr) {
+            this->account->add(
+                -static_cast<std::int64_t>(this->usage.allocated_bytes),
+                -static_cast<std::int64_t>(this->usage.allocations_count)
+            );
+        }
+
+        this->usage = memory_usage{};
+        this->account.reset();
+    }
+
+    virtual ~resource_container() noexcept {
+        // Calls to destroy callbacks must precede the deallocation of memory
+        this->run_destroy_callbacks();
+        this->free_allocated_memory();
+
         delete this->lock;
     }
 };
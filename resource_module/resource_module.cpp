@@ -4,6 +4,10 @@
 #include "program_container.h"
 #include "thread_structure.h"
 #include "id_generator.h"
+#include "memory_pool.h"
+#include "huge_page_arena.h"
+#include "guarded_stack.h"
+#include "page_map.h"
 #include "module_interoperation.h"
 
 #include "../logger_module/logging.h"
@@ -14,44 +18,101 @@
     #define _Releases_lock_(a)
 #endif
 
+// Defined before the registries, so that they outlive the objects that free and untag their memory on destruction.
+huge_page_arena huge_pages;
+page_map memory_owners;
+
 namespace {
-    std::map<id_generator::id_type, program_container> containers;
-    std::recursive_mutex containers_mutex;
+    /*
+    * Registries of program containers and thread structures are split into shards. Each id always maps to the same shard,
+    * and every shard has its own map and mutex, so operations on unrelated objects don't contend on a single lock.
+    * Ids are generated sequentially, so their lowest bits are enough to spread them.
+    * Shards are aligned to separate cache lines to avoid false sharing between their mutexes.
+    */
+    template<typename T>
+    struct alignas(std::hardware_destructive_interference_size) registry_shard {
+        using map_type = std::map<id_generator::id_type, T>;
+
+        map_type objects;
+        std::mutex lock;
+
+        // Map nodes of destroyed objects, ready to be reused. Only thread structures are recycled, see recycle_thread_structure.
+        std::vector<typename map_type::node_type> free_nodes;
+    };
+
+    // Must be a power of two.
+    constexpr std::size_t registry_shards_count = 64;
+    static_assert(std::has_single_bit(registry_shards_count), "shards count must be a power of two");
+
+    template<typename T>
+    using registry = std::array<registry_shard<T>, registry_shards_count>;
 
-    std::map<id_generator::id_type, thread_structure> thread_structures;
-    std::recursive_mutex thread_structures_mutex;
+    registry<program_container> containers;
+    registry<thread_structure> thread_structures;
 
     template<typename T>
-    _Acquires_lock_(return.second) auto get_iterator(T& object, std::recursive_mutex& mutex, id_generator::id_type id) {
+    registry_shard<T>& get_shard(registry<T>& objects, id_generator::id_type id) {
+        return objects[id & (registry_shards_count - 1)];
+    }
+
+    /*
+    * Threads are created and destroyed all the time, so instead of going to the allocator every time,
+    * we recycle thread memory (thread states, stacks, memory descriptors) and the map nodes of the thread structures.
+    * Both pools are bounded, everything above the limits is freed as usual.
+    */
+
+    constexpr std::size_t max_pooled_thread_memory_blocks_per_size = 1024;
+    constexpr std::uint64_t max_pooled_thread_memory_bytes = 256ull * 1024 * 1024;
+    memory_pool thread_memory_pool{ max_pooled_thread_memory_blocks_per_size, max_pooled_thread_memory_bytes };
+
+    // Thread stacks with guard regions are separate reservations of address space, see guarded_stack.h.
+    constexpr std::size_t max_pooled_thread_stacks_per_size = 1024;
+    constexpr std::uint64_t max_pooled_thread_stacks_bytes = 256ull * 1024 * 1024;
+    memory_pool thread_stack_pool{ 
+        max_pooled_thread_stacks_per_size, 
+        max_pooled_thread_stacks_bytes, 
+        &guarded_stack::allocate, 
+        &guarded_stack::free 
+    };
+
+    constexpr std::size_t max_pooled_thread_structures_per_shard = 1024 / registry_shards_count;
+
+    void recycle_thread_structure(registry_shard<thread_structure>& shard, registry_shard<thread_structure>::map_type::node_type node) {
         /*
-        * Here we at first lock mutex associated with a map,
-        * look for an object, lock mutex associated with an object,
-        * release mutex associated with a map, modify our object,
-        * release mutex associated with an object.
-        *
-        * std::map does not invalidate iterators,
-        * so even if some thread deletes another object while we modify a current object, nothing will happen.
-        *
-        * A running object can not be deleted, but even if someone tries to do so,
-        * nothing will happen until the lock to an object is released or object.end() will be returned.
+        * The node is already out of the map, so nobody can reach it anymore:
+        * 1. Run destroy callbacks. They must precede the deallocation of memory.
+        * 2. Return the remaining memory and stacks to the pools.
+        * 3. Put the node aside so that the next created thread can reuse it together with its lock.
         */
 
-        std::scoped_lock lock{ mutex };
+        thread_structure& structure = node.mapped();
+        structure.run_destroy_callbacks();
+        structure.free_allocated_memory(&thread_memory_pool, &thread_stack_pool);
+        structure.program_container = std::size_t{};
+
+        std::scoped_lock lock{ shard.lock };
+        if (shard.free_nodes.size() < max_pooled_thread_structures_per_shard) {
+            shard.free_nodes.push_back(std::move(node));
+        }
+    }
 
-        auto iterator = object.find(id);
-        if (iterator != object.end()) {
+    // The lock of the shard must be held by the caller.
+    template<typename T>
+    _Acquires_lock_(return.second) auto find_object(registry_shard<T>& shard, id_generator::id_type id) {
+        auto iterator = shard.objects.find(id);
+        if (iterator != shard.objects.end()) {
             std::unique_lock object_lock{ *iterator->second.lock };
             return std::pair{ iterator, std::move(object_lock) };
         }
 
         LOG_WARNING(
             interoperation::get_module_part(),
-            std::format("Object with ID {} does not exist.", id)
+            "Object with ID {} does not exist.", id
         );
 
         return
             std::pair{
-                object.end(), // Won't be actually accessed anywhere in the program because map can be modified after this function.
+                shard.objects.end(), // Won't be actually accessed anywhere in the program because map can be modified after this function.
                 std::unique_lock<
                     std::remove_reference_t<
                         decltype(*iterator->second.lock)
@@ -60,31 +121,175 @@ namespace {
         };
     }
 
+    template<typename T>
+    _Acquires_lock_(return.second) auto get_iterator(registry<T>& objects, id_generator::id_type id) {
+        /*
+        * Here we at first lock mutex associated with a shard,
+        * look for an object, lock mutex associated with an object,
+        * release mutex associated with a shard, modify our object,
+        * release mutex associated with an object.
+        *
+        * std::map does not invalidate iterators,
+        * so even if some thread deletes another object while we modify a current object, nothing will happen.
+        *
+        * A running object can not be deleted, but even if someone tries to do so,
+        * nothing will happen until the lock to an object is released or object.end() will be returned.
+        *
+        * Shard mutexes are not recursive: nothing that is done while holding one may lock a shard of the same registry.
+        */
+
+        registry_shard<T>& shard = get_shard(objects, id);
+        std::scoped_lock lock{ shard.lock };
+
+        return find_object(shard, id);
+    }
+
     template<typename T>
     void add_destroy_callback_generic(
-        std::recursive_mutex& mutex, 
-        T& object, 
+        registry<T>& objects, 
         id_generator::id_type id, 
         module_mediator::callback_bundle* bundle
     ) {
-        auto iterator_lock = get_iterator(object, mutex, id);
+        // Resolve the callback before taking any locks, it is a search by name.
+        std::optional<destroy_callback> callback = destroy_callback::resolve(bundle);
+        if (!callback.has_value()) {
+            return;
+        }
+
+        auto iterator_lock = get_iterator(objects, id);
         if (iterator_lock.second) {
-            iterator_lock.first->second.destroy_callbacks.push_back(bundle);
+            iterator_lock.first->second.destroy_callbacks.push_back(*callback);
         }
         else {
             LOG_PROGRAM_WARNING(
                 interoperation::get_module_part(),
-                std::format(
-                    "Concurrency error: failed to add destroy callback for an object with id {}. It no longer exists.", 
-                    id
-                )
+                "Concurrency error: failed to add destroy callback for an object with id {}. It no longer exists.", 
+                id
+            );
+        }
+    }
+
+    // The lock of the object must be held. Returns false if the allocation would exceed the memory quota.
+    template<typename T>
+    bool charge_allocation(T& object, id_generator::id_type id, std::uint64_t size) {
+        if (!object.charge_memory(size)) {
+            LOG_PROGRAM_WARNING(
+                interoperation::get_module_part(),
+                "Allocation of {} bytes for an object with id {} exceeds the memory quota.",
+                size,
+                id
             );
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // The lock of the object must be held. Returns nullptr if memory can't be allocated.
+    template<typename T>
+    char* allocate_block(T& object, id_generator::id_type id, std::uint64_t size, memory_pool* pool) {
+        if (!charge_allocation(object, id, size)) {
+            return nullptr;
+        }
+
+        char* memory = pool != nullptr ? pool->acquire(size) : allocate_raw_block(size);
+        if (memory == nullptr) {
+            object.uncharge_memory(size);
+            return nullptr;
+        }
+
+        // Memory that can't be verified is useless for the program.
+        if (!memory_owners.set_owner(memory, id_generator::get_index(id))) {
+            if (pool != nullptr) {
+                pool->release(memory, size);
+            }
+            else {
+                free_raw_block(memory, size);
+            }
+
+            object.uncharge_memory(size);
+            return nullptr;
+        }
+
+        [[maybe_unused]] auto [result, is_new] = object.allocated_memory.emplace(
+            static_cast<void*>(memory),
+            size
+        );
+
+        assert(is_new && "allocated memory already exists for this object");
+        return memory;
+    }
+
+    // The lock of the object must be held. Returns nullptr if the stack can't be allocated.
+    // Stacks are not tagged in memory_owners: programs never get their addresses, so they are never verified.
+    template<typename T>
+    char* allocate_stack(T& object, id_generator::id_type id, std::uint64_t size) {
+        if (!charge_allocation(object, id, size)) {
+            return nullptr;
+        }
+
+        char* stack = thread_stack_pool.acquire(size);
+        if (stack == nullptr) {
+            object.uncharge_memory(size);
+            return nullptr;
+        }
+
+        [[maybe_unused]] auto [result, is_new] = object.allocated_stacks.emplace(
+            static_cast<void*>(stack),
+            size
+        );
+
+        assert(is_new && "allocated stack already exists for this object");
+        return stack;
+    }
+
+    // The lock of the object must be held. Returns false if the address does not belong to the object.
+    template<typename T>
+    bool release_stack(T& object, void* address) {
+        auto found_stack = object.allocated_stacks.find(address);
+        if (found_stack == object.allocated_stacks.end()) {
+            return false;
+        }
+
+        object.uncharge_memory(found_stack->second);
+        thread_stack_pool.release(static_cast<char*>(found_stack->first), found_stack->second);
+
+        object.allocated_stacks.erase(found_stack);
+        return true;
+    }
+
+    // The lock of the object must be held. Returns false if the address does not belong to the object.
+    // Stacks are released here as well, so that they can be freed with deallocate_thread_memory.
+    template<typename T>
+    bool release_block(T& object, void* address, memory_pool* pool) {
+        auto& allocated_memory = object.allocated_memory;
+        auto found_address = allocated_memory.find(address);
+        if (found_address == allocated_memory.end()) {
+            return release_stack(object, address);
+        }
+
+        memory_owners.clear_owner(found_address->first);
+        object.uncharge_memory(found_address->second);
+        if (pool != nullptr) {
+            pool->release(static_cast<char*>(found_address->first), found_address->second);
         }
+        else {
+            free_raw_block(static_cast<char*>(found_address->first), found_address->second);
+        }
+
+        allocated_memory.erase(found_address);
+        return true;
     }
 
     template<typename T>
-    std::uintptr_t allocate_memory_generic(std::recursive_mutex& mutex, T& object, id_generator::id_type id, std::uint64_t size) {
-        auto iterator_lock = get_iterator(object, mutex, id);
+    std::uintptr_t allocate_memory_generic(
+        registry<T>& objects, 
+        id_generator::id_type id, 
+        std::uint64_t size, 
+        memory_pool* pool = nullptr
+    ) {
+        auto iterator_lock = get_iterator(objects, id);
 
         /*
         * In theory, this operation should always be successful
@@ -94,83 +299,138 @@ namespace {
         */
 
         if (iterator_lock.second) { // Check if we acquired mutex for an object.
-            [[maybe_unused]] auto [result, is_new] = iterator_lock.first->second.allocated_memory.insert(
-                static_cast<void*>(new(std::nothrow) char[size] {})
-            );
-
-            assert(is_new && "allocated memory already exists for this object");
-            return reinterpret_cast<std::uintptr_t>(*result);
+            return reinterpret_cast<std::uintptr_t>(allocate_block(iterator_lock.first->second, id, size, pool));
         }
 
         LOG_PROGRAM_WARNING(
             interoperation::get_module_part(), 
-            std::format(
-                "Concurrency error: failed to allocate memory for an object with id {}. It no longer exists.",
-                id
-            )
+            "Concurrency error: failed to allocate memory for an object with id {}. It no longer exists.",
+            id
         );
 
         return reinterpret_cast<std::uintptr_t>(nullptr);
         _Releases_lock_(iterator_lock->second);
     }
 
+    // Allocates up to "count" blocks of the same size while holding the lock of the object once.
+    // Stops at the first failed allocation. Returns the number of allocated blocks, they are written to the beginning of "blocks".
     template<typename T>
-    void deallocate_memory_generic(std::recursive_mutex& mutex, T& object, id_generator::id_type id, void* address) {
+    std::uint64_t allocate_many_memory_generic(
+        registry<T>& objects,
+        id_generator::id_type id,
+        std::uint64_t count,
+        std::uint64_t size,
+        void** blocks,
+        memory_pool* pool = nullptr
+    ) {
         // See allocate_memory_generic.
-        auto iterator_lock = get_iterator(object, mutex, id);
-        if (iterator_lock.second) {
-            auto& allocated_memory = iterator_lock.first->second.allocated_memory;
-            auto found_address = allocated_memory.find(address);
+        auto iterator_lock = get_iterator(objects, id);
+        if (!iterator_lock.second) {
+            LOG_PROGRAM_WARNING(
+                interoperation::get_module_part(), 
+                "Concurrency error: failed to allocate memory for an object with id {}. It no longer exists.",
+                id
+            );
 
-            // If address does not belong to this structure we do nothing
-            if (found_address != allocated_memory.end()) {
-                delete[] static_cast<char*>(*found_address);
-                allocated_memory.erase(found_address);
+            return 0;
+        }
+
+        std::uint64_t allocated_count = 0;
+        for (; allocated_count < count; ++allocated_count) {
+            char* memory = allocate_block(iterator_lock.first->second, id, size, pool);
+            if (memory == nullptr) {
+                break;
             }
-            else {
+
+            blocks[allocated_count] = memory;
+        }
+
+        return allocated_count;
+    }
+
+    template<typename T>
+    void deallocate_memory_generic(
+        registry<T>& objects, 
+        id_generator::id_type id, 
+        void* address, 
+        memory_pool* pool = nullptr
+    ) {
+        // See allocate_memory_generic.
+        auto iterator_lock = get_iterator(objects, id);
+        if (iterator_lock.second) {
+            // If address does not belong to this structure we do nothing
+            if (!release_block(iterator_lock.first->second, address, pool)) {
                 LOG_PROGRAM_WARNING(
                     interoperation::get_module_part(), 
-                    std::format(
-                        "Deallocated memory at {} does not belong to the object with id {}.",
-                        address,
-                        id
-                    )
+                    "Deallocated memory at {} does not belong to the object with id {}.",
+                    address,
+                    id
                 );
             }
         }
         else {
             LOG_PROGRAM_WARNING(
                 interoperation::get_module_part(),
-                std::format(
-                    "Concurrency error: failed to deallocate memory for an object with id {}. It no longer exists.",
-                    id
-                )
+                "Concurrency error: failed to deallocate memory for an object with id {}. It no longer exists.",
+                id
+            );
+        }
+    }
+
+    // Analogous to deallocate_memory_generic, but holds the lock of the object once for all blocks. Null blocks are skipped.
+    template<typename T>
+    void deallocate_many_memory_generic(
+        registry<T>& objects,
+        id_generator::id_type id,
+        std::uint64_t count,
+        void* const* blocks,
+        memory_pool* pool = nullptr
+    ) {
+        auto iterator_lock = get_iterator(objects, id);
+        if (!iterator_lock.second) {
+            LOG_PROGRAM_WARNING(
+                interoperation::get_module_part(),
+                "Concurrency error: failed to deallocate memory for an object with id {}. It no longer exists.",
+                id
             );
+
+            return;
+        }
+
+        for (std::uint64_t index = 0; index < count; ++index) {
+            if (blocks[index] != nullptr && !release_block(iterator_lock.first->second, blocks[index], pool)) {
+                LOG_PROGRAM_WARNING(
+                    interoperation::get_module_part(), 
+                    "Deallocated memory at {} does not belong to the object with id {}.",
+                    blocks[index],
+                    id
+                );
+            }
         }
     }
 
     template<typename T>
     std::conditional_t<
-        std::is_same_v<T, std::map<id_generator::id_type, thread_structure>>, // For thread_structure this function also returns id of the associated program_container.
+        std::is_same_v<T, thread_structure>, // For thread_structure this function also returns id of the associated program_container.
         std::pair<module_mediator::return_value, id_generator::id_type>,
         module_mediator::return_value
     >
-        deallocate_generic(std::recursive_mutex& mutex, T& object, id_generator::id_type id) {
-        constexpr bool thread_structure_switch = std::is_same_v<T, std::map<id_generator::id_type, thread_structure>>;
+        deallocate_generic(registry<T>& objects, id_generator::id_type id) {
+        constexpr bool thread_structure_switch = std::is_same_v<T, thread_structure>;
 
         [[maybe_unused]] id_generator::id_type program_container_id = 0;
         id_generator::id_type free_id = 0;
         {
-            std::unique_lock lock{ mutex };
-            auto iterator_lock = get_iterator(object, mutex, id);
+            registry_shard<T>& shard = get_shard(objects, id);
+            std::unique_lock lock{ shard.lock };
+
+            auto iterator_lock = find_object(shard, id);
             if constexpr (!thread_structure_switch) {
-                if (iterator_lock.first->second.threads_count != 0) {
+                if (iterator_lock.second && iterator_lock.first->second.threads_count != 0) {
                     LOG_PROGRAM_WARNING(
                         interoperation::get_module_part(),
-                        std::format(
-                            "Concurrency error: failed to destroy thread group with id {}. It still has running threads.",
-                            id
-                        )
+                        "Concurrency error: failed to destroy thread group with id {}. It still has running threads.",
+                        id
                     );
 
                     return module_mediator::module_failure;
@@ -183,22 +443,22 @@ namespace {
             */
 
             if (iterator_lock.second) {
-                auto container{ std::move(iterator_lock.first->second) }; // Destructor of this class will free resources.
-
                 /*
-                * "The behavior of a program is undefined if a recursive_mutex is destroyed while still owned by some thread."
-                * https://en.cppreference.com/w/cpp/thread/recursive_mutex
+                * Nobody can wait on the lock of the object while we hold the mutex of the shard (see get_iterator),
+                * so it is safe to take the node out of the map. The object is destroyed after the shard is unlocked:
+                * destroy callbacks call other modules, and those may call back into this one.
                 */
 
                 iterator_lock.second.unlock();
-                object.erase(iterator_lock.first);
-
-                lock.unlock(); // At this point the object is deleted and if several other threads were waiting on the mutex while we were deleting the object they will find nothing.
-                free_id = id;
+                auto node = shard.objects.extract(iterator_lock.first);
 
+                lock.unlock();
                 if constexpr (thread_structure_switch) {
-                    program_container_id = container.program_container;
+                    program_container_id = node.mapped().program_container;
+                    recycle_thread_structure(shard, std::move(node));
                 }
+
+                free_id = id;
             }
         }
 
@@ -216,10 +476,8 @@ namespace {
         if constexpr (thread_structure_switch) {
             LOG_PROGRAM_WARNING(
                 interoperation::get_module_part(), 
-                std::format(
-                    "Concurrency error: failed to destroy thread with id {}.",
-                    id
-                )
+                "Concurrency error: failed to destroy thread with id {}.",
+                id
             );
 
             return std::pair{ module_mediator::module_failure, 0 };
@@ -227,55 +485,47 @@ namespace {
         else {
             LOG_PROGRAM_WARNING(
                 interoperation::get_module_part(), 
-                std::format(
-                    "Concurrency error: failed to destroy thread group with id {}.",
-                    id
-                )
+                "Concurrency error: failed to destroy thread group with id {}.",
+                id
             );
 
             return module_mediator::module_failure;
         }
     }
 
-    template<typename T>
-    module_mediator::return_value verify_memory_generic(
-        std::recursive_mutex& mutex,
-        T& object,
-        id_generator::id_type object_id, 
-        module_mediator::memory address
-    ) {
-        if (address == nullptr) {
+    /*
+    * Doesn't touch the registries: every block is tagged with the id of its owner in memory_owners.
+    * Thread structures and program containers get their ids from the same generator, and no two of them that are alive
+    * share an id index, so the index identifies the owner unambiguously.
+    */
+    module_mediator::return_value verify_memory(id_generator::id_type object_id, module_mediator::memory address) {
+        if (address == nullptr || id_generator::get_index(object_id) == page_map::no_owner) {
             return module_mediator::module_failure;
         }
 
-        auto [iterator, lock] =
-            get_iterator(object, mutex, object_id);
-
-        if (lock) {
-            if (iterator->second.allocated_memory.contains(address)) {
-                return module_mediator::module_success;
-            }
-
-            return module_mediator::module_failure;
+        if (memory_owners.get_owner(address) == id_generator::get_index(object_id)) {
+            return module_mediator::module_success;
         }
 
-        LOG_PROGRAM_WARNING(
-            interoperation::get_module_part(),
-            std::format("Object with id {} does not exist, cannot verify memory at {}.", 
-                object_id, 
-                reinterpret_cast<std::uintptr_t>(address)
-            )
-        );
-
         return module_mediator::module_failure;
     }
 
+    // Arguments of get_memory_usage.
+    constexpr module_mediator::one_byte memory_usage_scope_thread = 0;
+    constexpr module_mediator::one_byte memory_usage_scope_thread_group = 1;
+    constexpr module_mediator::one_byte memory_usage_scope_program = 2;
+
+    constexpr module_mediator::one_byte memory_usage_counter_bytes = 0;
+    constexpr module_mediator::one_byte memory_usage_counter_allocations = 1;
+
     void insert_new_container(id_generator::id_type id, program_context* context) {
         program_container new_container{};
         new_container.context = context;
+        new_container.account = std::make_shared<memory_account>(memory_quotas::thread_group, context->account);
 
-        std::scoped_lock lock{ containers_mutex };
-        containers[id] = std::move(new_container);
+        registry_shard<program_container>& shard = get_shard(containers, id);
+        std::scoped_lock lock{ shard.lock };
+        shard.objects[id] = std::move(new_container);
     }
     module_mediator::return_value notify_execution_module_new_container(
         id_generator::id_type id,
@@ -302,7 +552,6 @@ module_mediator::return_value add_container_on_destroy(module_mediator::argument
         module_mediator::arguments_string_builder::unpack<module_mediator::return_value, module_mediator::memory>(bundle);
 
     add_destroy_callback_generic(
-        containers_mutex,
         containers,
         container_id,
         static_cast<module_mediator::callback_bundle*>(callback_bundle)
@@ -316,7 +565,6 @@ module_mediator::return_value add_thread_on_destroy(module_mediator::arguments_s
         module_mediator::arguments_string_builder::unpack<module_mediator::return_value, module_mediator::memory>(bundle);
 
     add_destroy_callback_generic(
-        thread_structures_mutex,
         thread_structures,
         thread_id,
         static_cast<module_mediator::callback_bundle*>(callback_bundle)
@@ -330,31 +578,34 @@ module_mediator::return_value duplicate_container(module_mediator::arguments_str
         module_mediator::arguments_string_builder::unpack<id_generator::id_type, module_mediator::memory>(bundle);
 
     auto [iterator, lock] =
-        get_iterator(containers, containers_mutex, container_id);
+        get_iterator(containers, container_id);
 
     if (lock) {
+        program_context* context = program_context::duplicate(iterator->second.context);
+        std::uint64_t preferred_stack_size = context->preferred_stack_size;
+
+        /*
+        * Unlock before inserting: the new container may land in the same shard,
+        * and someone may be holding that shard while waiting for the lock of this container.
+        */
+
+        lock.unlock();
+
         id_generator::id_type new_container_id = id_generator::get_id();
-        insert_new_container(
-            new_container_id,
-            program_context::duplicate(iterator->second.context)
-        );
+        insert_new_container(new_container_id, context);
 
-        lock.unlock(); // unlock before doing logging
         LOG_PROGRAM_INFO(interoperation::get_module_part(), "Duplicating the program context.");
-
         return notify_execution_module_new_container(
             new_container_id,
             main_function,
-            iterator->second.context->preferred_stack_size
+            preferred_stack_size
         );
     }
 
     LOG_PROGRAM_WARNING(
         interoperation::get_module_part(),
-        std::format(
-            "Concurrency error: failed to duplicate container with id {}.", 
-            container_id
-        )
+        "Concurrency error: failed to duplicate container with id {}.", 
+        container_id
     );
 
     return module_mediator::module_failure;
@@ -366,7 +617,7 @@ module_mediator::return_value get_preferred_stack_size(module_mediator::argument
         module_mediator::arguments_string_builder::unpack<id_generator::id_type>(bundle);
 
     auto [iterator, lock] =
-        get_iterator(containers, containers_mutex, container_id);
+        get_iterator(containers, container_id);
 
     if (lock) {
         return iterator->second.context->preferred_stack_size;
@@ -374,11 +625,9 @@ module_mediator::return_value get_preferred_stack_size(module_mediator::argument
 
     LOG_PROGRAM_WARNING(
         interoperation::get_module_part(),
-        std::format(
-            "Thread group with id {} no longer exists. Using a fallback stack size of {}.", 
-            container_id, 
-            fallback_stack_size
-        )
+        "Thread group with id {} no longer exists. Using a fallback stack size of {}.", 
+        container_id, 
+        fallback_stack_size
     );
 
     return fallback_stack_size;
@@ -439,14 +688,26 @@ module_mediator::return_value create_new_thread(module_mediator::arguments_strin
 
     { // Make sure the lock is gone before calling to another module.
         auto [iterator, lock] = 
-            get_iterator(containers, containers_mutex, container_id);
+            get_iterator(containers, container_id);
 
         if (lock) {
             assert(iterator->first == container_id && "unexpected container id");
 
             {
-                std::scoped_lock threads_lock{ thread_structures_mutex };
-                thread_structures[id] = thread_structure{ iterator->first };
+                registry_shard<thread_structure>& shard = get_shard(thread_structures, id);
+                std::scoped_lock threads_lock{ shard.lock };
+                if (!shard.free_nodes.empty()) {
+                    auto node = std::move(shard.free_nodes.back());
+                    shard.free_nodes.pop_back();
+
+                    node.key() = id;
+                    node.mapped().program_container = iterator->first;
+                    node.mapped().account = iterator->second.account;
+                    shard.objects.insert(std::move(node));
+                }
+                else {
+                    shard.objects[id] = thread_structure{ iterator->first, iterator->second.account };
+                }
             }
 
             preferred_stack_size = iterator->second.context->preferred_stack_size;
@@ -455,10 +716,8 @@ module_mediator::return_value create_new_thread(module_mediator::arguments_strin
         else {
             LOG_PROGRAM_WARNING(
                 interoperation::get_module_part(),
-                std::format(
-                    "Concurrency error: failed to create thread in container with id {}. It no longer exists.",
-                    container_id
-                )
+                "Concurrency error: failed to create thread in container with id {}. It no longer exists.",
+                container_id
             );
 
             return module_mediator::module_failure;
@@ -483,21 +742,74 @@ module_mediator::return_value allocate_program_memory(module_mediator::arguments
     auto [container_id, memory_size] =
         module_mediator::arguments_string_builder::unpack<id_generator::id_type, std::uint64_t>(bundle);
 
-    return allocate_memory_generic(containers_mutex, containers, container_id, memory_size);
+    return allocate_memory_generic(containers, container_id, memory_size);
 }
 
 module_mediator::return_value allocate_thread_memory(module_mediator::arguments_string_type bundle) {
     auto [thread_id, memory_size] =
         module_mediator::arguments_string_builder::unpack<id_generator::id_type, std::uint64_t>(bundle);
 
-    return allocate_memory_generic(thread_structures_mutex, thread_structures, thread_id, memory_size);
+    return allocate_memory_generic(thread_structures, thread_id, memory_size, &thread_memory_pool);
+}
+
+module_mediator::return_value allocate_thread_stack(module_mediator::arguments_string_type bundle) {
+    auto [thread_id, stack_size] =
+        module_mediator::arguments_string_builder::unpack<id_generator::id_type, std::uint64_t>(bundle);
+
+    // Large pages can't be left uncommitted, so stacks that the arena serves don't get a guard region (see get_stack_guard_size).
+    if (huge_pages.serves(stack_size)) {
+        return allocate_memory_generic(thread_structures, thread_id, stack_size, &thread_memory_pool);
+    }
+
+    auto iterator_lock = get_iterator(thread_structures, thread_id);
+    if (iterator_lock.second) {
+        return reinterpret_cast<std::uintptr_t>(allocate_stack(iterator_lock.first->second, thread_id, stack_size));
+    }
+
+    LOG_PROGRAM_WARNING(
+        interoperation::get_module_part(),
+        "Concurrency error: failed to allocate stack for a thread with id {}. It no longer exists.",
+        thread_id
+    );
+
+    return reinterpret_cast<std::uintptr_t>(nullptr);
+}
+
+module_mediator::return_value get_stack_guard_size(module_mediator::arguments_string_type) {
+    // Programs may rely on the guard region only if every stack has one.
+    if (huge_pages.is_enabled()) {
+        return 0;
+    }
+
+    return guarded_stack::guard_size;
+}
+
+module_mediator::return_value allocate_program_memory_many(module_mediator::arguments_string_type bundle) {
+    auto [container_id, blocks_count, memory_size, blocks] =
+        module_mediator::arguments_string_builder::unpack<id_generator::id_type, std::uint64_t, std::uint64_t, module_mediator::memory>(bundle);
+
+    return allocate_many_memory_generic(containers, container_id, blocks_count, memory_size, static_cast<void**>(blocks));
+}
+
+module_mediator::return_value allocate_thread_memory_many(module_mediator::arguments_string_type bundle) {
+    auto [thread_id, blocks_count, memory_size, blocks] =
+        module_mediator::arguments_string_builder::unpack<id_generator::id_type, std::uint64_t, std::uint64_t, module_mediator::memory>(bundle);
+
+    return allocate_many_memory_generic(
+        thread_structures, 
+        thread_id, 
+        blocks_count, 
+        memory_size, 
+        static_cast<void**>(blocks), 
+        &thread_memory_pool
+    );
 }
 
 module_mediator::return_value deallocate_program_memory(module_mediator::arguments_string_type bundle) {
     auto [container_id, memory_address] = 
         module_mediator::arguments_string_builder::unpack<id_generator::id_type, module_mediator::memory>(bundle);
 
-    deallocate_memory_generic(containers_mutex, containers, container_id, memory_address);
+    deallocate_memory_generic(containers, container_id, memory_address);
     return module_mediator::module_success;
 }
 
@@ -505,7 +817,62 @@ module_mediator::return_value deallocate_thread_memory(module_mediator::argument
     auto [thread_id, memory_address] = 
         module_mediator::arguments_string_builder::unpack<id_generator::id_type, module_mediator::memory>(bundle);
 
-    deallocate_memory_generic(thread_structures_mutex, thread_structures, thread_id, memory_address);
+    deallocate_memory_generic(thread_structures, thread_id, memory_address, &thread_memory_pool);
+    return module_mediator::module_success;
+}
+
+module_mediator::return_value deallocate_program_memory_many(module_mediator::arguments_string_type bundle) {
+    auto [container_id, blocks_count, blocks] =
+        module_mediator::arguments_string_builder::unpack<id_generator::id_type, std::uint64_t, module_mediator::memory>(bundle);
+
+    deallocate_many_memory_generic(containers, container_id, blocks_count, static_cast<void* const*>(blocks));
+    return module_mediator::module_success;
+}
+
+module_mediator::return_value deallocate_thread_memory_many(module_mediator::arguments_string_type bundle) {
+    auto [thread_id, blocks_count, blocks] =
+        module_mediator::arguments_string_builder::unpack<id_generator::id_type, std::uint64_t, module_mediator::memory>(bundle);
+
+    deallocate_many_memory_generic(
+        thread_structures, 
+        thread_id, 
+        blocks_count, 
+        static_cast<void* const*>(blocks), 
+        &thread_memory_pool
+    );
+
+    return module_mediator::module_success;
+}
+
+module_mediator::return_value charge_program_memory(module_mediator::arguments_string_type bundle) {
+    auto [container_id, memory_size] =
+        module_mediator::arguments_string_builder::unpack<id_generator::id_type, std::uint64_t>(bundle);
+
+    auto iterator_lock = get_iterator(containers, container_id);
+    if (!iterator_lock.second) {
+        LOG_PROGRAM_WARNING(
+            interoperation::get_module_part(),
+            "Concurrency error: failed to charge memory to a thread group with id {}. It no longer exists.",
+            container_id
+        );
+
+        return module_mediator::module_failure;
+    }
+
+    return charge_allocation(iterator_lock.first->second, container_id, memory_size) ?
+        module_mediator::module_success : module_mediator::module_failure;
+}
+
+module_mediator::return_value uncharge_program_memory(module_mediator::arguments_string_type bundle) {
+    auto [container_id, memory_size] =
+        module_mediator::arguments_string_builder::unpack<id_generator::id_type, std::uint64_t>(bundle);
+
+    // A destroyed container has already given everything it was charged for back to the account.
+    auto iterator_lock = get_iterator(containers, container_id);
+    if (iterator_lock.second) {
+        iterator_lock.first->second.uncharge_memory(memory_size);
+    }
+
     return module_mediator::module_success;
 }
 
@@ -513,7 +880,7 @@ module_mediator::return_value deallocate_program_container(module_mediator::argu
     auto [container_id] = 
         module_mediator::arguments_string_builder::unpack<id_generator::id_type>(bundle);
 
-    return deallocate_generic(containers_mutex, containers, container_id);
+    return deallocate_generic(containers, container_id);
 }
 
 module_mediator::return_value deallocate_thread(module_mediator::arguments_string_type bundle) {
@@ -521,11 +888,11 @@ module_mediator::return_value deallocate_thread(module_mediator::arguments_strin
         module_mediator::arguments_string_builder::unpack<id_generator::id_type>(bundle);
 
     auto [return_code, container_id] = 
-        deallocate_generic(thread_structures_mutex, thread_structures, thread_id);
+        deallocate_generic(thread_structures, thread_id);
 
     if (return_code != module_mediator::module_failure) {
         auto [iterator, lock] = 
-            get_iterator(containers, containers_mutex, container_id);
+            get_iterator(containers, container_id);
 
         if (lock) {
             --iterator->second.threads_count;
@@ -533,10 +900,8 @@ module_mediator::return_value deallocate_thread(module_mediator::arguments_strin
         else {
             LOG_PROGRAM_WARNING(
                 interoperation::get_module_part(),
-                std::format(
-                    "Concurrency error: failed to decrease running threads count for a program container with id {}. It no longer exists.",
-                    container_id
-                )
+                "Concurrency error: failed to decrease running threads count for a program container with id {}. It no longer exists.",
+                container_id
             );
 
             return module_mediator::module_failure;
@@ -554,7 +919,7 @@ module_mediator::return_value get_running_threads_count(module_mediator::argumen
         module_mediator::arguments_string_builder::unpack<id_generator::id_type>(bundle);
 
     auto [iterator, lock] = 
-        get_iterator(containers, containers_mutex, container_id);
+        get_iterator(containers, container_id);
 
     if (lock) {
         return iterator->second.threads_count;
@@ -562,10 +927,8 @@ module_mediator::return_value get_running_threads_count(module_mediator::argumen
 
     LOG_PROGRAM_WARNING(
         interoperation::get_module_part(),
-        std::format(
-            "Concurrency error: failed to get running threads count for a program container with id {}. It no longer exists.",
-            container_id
-        )
+        "Concurrency error: failed to get running threads count for a program container with id {}. It no longer exists.",
+        container_id
     );
 
     return module_mediator::module_failure; 
@@ -576,7 +939,7 @@ module_mediator::return_value get_program_container_id(module_mediator::argument
         module_mediator::arguments_string_builder::unpack<id_generator::id_type>(bundle);
 
     auto [iterator, lock] =
-        get_iterator(thread_structures, thread_structures_mutex, thread_id);
+        get_iterator(thread_structures, thread_id);
 
     if (lock) {
         return iterator->second.program_container;
@@ -584,10 +947,8 @@ module_mediator::return_value get_program_container_id(module_mediator::argument
 
     LOG_PROGRAM_WARNING(
         interoperation::get_module_part(),
-        std::format(
-            "Concurrency error: failed to get program container id for a thread with id {}. It no longer exists.",
-            thread_id
-        )
+        "Concurrency error: failed to get program container id for a thread with id {}. It no longer exists.",
+        thread_id
     );
 
     /*
@@ -603,7 +964,7 @@ module_mediator::return_value get_jump_table(module_mediator::arguments_string_t
         module_mediator::arguments_string_builder::unpack<id_generator::id_type>(bundle);
 
     auto [iterator, lock] = 
-        get_iterator(containers, containers_mutex, container_id);
+        get_iterator(containers, container_id);
 
     if (lock) {
         return reinterpret_cast<std::uintptr_t>(iterator->second.context->jump_table);
@@ -611,10 +972,8 @@ module_mediator::return_value get_jump_table(module_mediator::arguments_string_t
 
     LOG_PROGRAM_WARNING(
         interoperation::get_module_part(),
-        std::format(
-            "Concurrency error: failed to get jump table for a program container with id {}. It no longer exists.",
-            container_id
-        )
+        "Concurrency error: failed to get jump table for a program container with id {}. It no longer exists.",
+        container_id
     );
     
     return reinterpret_cast<std::uintptr_t>(nullptr);
@@ -625,7 +984,7 @@ module_mediator::return_value get_jump_table_size(module_mediator::arguments_str
         module_mediator::arguments_string_builder::unpack<id_generator::id_type>(bundle);
 
     auto [iterator, lock] =
-        get_iterator(containers, containers_mutex, container_id);
+        get_iterator(containers, container_id);
 
     if (lock) {
         return iterator->second.context->jump_table_size;
@@ -633,10 +992,8 @@ module_mediator::return_value get_jump_table_size(module_mediator::arguments_str
 
     LOG_PROGRAM_WARNING(
         interoperation::get_module_part(),
-        std::format(
-            "Concurrency error: failed to get jump table size for a program container with id {}. It no longer exists.",
-            container_id
-        )
+        "Concurrency error: failed to get jump table size for a program container with id {}. It no longer exists.",
+        container_id
     );
 
     return module_mediator::module_failure;
@@ -646,9 +1003,7 @@ module_mediator::return_value verify_thread_memory(module_mediator::arguments_st
     auto [thread_id, memory_address] =
         module_mediator::arguments_string_builder::unpack<id_generator::id_type, module_mediator::memory>(bundle);
 
-    return verify_memory_generic(
-        thread_structures_mutex,
-        thread_structures,
+    return verify_memory(
         thread_id,
         memory_address
     );
@@ -658,21 +1013,86 @@ module_mediator::return_value verify_program_memory(module_mediator::arguments_s
     auto [container_id, memory_address] =
         module_mediator::arguments_string_builder::unpack<id_generator::id_type, module_mediator::memory>(bundle);
 
-    return verify_memory_generic(
-        containers_mutex,
-        containers,
+    return verify_memory(
         container_id,
         memory_address
     );
 }
 
+module_mediator::return_value get_memory_usage(module_mediator::arguments_string_type bundle) {
+    auto [thread_id, scope, counter] =
+        module_mediator::arguments_string_builder::unpack<id_generator::id_type, module_mediator::one_byte, module_mediator::one_byte>(bundle);
+
+    if (scope > memory_usage_scope_program || counter > memory_usage_counter_allocations) {
+        LOG_PROGRAM_WARNING(
+            interoperation::get_module_part(),
+            "Unknown memory usage scope {} or counter {}.",
+            scope,
+            counter
+        );
+
+        return module_mediator::module_failure;
+    }
+
+    memory_usage thread_usage{};
+    std::shared_ptr<memory_account> account{};
+    id_generator::id_type container_id{};
+    {
+        auto [iterator, lock] =
+            get_iterator(thread_structures, thread_id);
+
+        if (!lock) {
+            LOG_PROGRAM_WARNING(
+                interoperation::get_module_part(),
+                "Concurrency error: failed to get memory usage for a thread with id {}. It no longer exists.",
+                thread_id
+            );
+
+            return module_mediator::module_failure;
+        }
+
+        // Whatever the calling thread did is visible to it right away. Other threads may still have pending changes.
+        iterator->second.flush_memory_usage();
+
+        thread_usage = iterator->second.usage;
+        account = iterator->second.account;
+        container_id = iterator->second.program_container;
+    }
+
+    if (scope == memory_usage_scope_thread) {
+        return counter == memory_usage_counter_bytes ? thread_usage.allocated_bytes : thread_usage.allocations_count;
+    }
+
+    {
+        // Pending changes of the thread group itself. Only one object is locked at a time.
+        auto [iterator, lock] =
+            get_iterator(containers, container_id);
+
+        if (lock) {
+            iterator->second.flush_memory_usage();
+        }
+    }
+
+    if (scope == memory_usage_scope_program && account != nullptr) {
+        account = account->get_parent();
+    }
+
+    if (account == nullptr) {
+        return 0;
+    }
+
+    return counter == memory_usage_counter_bytes ? account->get_allocated_bytes() : account->get_allocations_count();
+}
+
 program_container::~program_container() noexcept {
     // execution module will make sure that there are no active threads before destroying a program container
     // this should happen only on program close (e.g. console got closed before the program is done)
     // at this point logger module may have been unloaded already, so we can only use std::cerr here
     if (this->threads_count == 0) {
-        if (this->context && this->context->decrease_references_count() == 0) {
-            delete this->context;
+        // Destroy callbacks run before the program may get unloaded by the last release of its context.
+        this->run_destroy_callbacks();
+        if (this->context) {
+            program_context::release(this->context);
         }
     }
     else {
@@ -685,7 +1105,7 @@ program_container::~program_container() noexcept {
 }
 
 program_context::~program_context() noexcept {
-    assert(this->references_count == 0 && "Destroying program context that has active references.");
+    assert(this->references_count.load(std::memory_order_relaxed) == 0 && "Destroying program context that has active references.");
     module_mediator::return_value result = module_mediator::fast_call<
         module_mediator::memory, module_mediator::memory,
         module_mediator::memory, module_mediator::four_bytes,
@@ -21,9 +21,19 @@ RESOURCEMODULE_API module_mediator::return_value create_new_thread(module_mediat
 
 RESOURCEMODULE_API module_mediator::return_value allocate_program_memory(module_mediator::arguments_string_type bundle);
 RESOURCEMODULE_API module_mediator::return_value allocate_thread_memory(module_mediator::arguments_string_type bundle);
+RESOURCEMODULE_API module_mediator::return_value allocate_program_memory_many(module_mediator::arguments_string_type bundle);
+RESOURCEMODULE_API module_mediator::return_value allocate_thread_memory_many(module_mediator::arguments_string_type bundle);
+
+RESOURCEMODULE_API module_mediator::return_value allocate_thread_stack(module_mediator::arguments_string_type bundle);
+RESOURCEMODULE_API module_mediator::return_value get_stack_guard_size(module_mediator::arguments_string_type bundle);
 
 RESOURCEMODULE_API module_mediator::return_value deallocate_program_memory(module_mediator::arguments_string_type bundle);
 RESOURCEMODULE_API module_mediator::return_value deallocate_thread_memory(module_mediator::arguments_string_type bundle);
+RESOURCEMODULE_API module_mediator::return_value deallocate_program_memory_many(module_mediator::arguments_string_type bundle);
+RESOURCEMODULE_API module_mediator::return_value deallocate_thread_memory_many(module_mediator::arguments_string_type bundle);
+
+RESOURCEMODULE_API module_mediator::return_value charge_program_memory(module_mediator::arguments_string_type bundle);
+RESOURCEMODULE_API module_mediator::return_value uncharge_program_memory(module_mediator::arguments_string_type bundle);
 
 RESOURCEMODULE_API module_mediator::return_value deallocate_program_container(module_mediator::arguments_string_type bundle);
 RESOURCEMODULE_API module_mediator::return_value deallocate_thread(module_mediator::arguments_string_type bundle);
@@ -37,6 +47,8 @@ RESOURCEMODULE_API module_mediator::return_value get_jump_table_size(module_medi
 RESOURCEMODULE_API module_mediator::return_value verify_thread_memory(module_mediator::arguments_string_type bundle);
 RESOURCEMODULE_API module_mediator::return_value verify_program_memory(module_mediator::arguments_string_type bundle);
 
+RESOURCEMODULE_API module_mediator::return_value get_memory_usage(module_mediator::arguments_string_type bundle);
+
 RESOURCEMODULE_API void initialize_m(module_mediator::module_part*);
 RESOURCEMODULE_API void free_m();
 
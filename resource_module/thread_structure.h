@@ -9,10 +9,12 @@ struct thread_structure : resource_container {
 
 	thread_structure() = default;
 
-	thread_structure(std::size_t program_container_id)
+	thread_structure(std::size_t program_container_id, std::shared_ptr<memory_account> thread_group_account)
 		:resource_container{},
 		program_container{ program_container_id }
-	{}
+	{
+		this->account = std::move(thread_group_account);
+	}
 
     thread_structure(const thread_structure& structure) = delete;
     thread_structure& operator= (const thread_structure& structure) = delete;
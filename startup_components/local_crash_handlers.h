@@ -152,6 +152,7 @@ namespace startup_components::crash_handling {
 
 namespace startup_components::crash_handling {
     inline void install_local_crash_handlers() {
+#ifdef _WIN32
         ULONG ulDesiredStackSize = 262144;
         BOOL bResult = SetThreadStackGuarantee(&ulDesiredStackSize);
         if (!bResult) {
@@ -160,6 +161,7 @@ namespace startup_components::crash_handling {
                                                      "guarantee for thread {}. This may impede some types "
                                                      "of fatal error reporting.", GetCurrentThreadId());
         }
+#endif
 
         std::terminate_handler terminate_old = std::set_terminate(notify_fatal_termination);
         if (terminate_old != &notify_fatal_termination) {